@@ -0,0 +1,82 @@
+/**
+ * Replay an allocation trace recorded through allocators/trace.h against one of the allocators.
+ *
+ * usage: nvstd_alloc_replay [--allocator=libc|mmap|mmap-huge] [--touch] trace.bin
+ */
+
+#include "../include/alloc.h"
+#include "../include/allocators/mmap.h"
+#include "../include/allocators/trace.h"
+#include "../include/error.h"
+#include "../include/props.h"
+#include "../include/stream.h"
+#include "../include/string.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+
+int
+main(int argc, char* argv[])
+{
+  char allocator_name[32] = "libc";
+  bool touch              = false;
+  bool help               = false;
+
+  nv_option_desc_t options[] = {
+    { .type = NV_OP_TYPE_STRING, .short_name = "a", .long_name = "allocator", .value = allocator_name, .buffer_size = sizeof(allocator_name) },
+    { .type = NV_OP_TYPE_BOOL, .short_name = "t", .long_name = "touch", .value = &touch },
+    { .type = NV_OP_TYPE_BOOL, .short_name = "h", .long_name = "help", .value = &help },
+  };
+
+  char error[256] = { 0 };
+  if (argc < 2 || nv_props_parse(argc, argv, options, nv_arrlen(options), error, sizeof(error)) != NV_SUCCESS || help || argv[argc - 1][0] == '-')
+  {
+    char usage[1024] = { 0 };
+    nv_props_generate_help_message(options, nv_arrlen(options), usage, sizeof(usage));
+    fprintf(stderr, "%s\nusage: %s [options] trace.bin\n%s", error, argv[0], usage);
+    return 1;
+  }
+
+  const char* trace_path = argv[argc - 1];
+
+  nv_allocator_t  allocator = nv_alloc_libc;
+  nv_mmap_ctx_t   mmap_ctx;
+  nv_allocator_t* fallback = &nv_alloc_libc;
+
+  if (nv_strcmp(allocator_name, "mmap") == 0) { nv_mmap_allocator_init(NV_MMAP_DEFAULT, 0, fallback, &mmap_ctx, &allocator); }
+  else if (nv_strcmp(allocator_name, "mmap-huge") == 0) { nv_mmap_allocator_init(NV_MMAP_HUGETLB | NV_MMAP_TRANSPARENT_HUGE_PAGES, 0, fallback, &mmap_ctx, &allocator); }
+  else if (nv_strcmp(allocator_name, "libc") != 0)
+  {
+    fprintf(stderr, "unknown allocator '%s', expected libc, mmap or mmap-huge\n", allocator_name);
+    return 1;
+  }
+
+  nv_stream_t* stream = NULL;
+  nv_error     e      = nv_open_fstream(trace_path, "rb", &stream);
+  if (e != NV_SUCCESS)
+  {
+    fprintf(stderr, "failed to open '%s': %s\n", trace_path, nv_error_str(e));
+    return 1;
+  }
+
+  nv_alloc_replay_result_t result;
+  e = nv_alloc_trace_replay(stream, &allocator, touch, &result);
+  nv_close_stream(stream);
+
+  if (e != NV_SUCCESS)
+  {
+    fprintf(stderr, "failed to replay '%s': %s\n", trace_path, nv_error_str(e));
+    return 1;
+  }
+
+  const size_t calls = result.allocs + result.reallocs + result.frees;
+
+  printf("allocator      : %s\n", allocator_name);
+  printf("calls          : %zu (%zu allocs, %zu reallocs, %zu frees, %zu skipped)\n", calls, result.allocs, result.reallocs, result.frees, result.skipped);
+  printf("time           : %.6f s (%.1f ns per call)\n", result.seconds, calls ? (result.seconds * 1e9) / (double)calls : 0.0);
+  printf("peak live      : %zu bytes\n", result.peak_live_bytes);
+  printf("peak rss       : %zu bytes\n", result.peak_rss_bytes);
+  printf("fragmentation  : %.3f\n", result.fragmentation);
+
+  return 0;
+}
@@ -192,6 +192,80 @@ nv_free(void* ptr)
   nv_alloc_current->free(nv_alloc_current, ptr);
 }
 
+/**
+ * Allocate through a specific allocator instead of the current one.
+ * This is what the containers use, each of them holds on to the allocator it was initialized with.
+ */
+static inline void*
+nv_alloc_zmalloc(nv_allocator_t* allocator, size_t size)
+{
+  return allocator->alloc(allocator, size);
+}
+static inline void*
+nv_alloc_realloc(nv_allocator_t* allocator, void* ptr, size_t size)
+{
+  return allocator->realloc(allocator, ptr, size);
+}
+static inline void
+nv_alloc_free(nv_allocator_t* allocator, void* ptr)
+{
+  allocator->free(allocator, ptr);
+}
+static inline void*
+nv_alloc_memdup(nv_allocator_t* allocator, const void* ptr, size_t size)
+{
+  void* allocd = allocator->alloc(allocator, size);
+  if (!allocd) return allocd;
+  return nv_memcpy(allocd, ptr, size);
+}
+static inline char*
+nv_alloc_strdup(nv_allocator_t* allocator, const char* s)
+{
+  return (char*)nv_alloc_memdup(allocator, s, nv_strlen(s) + 1);
+}
+
+/**
+ * The call site of the allocation currently in flight on this thread.
+ * file is NULL if the allocation did not go through one of the *_at() variants.
+ * Allocators that care about call sites (see allocators/stats.h) read this, everyone else can ignore it.
+ * implementation: core.c
+ */
+typedef struct nv_alloc_site
+{
+  const char* file;
+  int         line;
+} nv_alloc_site_t;
+
+extern NV_THREAD_LOCAL nv_alloc_site_t nv_alloc_current_site;
+
+static inline void*
+nv_zmalloc_at(size_t size, const char* file, int line)
+{
+  nv_alloc_current_site.file = file;
+  nv_alloc_current_site.line = line;
+  void* ptr                  = nv_alloc_current->alloc(nv_alloc_current, size);
+  nv_alloc_current_site.file = NULL;
+  return ptr;
+}
+static inline void*
+nv_realloc_at(void* ptr, size_t size, const char* file, int line)
+{
+  nv_alloc_current_site.file = file;
+  nv_alloc_current_site.line = line;
+  void* new_ptr              = nv_alloc_current->realloc(nv_alloc_current, ptr, size);
+  nv_alloc_current_site.file = NULL;
+  return new_ptr;
+}
+
+/**
+ * Define NV_ALLOC_TRACK_CALL_SITES before including any nvstd header (or globally) to
+ * have every nv_zmalloc() and nv_realloc() in the translation unit record its call site.
+ */
+#ifdef NV_ALLOC_TRACK_CALL_SITES
+#  define nv_zmalloc(size) nv_zmalloc_at(size, __FILE__, __LINE__)
+#  define nv_realloc(ptr, size) nv_realloc_at(ptr, size, __FILE__, __LINE__)
+#endif
+
 NOVA_HEADER_END
 
 #endif // NV_STD_ALLOC_H
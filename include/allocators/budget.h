@@ -0,0 +1,127 @@
+/*
+  MIT License
+
+  Copyright (c) 2025 Fouzan MD Ishaque (fouzanmdishaque@gmail.com)
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+/**
+ * An allocator that wraps another allocator and keeps its usage under a byte budget.
+ *
+ * Every block is charged its size plus a 16 byte header. Overhead of the parent allocator (and pages it keeps around)
+ * is not visible here, so leave some headroom when sizing a budget after an RSS limit.
+ *
+ * When an allocation would go over the budget, the eviction callback (if any) is called with the number of bytes
+ * that have to be released. It is expected to free blocks through the same allocator, for example by dropping the
+ * least recently used entries of a cache, and return how many bytes it released. The allocation is retried until
+ * it fits, the callback returns 0, or NV_ALLOC_BUDGET_MAX_EVICTIONS rounds have passed, in which case it fails.
+ *
+ * Allocations made from inside the callback are never evicted for, they just fail if they do not fit.
+ * When a realloc evicts, the callback must not free the block being reallocated. Such a free is logged as an error
+ * and ignored, so that the realloc can still go through.
+ * Usage is tracked with a single atomic counter, so the wrapper can be shared between threads.
+ */
+
+#ifndef NV_STD_ALLOCATORS_BUDGET_H
+#define NV_STD_ALLOCATORS_BUDGET_H
+
+#include "../alloc.h"
+#include "../atomic.h"
+#include "../error.h"
+#include "../stdafx.h"
+#include "../types.h"
+
+#include <stddef.h>
+
+NOVA_HEADER_START
+
+#ifndef NV_ALLOC_BUDGET_MAX_EVICTIONS
+#  define NV_ALLOC_BUDGET_MAX_EVICTIONS 16
+#endif
+
+typedef struct nv_alloc_budget nv_alloc_budget_t;
+
+/**
+ * Release atleast 'needed' bytes from 'budget'.
+ * Returns the number of bytes released, 0 if there is nothing left to release.
+ */
+typedef size_t (*nv_alloc_budget_evict_fn)(nv_alloc_budget_t* budget, size_t needed, void* user_data);
+
+struct nv_alloc_budget
+{
+  nv_allocator_t*          parent;
+  nv_alloc_budget_evict_fn evict;
+  void*                    user_data;
+
+  nv_atomic_size limit;
+  nv_atomic_size used;
+  nv_atomic_size peak;
+
+  nv_atomic_size evictions; // number of times the callback was called
+  nv_atomic_size failures;  // allocations that did not fit even after evicting
+};
+
+typedef struct nv_alloc_budget_usage
+{
+  size_t limit;
+  size_t used;
+  size_t available;
+  size_t peak;
+  size_t evictions;
+  size_t failures;
+} nv_alloc_budget_usage_t;
+
+/**
+ * Initialize a budget of 'limit' bytes around 'parent'. 'budget' must outlive 'allocator'.
+ * 'parent' may be NULL for NV_ALLOC_DEFAULT. 'evict' may be NULL to just fail allocations over the budget.
+ */
+nv_error nv_alloc_budget_init(nv_allocator_t* parent, size_t limit, nv_alloc_budget_evict_fn evict, void* user_data, nv_alloc_budget_t* budget, nv_allocator_t* allocator);
+
+void* nv_alloc_budget_zmalloc(nv_allocator_t* self, size_t size);
+void* nv_alloc_budget_realloc(nv_allocator_t* self, void* oldptr, size_t size);
+void  nv_alloc_budget_free(nv_allocator_t* self, void* ptr);
+
+/**
+ * Change the limit. Lowering it below the current usage does not evict anything right away,
+ * the next allocation will have to make room first.
+ */
+void nv_alloc_budget_set_limit(nv_alloc_budget_t* budget, size_t limit);
+
+/**
+ * Bytes currently charged against the budget.
+ */
+size_t nv_alloc_budget_used(const nv_alloc_budget_t* budget);
+
+/**
+ * Bytes that can still be allocated before the budget is hit. 0 if the budget is already exceeded.
+ */
+size_t nv_alloc_budget_available(const nv_alloc_budget_t* budget);
+
+/**
+ * The number of bytes a block of 'size' bytes is charged.
+ * Useful for eviction callbacks that want to report exactly what they released.
+ */
+size_t nv_alloc_budget_block_cost(size_t size);
+
+void nv_alloc_budget_usage(const nv_alloc_budget_t* budget, nv_alloc_budget_usage_t* out);
+
+NOVA_HEADER_END
+
+#endif // NV_STD_ALLOCATORS_BUDGET_H
@@ -0,0 +1,115 @@
+/*
+  MIT License
+
+  Copyright (c) 2025 Fouzan MD Ishaque (fouzanmdishaque@gmail.com)
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+/**
+ * An allocator that gets large blocks straight from the kernel through mmap().
+ * Meant for huge buffers (hashmap node arrays, multi GB lists) where TLB misses and realloc copies hurt.
+ *
+ * Every block at or above the threshold gets its own mapping, which:
+ *  - may be backed by huge pages (MAP_HUGETLB, or transparent huge pages through madvise(MADV_HUGEPAGE)).
+ *  - is grown and shrunk in place through mremap() on linux, so nv_realloc() does not copy.
+ *  - is handed straight back to the kernel with munmap() when freed.
+ * Blocks below the threshold are passed through to the fallback allocator.
+ *
+ * On platforms without mmap, every allocation is passed through to the fallback allocator.
+ */
+
+#ifndef NV_STD_ALLOCATORS_MMAP_H
+#define NV_STD_ALLOCATORS_MMAP_H
+
+#include "../alloc.h"
+#include "../error.h"
+#include "../stdafx.h"
+
+#include <stddef.h>
+
+NOVA_HEADER_START
+
+#ifndef NV_MMAP_DEFAULT_THRESHOLD
+/* Allocations smaller than this go to the fallback allocator. */
+#  define NV_MMAP_DEFAULT_THRESHOLD (256 * 1024)
+#endif
+
+#ifndef NV_MMAP_HUGE_PAGE_SIZE
+/* Size of a huge page. 2MB on x86_64 and most aarch64 kernels. */
+#  define NV_MMAP_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+#endif
+
+typedef enum nv_mmap_flags
+{
+  NV_MMAP_DEFAULT = 0,
+
+  /**
+   * Try to back mappings with preallocated huge pages (MAP_HUGETLB).
+   * This requires huge pages to be reserved by the system (vm.nr_hugepages).
+   * If the mapping fails, a regular mapping is made instead (and NV_MMAP_TRANSPARENT_HUGE_PAGES is applied to it).
+   */
+  NV_MMAP_HUGETLB = 1 << 0,
+
+  /**
+   * madvise(MADV_HUGEPAGE) every mapping that is atleast NV_MMAP_HUGE_PAGE_SIZE large.
+   * The mapping is aligned to NV_MMAP_HUGE_PAGE_SIZE so that the kernel can actually use huge pages for it.
+   */
+  NV_MMAP_TRANSPARENT_HUGE_PAGES = 1 << 1,
+} nv_mmap_flags;
+
+typedef struct nv_mmap_ctx
+{
+  /* Allocator used for the blocks smaller than 'threshold'. */
+  nv_allocator_t* fallback;
+  size_t          threshold;
+  unsigned        flags;
+} nv_mmap_ctx_t;
+
+/**
+ * Initialize an mmap allocator. 'ctx' must outlive 'allocator'.
+ * 'flags' is a combination of nv_mmap_flags.
+ * 'threshold' may be 0 for NV_MMAP_DEFAULT_THRESHOLD.
+ * 'fallback' may be NULL for NV_ALLOC_DEFAULT.
+ */
+nv_error nv_mmap_allocator_init(unsigned flags, size_t threshold, nv_allocator_t* fallback, nv_mmap_ctx_t* ctx, nv_allocator_t* allocator);
+
+void* nv_mmap_zmalloc(nv_allocator_t* self, size_t size);
+void* nv_mmap_realloc(nv_allocator_t* self, void* oldptr, size_t size);
+void  nv_mmap_free(nv_allocator_t* self, void* ptr);
+
+/**
+ * Is the block directly backed by a mapping? (as opposed to being passed to the fallback allocator)
+ */
+bool nv_mmap_is_mapped(const void* ptr);
+
+/**
+ * Get the size of the mapping that is backing the block, 0 if the block is not mapped.
+ */
+size_t nv_mmap_mapped_size(const void* ptr);
+
+/**
+ * The size of a (regular) page on this system, cached after the first call.
+ * 4096 on platforms without mmap.
+ */
+size_t nv_mmap_page_size(void);
+
+NOVA_HEADER_END
+
+#endif // NV_STD_ALLOCATORS_MMAP_H
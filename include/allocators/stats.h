@@ -0,0 +1,161 @@
+/*
+  MIT License
+
+  Copyright (c) 2025 Fouzan MD Ishaque (fouzanmdishaque@gmail.com)
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+/**
+ * An allocator that wraps another allocator and keeps statistics on it.
+ * Live bytes, peak bytes, call counts, a size histogram and optionally, per call site usage.
+ *
+ * Counters are kept in NV_ALLOC_STATS_SHARDS cache line sized shards, each thread is assigned one shard.
+ * The shards are only merged when a snapshot is requested, so threads do not fight over the same cache line.
+ * The peak is tracked by flushing each shard into a shared counter every NV_ALLOC_STATS_PEAK_GRANULARITY bytes,
+ * so it may be off by atmost NV_ALLOC_STATS_SHARDS * NV_ALLOC_STATS_PEAK_GRANULARITY bytes.
+ *
+ * Call sites are recorded for allocations made through nv_zmalloc_at() / nv_realloc_at(),
+ * or every nv_zmalloc() / nv_realloc() if NV_ALLOC_TRACK_CALL_SITES is defined.
+ *
+ * Every block is prefixed with a 16 byte header to remember its size.
+ */
+
+#ifndef NV_STD_ALLOCATORS_STATS_H
+#define NV_STD_ALLOCATORS_STATS_H
+
+#include "../alloc.h"
+#include "../atomic.h"
+#include "../error.h"
+#include "../stdafx.h"
+#include "../types.h"
+
+#include <stddef.h>
+#include <stdio.h>
+
+NOVA_HEADER_START
+
+#ifndef NV_ALLOC_STATS_SHARDS
+#  define NV_ALLOC_STATS_SHARDS 16
+#endif
+
+#ifndef NV_ALLOC_STATS_PEAK_GRANULARITY
+#  define NV_ALLOC_STATS_PEAK_GRANULARITY (64 * 1024)
+#endif
+
+#ifndef NV_ALLOC_STATS_MAX_SITES
+/* Must be a power of two. Call sites after the table fills up are counted as unknown. */
+#  define NV_ALLOC_STATS_MAX_SITES 1024
+#endif
+
+/**
+ * Bucket 0 counts 0 byte allocations, bucket i counts allocations of [2^(i-1), 2^i) bytes.
+ * The last bucket also counts everything larger.
+ */
+#define NV_ALLOC_STATS_BUCKETS 48
+
+typedef struct nv_alloc_stats_shard
+{
+  NV_ALIGN_TO(64) nv_atomic_size allocs;
+  nv_atomic_size reallocs;
+  nv_atomic_size frees;
+  nv_atomic_size bytes_allocated;
+  nv_atomic_size bytes_freed;
+  nv_atomic_long unflushed; // bytes not yet added to the peak counter
+  nv_atomic_size histogram[NV_ALLOC_STATS_BUCKETS];
+} nv_alloc_stats_shard_t;
+
+typedef struct nv_alloc_stats_site
+{
+  nv_atomic_size key; // 0 if the slot is free, file and line are valid once it is odd
+  const char*    file;
+  int            line;
+  nv_atomic_size allocs;
+  nv_atomic_size live_bytes;
+} nv_alloc_stats_site_t;
+
+typedef struct nv_alloc_stats
+{
+  nv_allocator_t* parent;
+
+  nv_alloc_stats_shard_t shards[NV_ALLOC_STATS_SHARDS];
+
+  nv_atomic_long flushed_live;
+  nv_atomic_long peak;
+
+  /* NULL if call sites are not tracked. Index 0 is reserved for unknown call sites. */
+  nv_alloc_stats_site_t* sites;
+} nv_alloc_stats_t;
+
+typedef struct nv_alloc_stats_snapshot
+{
+  size_t live_bytes;
+  size_t peak_bytes;
+  size_t live_blocks;
+  size_t allocs;
+  size_t reallocs;
+  size_t frees;
+  size_t total_bytes_allocated;
+  size_t histogram[NV_ALLOC_STATS_BUCKETS];
+} nv_alloc_stats_snapshot_t;
+
+typedef struct nv_alloc_site_stats
+{
+  const char* file; // NULL for allocations with no known call site
+  int         line;
+  size_t      allocs;
+  size_t      live_bytes;
+} nv_alloc_site_stats_t;
+
+/**
+ * Initialize a statistics wrapper around 'parent'. 'stats' must outlive 'allocator'.
+ * 'parent' may be NULL for NV_ALLOC_DEFAULT.
+ * The call site table is allocated from 'parent' if 'track_sites' is set.
+ */
+nv_error nv_alloc_stats_init(nv_allocator_t* parent, bool track_sites, nv_alloc_stats_t* stats, nv_allocator_t* allocator);
+
+/**
+ * Free the call site table. Blocks allocated through the wrapper must not be freed through it after this.
+ */
+void nv_alloc_stats_destroy(nv_alloc_stats_t* stats);
+
+void* nv_alloc_stats_zmalloc(nv_allocator_t* self, size_t size);
+void* nv_alloc_stats_realloc(nv_allocator_t* self, void* oldptr, size_t size);
+void  nv_alloc_stats_free(nv_allocator_t* self, void* ptr);
+
+/**
+ * Merge all the per thread counters into 'out'.
+ * Safe to call while other threads are allocating, the result just may not be an exact point in time.
+ */
+void nv_alloc_stats_snapshot(const nv_alloc_stats_t* stats, nv_alloc_stats_snapshot_t* out);
+
+/**
+ * Copy atmost 'max' call sites into 'out', sorted by their live bytes (largest first).
+ * Returns the number of call sites written.
+ */
+size_t nv_alloc_stats_sites(const nv_alloc_stats_t* stats, nv_alloc_site_stats_t* out, size_t max);
+
+/**
+ * Write a human readable report of the statistics, including the 'max_sites' call sites with the most live bytes.
+ */
+void nv_alloc_stats_dump(const nv_alloc_stats_t* stats, size_t max_sites, FILE* f);
+
+NOVA_HEADER_END
+
+#endif // NV_STD_ALLOCATORS_STATS_H
@@ -0,0 +1,126 @@
+/*
+  MIT License
+
+  Copyright (c) 2025 Fouzan MD Ishaque (fouzanmdishaque@gmail.com)
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+/**
+ * Allocation trace recording and replaying.
+ *
+ * The recorder is an allocator that wraps another allocator and writes every alloc, realloc and free to a stream.
+ * A recorded trace can then be replayed against any allocator to compare them on the real allocation pattern.
+ *
+ * Trace format:
+ *  "NVAT" followed by a version byte.
+ *  Then one record per call: an op byte and LEB128 varints.
+ *    alloc:   'a' size new_ptr
+ *    realloc: 'r' old_ptr size new_ptr
+ *    free:    'f' ptr
+ *  Pointers are stored as the zigzag encoded difference from the previous pointer in the trace, which keeps them small.
+ *  A new_ptr of 0 (the difference is still taken) means that the call failed.
+ *
+ * The recorder takes a lock around every call so that the records stay in the same order as the calls.
+ * Calls a thread makes through a recorder while it is writing a record (say, the stream growing its buffer through
+ * the traced allocator) go straight to the parent allocator and are not recorded.
+ * It is meant for capturing traces, not for production use.
+ */
+
+#ifndef NV_STD_ALLOCATORS_TRACE_H
+#define NV_STD_ALLOCATORS_TRACE_H
+
+#include "../alloc.h"
+#include "../atomic.h"
+#include "../error.h"
+#include "../stdafx.h"
+#include "../stream.h"
+#include "../types.h"
+
+#include <stddef.h>
+
+NOVA_HEADER_START
+
+#define NV_ALLOC_TRACE_VERSION 1
+
+typedef struct nv_alloc_trace
+{
+  nv_allocator_t* parent;
+  nv_stream_t*    stream;
+  nv_atomic_int   lock;
+  u64             last_ptr;
+
+  /* Number of records written. */
+  size_t records;
+} nv_alloc_trace_t;
+
+typedef struct nv_alloc_replay_result
+{
+  size_t allocs;
+  size_t reallocs;
+  size_t frees;
+
+  /* Records that referenced pointers the trace never allocated (allocated before recording started). */
+  size_t skipped;
+
+  /* Time spent in the allocator calls (and touching the memory, if asked to). */
+  double seconds;
+
+  /* The most bytes the trace had live at once. */
+  size_t peak_live_bytes;
+
+  /**
+   * The largest growth of the resident set over the replay. 0 where this can not be measured.
+   * Sampled every NV_ALLOC_REPLAY_RSS_INTERVAL calls.
+   */
+  size_t peak_rss_bytes;
+
+  /**
+   * peak_rss_bytes / peak_live_bytes.
+   * 1.0 is a perfect fit, higher means the allocator held on to more memory than the program asked for.
+   */
+  double fragmentation;
+} nv_alloc_replay_result_t;
+
+#ifndef NV_ALLOC_REPLAY_RSS_INTERVAL
+#  define NV_ALLOC_REPLAY_RSS_INTERVAL 4096
+#endif
+
+/**
+ * Initialize a trace recorder around 'parent', writing to 'stream'.
+ * The trace header is written immediately. Both 'trace' and 'stream' must outlive 'allocator'.
+ * 'parent' may be NULL for NV_ALLOC_DEFAULT.
+ */
+nv_error nv_alloc_trace_init(nv_allocator_t* parent, nv_stream_t* stream, nv_alloc_trace_t* trace, nv_allocator_t* allocator);
+
+void* nv_alloc_trace_zmalloc(nv_allocator_t* self, size_t size);
+void* nv_alloc_trace_realloc(nv_allocator_t* self, void* oldptr, size_t size);
+void  nv_alloc_trace_free(nv_allocator_t* self, void* ptr);
+
+/**
+ * Replay a trace from 'stream' against 'allocator'.
+ * The whole trace is decoded up front so that only the allocator calls are timed.
+ * If 'touch' is set, one byte in every page of each (re)allocated block is written, like a real program would.
+ * Every block still live at the end of the trace is freed (untimed).
+ */
+nv_error nv_alloc_trace_replay(nv_stream_t* stream, nv_allocator_t* allocator, bool touch, nv_alloc_replay_result_t* result);
+
+NOVA_HEADER_END
+
+#endif // NV_STD_ALLOCATORS_TRACE_H
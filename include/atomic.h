@@ -32,7 +32,8 @@
 
 NOVA_HEADER_START
 
-#if defined(__STDC_NO_ATOMICS__) || (defined(_MSC_VER) && _MSC_VER < 1900)
+// <stdatomic.h> is C11, C99 builds (like this project's) go through the compiler's builtins instead.
+#if defined(__STDC_NO_ATOMICS__) || !defined(__STDC_VERSION__) || __STDC_VERSION__ < 201112L || (defined(_MSC_VER) && _MSC_VER < 1900)
 #  define NV_NO_STD_ATOMICS
 #endif
 
@@ -44,6 +45,8 @@ typedef _Atomic(unsigned)  nv_atomic_uint;
 typedef _Atomic(long)      nv_atomic_long;
 typedef _Atomic(uintptr_t) nv_atomic_ptr;
 typedef _Atomic(bool)      nv_atomic_bool;
+typedef _Atomic(size_t)    nv_atomic_size;
+typedef _Atomic(uint64_t)  nv_atomic_u64;
 
 #  define nv_atomic_load(ptr) atomic_load(ptr)
 #  define nv_atomic_store(ptr, val) atomic_store(ptr, val)
@@ -51,8 +54,12 @@ typedef _Atomic(bool)      nv_atomic_bool;
 #  define nv_atomic_sub(ptr, val) atomic_fetch_sub(ptr, val)
 #  define nv_atomic_exchange(ptr, val) atomic_exchange(ptr, val)
 #  define nv_atomic_cas(ptr, oldval, newval) atomic_compare_exchange_strong(ptr, &(oldval), newval)
+#  define nv_atomic_cas_weak(ptr, oldval, newval) atomic_compare_exchange_weak(ptr, &(oldval), newval)
+#  define nv_atomic_or(ptr, val) atomic_fetch_or(ptr, val)
+#  define nv_atomic_and(ptr, val) atomic_fetch_and(ptr, val)
+#  define nv_atomic_load_u64(ptr) atomic_load(ptr)
 
-#else // generally only for old compilers
+#else // C99, or old compilers
 
 #  if defined(_MSC_VER)
 #    include <Windows.h>
@@ -61,6 +68,8 @@ typedef volatile unsigned long nv_atomic_uint;
 typedef volatile long          nv_atomic_long;
 typedef volatile bool          nv_atomic_bool;
 typedef void*                  nv_atomic_ptr;
+typedef volatile size_t        nv_atomic_size;
+typedef volatile LONG64        nv_atomic_u64;
 
 #    define nv_atomic_load(ptr) InterlockedCompareExchange(ptr, 0, 0)
 #    define nv_atomic_store(ptr, val) InterlockedExchange(ptr, val)
@@ -68,6 +77,11 @@ typedef void*                  nv_atomic_ptr;
 #    define nv_atomic_sub(ptr, val) InterlockedAdd(ptr, -(val))
 #    define nv_atomic_exchange(ptr, val) InterlockedExchange(ptr, val)
 #    define nv_atomic_cas(ptr, oldval, newval) (InterlockedCompareExchange(ptr, newval, oldval) == (oldval))
+#    define nv_atomic_cas_weak(ptr, oldval, newval) nv_atomic_cas(ptr, oldval, newval)
+// 64 bit, for nv_atomic_u64
+#    define nv_atomic_or(ptr, val) ((uint64_t)InterlockedOr64(ptr, (LONG64)(val)))
+#    define nv_atomic_and(ptr, val) ((uint64_t)InterlockedAnd64(ptr, (LONG64)(val)))
+#    define nv_atomic_load_u64(ptr) ((uint64_t)InterlockedCompareExchange64(ptr, 0, 0))
 
 #  elif defined(__GNUC__) || defined(__clang__)
 typedef volatile int      nv_atomic_int;
@@ -75,13 +89,19 @@ typedef volatile unsigned nv_atomic_uint;
 typedef volatile long     nv_atomic_long;
 typedef volatile void*    nv_atomic_ptr;
 typedef volatile bool     nv_atomic_bool;
+typedef volatile size_t   nv_atomic_size;
+typedef volatile uint64_t nv_atomic_u64;
 
 #    define nv_atomic_load(ptr) __atomic_load_n(ptr, __ATOMIC_SEQ_CST)
 #    define nv_atomic_store(ptr, val) __atomic_store_n(ptr, val, __ATOMIC_SEQ_CST)
 #    define nv_atomic_add(ptr, val) __atomic_fetch_add(ptr, val, __ATOMIC_SEQ_CST)
 #    define nv_atomic_sub(ptr, val) __atomic_fetch_sub(ptr, val, __ATOMIC_SEQ_CST)
 #    define nv_atomic_exchange(ptr, val) __atomic_exchange_n(ptr, val, __ATOMIC_SEQ_CST)
-#    define nv_atomic_cas(ptr, oldval, newval) __atomic_compare_exchange_n(ptr, &(oldval), 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)
+#    define nv_atomic_cas(ptr, oldval, newval) __atomic_compare_exchange_n(ptr, &(oldval), newval, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)
+#    define nv_atomic_cas_weak(ptr, oldval, newval) __atomic_compare_exchange_n(ptr, &(oldval), newval, 1, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)
+#    define nv_atomic_or(ptr, val) __atomic_fetch_or(ptr, val, __ATOMIC_SEQ_CST)
+#    define nv_atomic_and(ptr, val) __atomic_fetch_and(ptr, val, __ATOMIC_SEQ_CST)
+#    define nv_atomic_load_u64(ptr) __atomic_load_n(ptr, __ATOMIC_SEQ_CST)
 
 #  else
 #    error "No atomic support on this platform."
@@ -0,0 +1,103 @@
+/*
+  MIT License
+
+  Copyright (c) 2025 Fouzan MD Ishaque (fouzanmdishaque@gmail.com)
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+/**
+ * Analytics kernels over lists of records: group-by aggregation and hash joins.
+ *
+ * Records are plain structs stored in an nv_list_t. Keys are 'key_size' bytes found at an offset in every record
+ * (use offsetof()) and are compared byte for byte, so padding inside a key must be zeroed.
+ */
+
+#ifndef NV_STD_CONTAINERS_ANALYTICS_H
+#define NV_STD_CONTAINERS_ANALYTICS_H
+
+#include "../error.h"
+#include "../stdafx.h"
+#include "../types.h"
+#include "list.h"
+#include "sort.h"
+
+#include <stddef.h>
+
+NOVA_HEADER_START
+
+#ifndef NV_JOIN_PARTITION_BYTES
+/**
+ * Hash joins split both sides in to partitions whose hash tables are about this large, so that building and probing
+ * a partition stays in the L2 cache.
+ */
+#  define NV_JOIN_PARTITION_BYTES (256 * 1024)
+#endif
+
+/**
+ * An aggregated value. Which member is used depends on the value's type:
+ * 'i' for NV_SORT_KEY_I32/I64, 'u' for NV_SORT_KEY_U32/U64 and 'f' for NV_SORT_KEY_F32/F64.
+ */
+typedef union nv_agg_value
+{
+  i64 i;
+  u64 u;
+  f64 f;
+} nv_agg_value;
+
+typedef struct nv_group
+{
+  size_t       count;
+  nv_agg_value sum; // integer sums wrap around
+  nv_agg_value min;
+  nv_agg_value max;
+} nv_group_t;
+
+/**
+ * Group the records in 'records' by their key and aggregate the value of type 'value_type' at 'value_offset'.
+ * 'keys' (type size 'key_size') and 'groups' (type size sizeof(nv_group_t)) must be initialized, their contents
+ * are replaced: keys[i] is the key of groups[i], in the order the keys first appear in 'records'.
+ * Groups are looked up in an nv_hashmap_t allocated through the allocator of 'groups', which only allocates per group,
+ * not per record.
+ */
+nv_error nv_list_group_by(const nv_list_t* records, size_t key_offset, size_t key_size, size_t value_offset, nv_sort_key value_type, nv_list_t* keys, nv_list_t* groups);
+
+/**
+ * A matching pair of rows from a join.
+ */
+typedef struct nv_join_pair
+{
+  size_t left;
+  size_t right;
+} nv_join_pair_t;
+
+/**
+ * Inner equi-join of 'left' and 'right' on the 'key_size' byte keys at 'left_key_offset' and 'right_key_offset'.
+ * Every pair of rows with equal keys is stored in 'pairs' (type size sizeof(nv_join_pair_t)), replacing its contents.
+ * The order of the pairs is unspecified.
+ *
+ * The hash table is built on the smaller side. Both sides are first radix partitioned by their key's hash
+ * (see NV_JOIN_PARTITION_BYTES), then each partition is built and probed on its own.
+ * Scratch memory comes from the allocator of 'pairs'.
+ */
+nv_error nv_list_hash_join(const nv_list_t* left, size_t left_key_offset, const nv_list_t* right, size_t right_key_offset, size_t key_size, nv_list_t* pairs);
+
+NOVA_HEADER_END
+
+#endif // NV_STD_CONTAINERS_ANALYTICS_H
@@ -0,0 +1,120 @@
+/*
+  MIT License
+
+  Copyright (c) 2025 Fouzan MD Ishaque (fouzanmdishaque@gmail.com)
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+/**
+ * A bitset that many threads can change at once, and a lock-free slot allocator built on it.
+ *
+ * nv_atomic_bitset_t is a fixed size array of nv_atomic_u64 words, bits are set and cleared with one atomic
+ * fetch-or/fetch-and on their word, so every change is visible as a whole and returns what the bit was before.
+ *
+ * nv_slot_allocator_t hands out the indices 0 .. slot_count - 1. It is a hierarchy of atomic bitsets:
+ * level 0 has a bit per slot (set when claimed), and each level above it a bit per word of the level below,
+ * set when that word is full. The top level is a single word, so there are ceil(log64(slot_count)) levels
+ * above the slots: two for up to 262144 slots, three for up to 16M.
+ *
+ * Claiming walks down from the top to the first word that is not full and sets a clear bit in it with fetch-or,
+ * O(log64 n) and no locks. The summary bits are updated after the slot bits, a claim that reaches a full word
+ * because of that fixes the summary and starts over. Releasing clears the slot bit, and the summary bit if the
+ * word was full.
+ */
+
+#ifndef NV_STD_CONTAINERS_ATOMIC_BITSET_H
+#define NV_STD_CONTAINERS_ATOMIC_BITSET_H
+
+#include "../alloc.h"
+#include "../atomic.h"
+#include "../error.h"
+#include "../stdafx.h"
+#include "../types.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+NOVA_HEADER_START
+
+typedef struct nv_atomic_bitset
+{
+  nv_atomic_u64*  data;
+  size_t          size;  // number of bits
+  size_t          words; // number of words in data
+  nv_allocator_t* alloc;
+} nv_atomic_bitset_t;
+
+/**
+ * 'init_capacity' is the number of bits, every bit starts clear.
+ * Initializing and destroying are not thread safe, everything else is.
+ */
+nv_error nv_atomic_bitset_init(size_t init_capacity, nv_atomic_bitset_t* set);
+
+/**
+ * Same as nv_atomic_bitset_init(), but the words are allocated through 'allocator'.
+ * 'allocator' may be NULL for the default allocator. It must outlive the set.
+ */
+nv_error nv_atomic_bitset_init_with_allocator(size_t init_capacity, nv_allocator_t* allocator, nv_atomic_bitset_t* set);
+void     nv_atomic_bitset_destroy(nv_atomic_bitset_t* set);
+
+/**
+ * Set or clear a bit, returning its previous value.
+ * A set that returns false (or a clear that returns true) is the one that changed the bit, so these double as try-locks.
+ */
+bool nv_atomic_bitset_set_bit(nv_atomic_bitset_t* set, size_t bitindex);
+bool nv_atomic_bitset_clear_bit(nv_atomic_bitset_t* set, size_t bitindex);
+bool nv_atomic_bitset_access_bit(const nv_atomic_bitset_t* set, size_t bitindex);
+
+/**
+ * The number of set bits. Each word is read atomically, but not all of them at the same moment.
+ */
+size_t nv_atomic_bitset_popcount(const nv_atomic_bitset_t* set);
+
+#define NV_SLOT_ALLOCATOR_MAX_LEVELS 7 // up to 64^7 slots
+#define NV_SLOT_NONE SIZE_MAX
+
+typedef struct nv_slot_allocator
+{
+  // levels[0] has a bit per slot, levels[level_count - 1] is a single word.
+  nv_atomic_bitset_t levels[NV_SLOT_ALLOCATOR_MAX_LEVELS];
+  size_t             level_count;
+  size_t             slot_count;
+} nv_slot_allocator_t;
+
+/**
+ * All slots start free. 'allocator' may be NULL for the default allocator.
+ */
+nv_error nv_slot_allocator_init(size_t slot_count, nv_allocator_t* allocator, nv_slot_allocator_t* slots);
+void     nv_slot_allocator_destroy(nv_slot_allocator_t* slots);
+
+/**
+ * Claim a free slot and return its index, or NV_SLOT_NONE if every slot is claimed.
+ * Lower indices are handed out first.
+ */
+size_t nv_slot_allocator_claim(nv_slot_allocator_t* slots);
+
+/**
+ * Give a claimed slot back. Releasing a slot that is not claimed fails with NV_ERROR_INVALID_ARG.
+ */
+nv_error nv_slot_allocator_release(nv_slot_allocator_t* slots, size_t slot);
+
+NOVA_HEADER_END
+
+#endif // NV_STD_CONTAINERS_ATOMIC_BITSET_H
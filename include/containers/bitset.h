@@ -36,18 +36,52 @@
 
 NOVA_HEADER_START
 
+/**
+ * A fixed size set of bits, stored as u64 words.
+ *
+ * Bit i lives in data[i / 64] at (1 << (i % 64)), so on little endian machines the memory layout is the same as
+ * a plain byte array of bits. Bits past 'size' in the last word are always kept clear, which lets popcount,
+ * find and the iterator work on whole words without masking.
+ *
+ * The whole set operations (and, or, xor, andnot, popcount) work a word at a time and use AVX2 where the cpu has it.
+ */
+
 typedef struct nv_bitset nv_bitset_t;
 typedef unsigned char    nv_bitset_bit;
 
+#define NV_BITSET_WORD_BITS 64
+
 struct nv_bitset
 {
-  u8*    data;
-  size_t size;
+  u64*            data;
+  size_t          size;  // number of bits
+  size_t          words; // number of u64 words in data
+  nv_allocator_t* alloc;
 };
 
+static inline size_t
+nv_bitset_word_count(size_t bits)
+{
+  return (bits + NV_BITSET_WORD_BITS - 1) / NV_BITSET_WORD_BITS;
+}
+
+/**
+ * 'init_capacity' is the number of bits. Every bit starts clear.
+ */
 nv_error nv_bitset_init(size_t init_capacity, nv_bitset_t* set);
+
+/**
+ * Same as nv_bitset_init(), but the bits are allocated through 'allocator'.
+ * 'allocator' may be NULL for the default allocator. It must outlive the set.
+ */
+nv_error nv_bitset_init_with_allocator(size_t init_capacity, nv_allocator_t* allocator, nv_bitset_t* set);
 void     nv_bitset_destroy(nv_bitset_t* set);
 
+/**
+ * Change the number of bits in the set. New bits are clear, bits past the new size are dropped.
+ */
+nv_error nv_bitset_resize(nv_bitset_t* set, size_t bits);
+
 void nv_bitset_set_bit(nv_bitset_t* set, size_t bitindex);
 void nv_bitset_set_bit_to(nv_bitset_t* set, size_t bitindex, nv_bitset_bit to);
 void nv_bitset_clear_bit(nv_bitset_t* set, size_t bitindex);
@@ -56,8 +90,86 @@ void nv_bitset_copy_from(nv_bitset_t* dst, const nv_bitset_t* src);
 
 nv_bitset_bit nv_bitset_access_bit(const nv_bitset_t* set, size_t bitindex);
 
+/**
+ * Resize 'set' to 'array_size' bits and set bit i to array[i].
+ * Packs 32 bools at a time with a compare and movemask.
+ */
 void nv_bitset_copy_from_bool_array(nv_bitset_t* set, const bool* array, size_t array_size);
 
+/**
+ * Set or clear the 'count' bits starting at 'first'. The range is clamped to the size of the set.
+ * Whole words in the middle of the range are filled without touching the bits one by one.
+ */
+void nv_bitset_set_range(nv_bitset_t* set, size_t first, size_t count);
+void nv_bitset_clear_range(nv_bitset_t* set, size_t first, size_t count);
+
+/**
+ * dst = dst op src, over whole words.
+ * If 'src' is smaller than 'dst' it is treated as padded with clear bits, bits of 'src' past the size of 'dst' are ignored.
+ */
+void nv_bitset_and(nv_bitset_t* dst, const nv_bitset_t* src);
+void nv_bitset_or(nv_bitset_t* dst, const nv_bitset_t* src);
+void nv_bitset_xor(nv_bitset_t* dst, const nv_bitset_t* src);
+// dst = dst & ~src
+void nv_bitset_andnot(nv_bitset_t* dst, const nv_bitset_t* src);
+
+/**
+ * The number of set bits.
+ */
+size_t nv_bitset_popcount(const nv_bitset_t* set);
+
+/**
+ * The index of the first set bit (at or after 'from'), or SIZE_MAX if there is none.
+ */
+size_t nv_bitset_find_first_set(const nv_bitset_t* set);
+size_t nv_bitset_find_next_set(const nv_bitset_t* set, size_t from);
+
+/**
+ * Iterate over the set bits in increasing order:
+ *
+ *  nv_bitset_iter_t it;
+ *  size_t           bit;
+ *  nv_bitset_iter_init(&set, &it);
+ *  while (nv_bitset_iter_next(&it, &bit)) { ... }
+ *
+ * Each step is a count trailing zeros and clearing the lowest bit of the current word, empty words are skipped whole.
+ * The set must not be resized while iterating. Bits changed in words the iterator has not reached yet are seen.
+ */
+typedef struct nv_bitset_iter
+{
+  const u64* words;
+  size_t     word_count;
+  size_t     word_index;
+  u64        word; // the bits of words[word_index] not returned yet
+} nv_bitset_iter_t;
+
+static inline void
+nv_bitset_iter_init(const nv_bitset_t* set, nv_bitset_iter_t* it)
+{
+  it->words      = set->data;
+  it->word_count = set->words;
+  it->word_index = 0;
+  it->word       = set->words ? set->data[0] : 0;
+}
+
+static inline bool
+nv_bitset_iter_next(nv_bitset_iter_t* it, size_t* bitindex)
+{
+  while (it->word == 0)
+  {
+    if (++it->word_index >= it->word_count)
+    {
+      it->word_index = it->word_count;
+      return false;
+    }
+    it->word = it->words[it->word_index];
+  }
+
+  *bitindex = (it->word_index * NV_BITSET_WORD_BITS) + (size_t)nv_ctz64(it->word);
+  it->word &= it->word - 1;
+  return true;
+}
+
 NOVA_HEADER_END
 
 #endif // NV_STD_CONTAINERS_BITSET_H
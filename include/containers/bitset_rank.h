@@ -0,0 +1,105 @@
+/*
+  MIT License
+
+  Copyright (c) 2025 Fouzan MD Ishaque (fouzanmdishaque@gmail.com)
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+/**
+ * Rank and select over a bitset.
+ *
+ * rank(i) is the number of set bits before bit i, select(k) is the index of the k-th set bit (counting from 0).
+ * Together they map a sparse set of ids to dense indices without a hashmap: mark the ids in a bitset, build the index,
+ * and the dense index of an id is its rank:
+ *
+ *  if (nv_bitset_access_bit(&ids, id)) { value = values[nv_bitset_rank(&index, id)]; }
+ *
+ * and nv_bitset_select() maps a dense index back to its id.
+ *
+ * Layout, one u64 per block of 2048 bits (3.125% on top of the bitset):
+ *  the low 32 bits hold the number of set bits before the block, counted from the start of its 2^32 bit stretch,
+ *  and three 10 bit fields hold the popcounts of the first three 512 bit sub-blocks.
+ * A u64 per 2^32 bits holds the absolute counts the blocks are relative to, and the block of every
+ * NV_BITSET_SELECT_SAMPLE-th set bit is sampled to narrow down select.
+ *
+ * rank reads one block entry and popcounts at most 8 words. select binary searches the blocks between two samples,
+ * then walks at most 4 sub-blocks and 8 words. With BMI2 the bit within the word is found with pdep.
+ *
+ * The index is a snapshot: it borrows the bitset, and must be rebuilt after the bitset changes.
+ */
+
+#ifndef NV_STD_CONTAINERS_BITSET_RANK_H
+#define NV_STD_CONTAINERS_BITSET_RANK_H
+
+#include "../alloc.h"
+#include "../error.h"
+#include "../stdafx.h"
+#include "../types.h"
+#include "bitset.h"
+
+#include <stddef.h>
+
+NOVA_HEADER_START
+
+#define NV_BITSET_RANK_BLOCK_BITS 2048
+#define NV_BITSET_SELECT_SAMPLE 8192
+
+typedef struct nv_bitset_rank
+{
+  const nv_bitset_t* set;
+
+  u64*   counts; // absolute counts, one per 2^32 bits
+  u64*   blocks; // one per NV_BITSET_RANK_BLOCK_BITS bits
+  u32*   samples;
+  size_t count_count;
+  size_t block_count;
+  size_t sample_count;
+
+  // the number of set bits in the whole set
+  size_t ones;
+
+  nv_allocator_t* alloc;
+} nv_bitset_rank_t;
+
+/**
+ * Build an index over 'set', which must outlive it.
+ * 'allocator' may be NULL for the allocator of the set.
+ */
+nv_error nv_bitset_rank_init(const nv_bitset_t* set, nv_allocator_t* allocator, nv_bitset_rank_t* index);
+
+/**
+ * Build the index again after the bitset changed (it may have been resized).
+ */
+nv_error nv_bitset_rank_rebuild(nv_bitset_rank_t* index);
+void     nv_bitset_rank_destroy(nv_bitset_rank_t* index);
+
+/**
+ * The number of set bits before 'bitindex'. Indices past the end of the set give the total.
+ */
+size_t nv_bitset_rank(const nv_bitset_rank_t* index, size_t bitindex);
+
+/**
+ * The index of the set bit with 'k' set bits before it, or SIZE_MAX if the set has k or fewer.
+ */
+size_t nv_bitset_select(const nv_bitset_rank_t* index, size_t k);
+
+NOVA_HEADER_END
+
+#endif // NV_STD_CONTAINERS_BITSET_RANK_H
@@ -0,0 +1,184 @@
+/*
+  MIT License
+
+  Copyright (c) 2025 Fouzan MD Ishaque (fouzanmdishaque@gmail.com)
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef NV_STD_CONTAINERS_DEQUE_H
+#define NV_STD_CONTAINERS_DEQUE_H
+
+#include "../alloc.h"
+#include "../attributes.h"
+#include "../error.h"
+#include "../stdafx.h"
+#include "../types.h"
+
+#include <stddef.h>
+
+NOVA_HEADER_START
+
+/* The smallest capacity a deque grows to from 0. Must be a power of two. */
+#ifndef NV_DEQUE_MIN_CAPACITY
+#  define NV_DEQUE_MIN_CAPACITY 8
+#endif
+
+/**
+ * A double ended queue on a ring buffer.
+ * Pushing and popping at either end is O(1), nothing is ever moved except when the buffer grows.
+ * The capacity is always a power of two so that wrapping around is a mask instead of a division.
+ * Elements are type erased the same way as nv_list_t, every element is 'type_size' bytes.
+ *
+ * The elements are contiguous in at most two pieces, see nv_deque_spans().
+ */
+typedef struct nv_deque
+{
+  u32             canary;
+  size_t          head; // index of the front element in data
+  size_t          size;
+  size_t          capacity; // 0 or a power of two
+  size_t          type_size;
+  void*           data;
+  nv_allocator_t* alloc;
+} nv_deque_t;
+
+/**
+ * A contiguous piece of a deque.
+ */
+typedef struct nv_deque_span
+{
+  void*  data;
+  size_t count;
+} nv_deque_span_t;
+
+/**
+ * init_capacity may be 0, it is rounded up to a power of two.
+ */
+nv_error nv_deque_init(size_t type_size, size_t init_capacity, nv_deque_t* deque);
+
+/**
+ * Same as nv_deque_init(), but all of the deque's memory is allocated through 'allocator'.
+ * 'allocator' may be NULL for the default allocator. It must outlive the deque.
+ */
+nv_error nv_deque_init_with_allocator(size_t type_size, size_t init_capacity, nv_allocator_t* allocator, nv_deque_t* deque);
+void     nv_deque_destroy(nv_deque_t* deque);
+
+static inline bool
+nv_deque_is_valid(const nv_deque_t* deque)
+{
+  if (deque == NULL) { return false; }
+  if (deque->canary != NOVA_CONT_CANARY) { return false; }
+  if (deque->capacity > 0 && deque->data == NULL) { return false; }
+  if (deque->capacity & (deque->capacity - 1)) { return false; }
+  if (deque->type_size <= 0) { return false; }
+  return true;
+}
+
+/**
+ * Ensure atleast 'new_capacity' elements can be contained in the deque without growing.
+ * The deque never shrinks.
+ */
+nv_error nv_deque_reserve(nv_deque_t* deque, size_t new_capacity);
+
+/**
+ * Remove all elements. This does not reduce the capacity.
+ */
+void nv_deque_clear(nv_deque_t* deque);
+
+static inline size_t
+nv_deque_size(const nv_deque_t* deque)
+{
+  return deque->size;
+}
+
+static inline size_t
+nv_deque_capacity(const nv_deque_t* deque)
+{
+  return deque->capacity;
+}
+
+static inline bool
+nv_deque_empty(const nv_deque_t* deque)
+{
+  return deque->size == 0;
+}
+
+/**
+ * Get the element at index i, counted from the front. NULL if i is out of range.
+ */
+static inline void*
+nv_deque_get(const nv_deque_t* deque, size_t i)
+{
+  if (i >= deque->size) { return NULL; }
+  return (uchar*)deque->data + ((deque->head + i) & (deque->capacity - 1)) * deque->type_size;
+}
+
+/**
+ * Get the first/last element, NULL if the deque is empty.
+ */
+static inline void*
+nv_deque_front(const nv_deque_t* deque)
+{
+  return nv_deque_get(deque, 0);
+}
+
+static inline void*
+nv_deque_back(const nv_deque_t* deque)
+{
+  return deque->size ? nv_deque_get(deque, deque->size - 1) : NULL;
+}
+
+/**
+ * Push a copy of 'elem' to either end of the deque.
+ * Fails with NV_ERROR_MALLOC_FAILED if the deque had to grow and could not, the deque is left untouched.
+ */
+nv_error nv_deque_push_back(nv_deque_t* NV_RESTRICT deque, const void* NV_RESTRICT elem);
+nv_error nv_deque_push_front(nv_deque_t* NV_RESTRICT deque, const void* NV_RESTRICT elem);
+
+/**
+ * Pop an element from either end of the deque, copying it to 'out' if 'out' is not NULL.
+ * Returns false if the deque was empty.
+ */
+bool nv_deque_pop_back(nv_deque_t* NV_RESTRICT deque, void* NV_RESTRICT out);
+bool nv_deque_pop_front(nv_deque_t* NV_RESTRICT deque, void* NV_RESTRICT out);
+
+/**
+ * Push 'count' contiguous elements to the back, in order. At most two memcpy's.
+ */
+nv_error nv_deque_push_back_n(nv_deque_t* NV_RESTRICT deque, const void* NV_RESTRICT elems, size_t count);
+
+/**
+ * Pop up to 'count' elements from the front in to 'out' (which may be NULL to just drop them).
+ * Returns the number of elements popped. At most two memcpy's.
+ */
+size_t nv_deque_pop_front_n(nv_deque_t* NV_RESTRICT deque, void* NV_RESTRICT out, size_t count);
+
+/**
+ * Get the elements of the deque as (at most) two contiguous spans, front to back.
+ * spans[0] holds the elements from the front up to the end of the buffer, spans[1] the ones that wrapped around.
+ * Unused spans have a count of 0 and a NULL data pointer.
+ * Returns the number of non empty spans.
+ * The spans are invalidated by any push, and by pops of the elements they cover.
+ */
+int nv_deque_spans(const nv_deque_t* deque, nv_deque_span_t spans[2]);
+
+NOVA_HEADER_END
+
+#endif // NV_STD_CONTAINERS_DEQUE_H
@@ -70,6 +70,9 @@ struct nv_hashmap
 
   /* Passed to the hash and comparison function as user data argument. */
   void* user_data;
+
+  /* The node array and every key and value are allocated through this. */
+  nv_allocator_t* alloc;
 };
 
 /**
@@ -78,6 +81,13 @@ struct nv_hashmap
 */
 nv_error nv_hashmap_init(size_t keysize, size_t valuesize, nv_hash_fn hash_fn, nv_compare_fn comp_fn, size_t init_capacity, nv_hashmap_t* dst);
 
+/**
+ * Same as nv_hashmap_init(), but all of the map's memory is allocated through 'allocator'.
+ * 'allocator' may be NULL for the default allocator. It must outlive the map.
+ */
+nv_error nv_hashmap_init_with_allocator(
+    size_t keysize, size_t valuesize, nv_hash_fn hash_fn, nv_compare_fn comp_fn, size_t init_capacity, nv_allocator_t* allocator, nv_hashmap_t* dst);
+
 void nv_hashmap_destroy(nv_hashmap_t* map);
 
 void nv_hashmap_resize(nv_hashmap_t* map, size_t new_capacity);
@@ -104,7 +114,7 @@ nv_hashmap_node_t* nv_hashmap_root_node(const nv_hashmap_t* map);
  *  also, if key or value is a string (const char *, not a nv_string_t or something),
  *  just pass in the const char *, not a pointer to it!!!
  *   The hash function argument will be passed on to resize() too if it needs to be
- * @return A pointer to the value of the node that was inserted.
+ * @return A pointer to the value of the node that was inserted, NULL if the allocator ran out of memory (the map is left as it was).
  */
 void* nv_hashmap_insert(nv_hashmap_t* map, const void* NV_RESTRICT key, const void* NV_RESTRICT value);
 
@@ -115,7 +125,7 @@ void* nv_hashmap_insert(nv_hashmap_t* map, const void* NV_RESTRICT key, const vo
 bool nv_hashmap_delete(nv_hashmap_t* map, const void* key);
 
 /**
- * @return A pointer to the value of the node that was inserted.
+ * @return A pointer to the value of the node that was inserted, NULL if an allocation failed (the map is left as it was).
  */
 void* nv_hashmap_insert_or_replace(nv_hashmap_t* map, const void* NV_RESTRICT key, void* NV_RESTRICT value);
 
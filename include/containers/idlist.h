@@ -30,6 +30,7 @@ extern "C"
 {
 #endif
 
+#include "../alloc.h"
 #include "../error.h"
 #include "../stdafx.h"
 #include "../types.h"
@@ -43,20 +44,78 @@ extern "C"
    *    If an element is deleted, the last element is always swapped with it, breaking the order.
    * Iteration is also as fast as lists/vectors, where we just iterate over the data pointer.
    * ID lists are effectively lists that store an additional table to map to the values.
+   *
+   * IDs are generational handles: the low NV_ID_LIST_INDEX_BITS bits are a slot in the ID table, the rest is the
+   * slot's generation. Deleting an element puts its slot on a free list and bumps the generation, so the slot is
+   * reused by a later push under a different ID and the old ID stops working. nv_id_list_get() and
+   * nv_id_list_delete() reject stale IDs in O(1).
+   * A generation wraps around after 2^(bits - NV_ID_LIST_INDEX_BITS) reuses of the same slot, only then could
+   * a very old ID be mistaken for a live one.
    */
   typedef struct nv_id_list nv_id_list_t;
 
+#if SIZE_MAX > 0xFFFFFFFFu
+#  define NV_ID_LIST_INDEX_BITS 32
+#else
+#  define NV_ID_LIST_INDEX_BITS 24
+#endif
+
+#define NV_ID_LIST_INDEX_MASK (((size_t)1 << NV_ID_LIST_INDEX_BITS) - 1)
+#define NV_ID_LIST_GENERATION_MASK (SIZE_MAX >> NV_ID_LIST_INDEX_BITS)
+
+#ifndef NV_ID_LIST_MIN_CAPACITY
+/* Deletes never shrink the element storage below this many elements. */
+#  define NV_ID_LIST_MIN_CAPACITY 16
+#endif
+
+/* Never a valid ID, returned by nv_id_list_push() if it fails. */
+#define NV_ID_LIST_INVALID_ID SIZE_MAX
+
+  /**
+   * The ID table slot of an ID, unique among the live elements. Can be used to index side tables.
+   */
+  static inline size_t
+  nv_id_list_id_slot(size_t id)
+  {
+    return id & NV_ID_LIST_INDEX_MASK;
+  }
+
+  static inline size_t
+  nv_id_list_id_generation(size_t id)
+  {
+    return id >> NV_ID_LIST_INDEX_BITS;
+  }
+
   /**
    * Initialize an ID list with 'init_capacity' elements of size 'type_size'.
    */
   nv_error nv_id_list_init(size_t type_size, size_t init_capacity, nv_id_list_t* idlist);
+
+  /**
+   * Same as nv_id_list_init(), but all of the ID list's memory is allocated through 'allocator'.
+   * 'allocator' may be NULL for the default allocator. It must outlive the ID list.
+   */
+  nv_error nv_id_list_init_with_allocator(size_t type_size, size_t init_capacity, nv_allocator_t* allocator, nv_id_list_t* idlist);
   void     nv_id_list_destroy(nv_id_list_t* idlist);
 
   /**
-   * Resize an ID list, reserving space for the elements and ID table.
+   * Resize an ID list, reserving space for the elements.
+   * The ID table only ever grows, IDs must stay valid.
    */
   void nv_id_list_resize(size_t new_capacity, nv_id_list_t* idlist);
 
+  /**
+   * Make room for atleast 'capacity' elements (and their IDs), so that pushing up to that many does not allocate.
+   * Deletes don't shrink the list below a reserved capacity.
+   * Storage otherwise doubles when full, and halves once the list is down to a quarter of its capacity.
+   */
+  nv_error nv_id_list_reserve(size_t capacity, nv_id_list_t* idlist);
+
+  /**
+   * Shrink the element storage to the current size and drop the reservation. The ID table keeps its size.
+   */
+  void nv_id_list_shrink_to_fit(nv_id_list_t* idlist);
+
   /**
    * Iterate over an ID list.
    * ctx must be initialized with 0.
@@ -64,35 +123,145 @@ extern "C"
    */
   void* nv_id_list_iter(size_t* ctx, nv_id_list_t* idlist);
 
+  /**
+   * Get the element with the specified ID, NULL if the ID is stale (the element was deleted) or was never pushed.
+   */
   void* nv_id_list_get(size_t id, const nv_id_list_t* idlist);
 
+  /**
+   * Is 'id' the ID of a live element?
+   */
+  bool nv_id_list_contains(size_t id, const nv_id_list_t* idlist);
+
+  /**
+   * The ID of the element at 'index' in the data array, for example while iterating.
+   */
+  size_t nv_id_list_id_at(size_t index, const nv_id_list_t* idlist);
+
   /**
    * Push a copy of the element in to the ID list.
-   * Returns its ID.
+   * Returns its ID, or NV_ID_LIST_INVALID_ID if it could not be pushed.
    * Maintain the ID if you want to access that specific element.
    */
   size_t nv_id_list_push(const void* elem, nv_id_list_t* idlist);
 
   /**
-   * Remove the last element in the ID list.
+   * Push 'count' elements from the array 'elems', growing the storage once.
+   * The IDs are written to 'ids' if it is not NULL.
+   */
+  nv_error nv_id_list_push_n(const void* elems, size_t count, size_t* ids, nv_id_list_t* idlist);
+
+  /**
+   * Remove the last element in the ID list. Its ID becomes stale.
    */
   void nv_id_list_pop(nv_id_list_t* idlist);
 
   /**
    * Delete the element with the specified ID.
    * Swap the element with the last element (if it is not) and pop it.
+   * Returns false if the ID is stale or was never pushed.
    */
   bool nv_id_list_delete(size_t id, nv_id_list_t* idlist);
 
+  /**
+   * Delete the elements with the 'count' IDs in 'ids', checking whether to shrink only once at the end.
+   * Stale IDs are skipped. Returns the number of elements deleted.
+   */
+  size_t nv_id_list_delete_n(const size_t* ids, size_t count, nv_id_list_t* idlist);
+
+  /**
+   * A multi column ID list: like nv_id_list_t, but every element is split in to 'column_count' components that are
+   * stored in parallel arrays (structure of arrays), each with its own type size, all behind one ID table.
+   * A system that only touches one component iterates over one dense array instead of striding over whole elements.
+   * Deleting swaps the last element in to the hole in every column, so the columns always stay in step:
+   * index i of every column belongs to the same element.
+   */
+  typedef struct nv_id_columns nv_id_columns_t;
+
+  /**
+   * Initialize with 'column_count' columns, column c holding elements of 'column_sizes[c]' bytes.
+   * 'allocator' may be NULL for the default allocator.
+   */
+  nv_error nv_id_columns_init(const size_t* column_sizes, size_t column_count, size_t init_capacity, nv_allocator_t* allocator, nv_id_columns_t* cols);
+  void     nv_id_columns_destroy(nv_id_columns_t* cols);
+
+  /**
+   * Push an element, 'components[c]' is copied in to column c (zeroed if components or components[c] is NULL).
+   * Returns its ID, or NV_ID_LIST_INVALID_ID if it could not be pushed.
+   */
+  size_t nv_id_columns_push(const void* const* components, nv_id_columns_t* cols);
+
+  /**
+   * Delete the element with the specified ID from every column. Returns false if the ID is stale.
+   */
+  bool nv_id_columns_delete(size_t id, nv_id_columns_t* cols);
+
+  /**
+   * Component 'column' of the element with the specified ID, NULL if the ID is stale.
+   */
+  void* nv_id_columns_get(size_t id, size_t column, const nv_id_columns_t* cols);
+
+  bool nv_id_columns_contains(size_t id, const nv_id_columns_t* cols);
+
+  /**
+   * The dense array of column 'column', nv_id_columns_size() elements long. Pointers are invalidated by pushes and deletes.
+   */
+  void* nv_id_columns_column(size_t column, const nv_id_columns_t* cols);
+
+  size_t nv_id_columns_size(const nv_id_columns_t* cols);
+
+  /**
+   * The ID of the element at 'index' in the columns.
+   */
+  size_t nv_id_columns_id_at(size_t index, const nv_id_columns_t* cols);
+
+  /**
+   * Same as nv_id_list_reserve() and nv_id_list_shrink_to_fit(), for every column.
+   */
+  nv_error nv_id_columns_reserve(size_t capacity, nv_id_columns_t* cols);
+  void     nv_id_columns_shrink_to_fit(nv_id_columns_t* cols);
+
+  /* An ID table slot. */
+  typedef struct nv_id_slot
+  {
+    u32 generation;
+    u32 index; // the element's index while the slot is live, the next free slot while it is free
+  } nv_id_slot_t;
+
+  /* The ID table shared by nv_id_list_t and nv_id_columns_t. */
+  typedef struct nv_id_table
+  {
+    nv_id_slot_t* slots;     // indexed by nv_id_list_id_slot(id)
+    size_t        count;     // slots ever handed out
+    size_t        capacity;
+    u32           free_slot; // head of the free slot list, UINT32_MAX if empty
+  } nv_id_table_t;
+
   struct nv_id_list
   {
-    u32     canary; // == 0xFEF6324
-    size_t  size;
-    size_t* id_to_index;
-    size_t* index_to_id;
-    size_t  type_size;
-    size_t  capacity;
-    void*   data;
+    u32             canary; // == 0xFEF6324
+    size_t          size;
+    nv_id_table_t   table;
+    size_t*         index_to_id; // the ID of every element
+    size_t          type_size;
+    size_t          capacity;
+    size_t          reserved; // deletes don't shrink below this, see nv_id_list_reserve()
+    void*           data;
+    nv_allocator_t* alloc;
+  };
+
+  struct nv_id_columns
+  {
+    u32             canary; // == 0xFEF6324
+    size_t          size;
+    nv_id_table_t   table;
+    size_t*         index_to_id;
+    size_t          column_count;
+    size_t*         column_sizes;
+    void**          columns;
+    size_t          capacity;
+    size_t          reserved;
+    nv_allocator_t* alloc;
   };
 
 #ifdef __cplusplus
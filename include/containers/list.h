@@ -36,25 +36,87 @@
 
 NOVA_HEADER_START
 
+#ifndef NV_LIST_COMMIT_GRANULE
+/* Reserved lists commit memory in steps of atleast this many bytes (rounded up to the page size). */
+#  define NV_LIST_COMMIT_GRANULE (64 * 1024)
+#endif
+
+/**
+ * Where a list's data lives.
+ */
+typedef enum nv_list_storage
+{
+  /* Allocated through the list's allocator, the default. */
+  NV_LIST_STORAGE_ALLOCATOR = 0,
+
+  /* A reserved range of address space that is committed as the list grows, see nv_list_init_reserved(). */
+  NV_LIST_STORAGE_RESERVED,
+
+  /* A shared mapping of a file, see nv_list_open_file(). */
+  NV_LIST_STORAGE_FILE,
+} nv_list_storage;
+
 typedef struct nv_list
 {
-  u32    canary;
-  size_t size;
-  size_t capacity;
-  size_t type_size;
-  void*  data;
+  u32             canary;
+  size_t          size;
+  size_t          capacity;
+  size_t          type_size;
+  void*           data;
+  nv_allocator_t* alloc;
+  nv_list_storage storage;
+  size_t          mapped; // bytes of address space mapped, for NV_LIST_STORAGE_RESERVED and NV_LIST_STORAGE_FILE
+  int             fd;     // for NV_LIST_STORAGE_FILE
 } nv_list_t;
 
 /**
  * init_capacity may be 0
  */
 nv_error nv_list_init(size_t type_size, size_t init_capacity, nv_list_t* list);
+
+/**
+ * Same as nv_list_init(), but all of the list's memory is allocated through 'allocator'.
+ * 'allocator' may be NULL for the default allocator. It must outlive the list.
+ */
+nv_error nv_list_init_with_allocator(size_t type_size, size_t init_capacity, nv_allocator_t* allocator, nv_list_t* list);
+
+/**
+ * Initialize a list that reserves address space for 'max_capacity' elements up front, without using any memory for it.
+ * Pages are committed as the list grows, so the data pointer never moves and growing never copies.
+ * Pointers in to the list stay valid for the lifetime of the list.
+ * Useful for lists that can grow very large (the reservation can be tens of GB on 64 bit systems).
+ *
+ * The list can not grow past 'max_capacity' (rounded up to a whole page), trying to is fatal. It also never shrinks, nv_list_reserve() with
+ * a smaller capacity is ignored.
+ * Everything else about the list (nv_list_duplicate_data() etc.) still goes through the current allocator.
+ */
+nv_error nv_list_init_reserved(size_t type_size, size_t max_capacity, nv_list_t* list);
+
+/**
+ * Open a list whose storage is the file at 'path', created if it does not exist.
+ * The file is mapped in to memory, so the list's contents persist across runs without being serialized.
+ * Growing the list grows the file (ftruncate() and mremap()), the data pointer may move like it does for regular lists.
+ *
+ * The file starts with a 64 byte header (magic, version, type size and the number of elements), followed by the elements.
+ * Opening a file that was written with a different 'type_size', or that is not a list file, fails with NV_ERROR_INVALID_INPUT.
+ *
+ * Changes are written back by the kernel in its own time. Call nv_list_sync() to make them durable.
+ * nv_list_destroy() records the size and closes the file, but does not wait for the data to reach the disk.
+ * Not available on windows (NV_ERROR_INVALID_OPERATION).
+ */
+nv_error nv_list_open_file(const char* path, size_t type_size, nv_list_t* list);
+
+/**
+ * Write a file backed list's size and contents to disk (msync()), returning once they are there.
+ * Does nothing for other lists.
+ */
+nv_error nv_list_sync(nv_list_t* list);
 void     nv_list_destroy(nv_list_t* list);
 
 /**
  * Duplicate the list's data and copy over its contents.
  * The returned pointer will have the size capacity * type_size.
- * The returned pointer is owned by the callee, and must be freed through nv_free().
+ * The returned pointer is owned by the callee, and must be freed through the list's allocator (nv_free() for the default allocator).
  * WARNING: This function does not care about the lists capacity, only the number of elements in the list will be accomodated in the returned pointer.
  */
 void* nv_list_duplicate_data(const nv_list_t* list);
@@ -81,6 +143,7 @@ void nv_list_resize(nv_list_t* list, size_t new_size);
 /**
  * Ensure atleast 'new_capacity' of elements can be contained in the list.
  * This does not change the actual list of the size.
+ * For reserved lists this only commits more of the reservation, the data pointer does not move.
  * \sa nv_list_resize
  */
 void nv_list_reserve(nv_list_t* list, size_t new_capacity);
@@ -135,6 +198,7 @@ void nv_list_copy_from(const nv_list_t* NV_RESTRICT src, nv_list_t* NV_RESTRICT
 /**
  * Move the contents of 'src' to 'dst', where 'src' will have 0 elements after this call.
  * 'src' will still retain its capacity, but all its data will be memset to 0
+ * 'dst' takes over the allocator of 'src' along with its data.
  */
 void nv_list_move_from(nv_list_t* NV_RESTRICT src, nv_list_t* NV_RESTRICT dst);
 
@@ -173,28 +237,70 @@ void nv_list_pop_back(nv_list_t* list);
 /**
  * Remove the first element of the list. This is relatively expensive, as all elements after must be moved to replace the popped element.
  * Try restructuring your code to ensure this function need not be called. But for small lists, its okay.
+ * For FIFO queues use nv_deque_t (containers/deque.h) instead.
  */
 void nv_list_pop_front(nv_list_t* list);
 
 /**
- * Insert an element into a specified index. The list will be resized automatically to accomodate the index.
+ * Insert an element at 'index', shifting the elements from 'index' onwards back by one.
+ * An index past the end grows the list to accomodate it, the elements in between are zeroed.
  */
 void nv_list_insert(nv_list_t* NV_RESTRICT vec, size_t index, const void* NV_RESTRICT elem);
 
+/**
+ * Insert 'count' elements from 'elems' at 'index', with a single shift of the elements after it.
+ * Same rules as nv_list_insert() otherwise.
+ */
+void nv_list_insert_range(nv_list_t* NV_RESTRICT list, size_t index, const void* NV_RESTRICT elems, size_t count);
+
 /**
  * Remove an element from the list. The list will not be downscaled (capacity will not be reduced).
+ * Removing many elements this way is quadratic, see nv_list_erase_range(), nv_list_remove_if() and nv_list_swap_remove().
  */
 void nv_list_remove(nv_list_t* list, size_t index);
 
 /**
- * Find the index of an element in the list. SIZE_MAX if not found.
+ * Remove elements [first, first + count), clamped to the end of the list, with a single shift.
+ */
+void nv_list_erase_range(nv_list_t* list, size_t first, size_t count);
+
+/**
+ * Remove an element by moving the last element into its place. O(1), but does not keep the order.
+ */
+void nv_list_swap_remove(nv_list_t* list, size_t index);
+
+typedef bool (*nv_list_predicate_fn)(const void* elem, void* user_data);
+
+/**
+ * Remove every element 'predicate' returns true for, in a single pass. The order of the kept elements is kept.
+ * Returns the number of elements removed.
+ */
+size_t nv_list_remove_if(nv_list_t* list, nv_list_predicate_fn predicate, void* user_data);
+
+/**
+ * Find the index of the first element in the list equal (byte for byte) to 'elem'. SIZE_MAX if not found.
+ * Elements of 1, 2, 4, 8 and 16 bytes are scanned with SSE2/AVX2 where the CPU has them.
+ * implementation: list_find.c
  */
 size_t nv_list_find(const nv_list_t* NV_RESTRICT vec, const void* NV_RESTRICT elem);
 
 /**
- * Sort all elements in the list, using the sort function 'compare' through qsort().
+ * Push the index of every element equal to 'elem' to 'indices', a list of size_t.
+ * Returns the number of indices pushed.
+ */
+size_t nv_list_find_all(const nv_list_t* NV_RESTRICT list, const void* NV_RESTRICT elem, nv_list_t* NV_RESTRICT indices);
+
+/**
+ * The number of elements equal to 'elem'.
+ */
+size_t nv_list_count(const nv_list_t* NV_RESTRICT list, const void* NV_RESTRICT elem);
+
+/**
+ * Sort all elements in the list with 'compare' (nv_compare_default if NULL), 'user_data' is passed through to it.
+ * For known element types, the NV_DECL_SORT() instances and radix sorts in containers/sort.h are much faster.
+ * If only the greatest few elements or the nth one are needed, nv_list_top_k() and nv_list_nth_element() are cheaper.
  */
-void nv_list_sort(nv_list_t* list, nv_compare_fn compare);
+void nv_list_sort(nv_list_t* list, nv_compare_fn compare, void* user_data);
 
 NOVA_HEADER_END
 
@@ -0,0 +1,98 @@
+/*
+  MIT License
+
+  Copyright (c) 2025 Fouzan MD Ishaque (fouzanmdishaque@gmail.com)
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+/**
+ * Data parallel algorithms over nv_list, run on a nv_thread_pool_t.
+ *
+ * Lists are split into chunks of about NV_LIST_PARALLEL_CHUNK_BYTES, small enough to stay in a core's cache and
+ * plentiful enough to balance over the pool. Callbacks get a whole chunk at a time, so the loop over the elements
+ * stays in the caller's code where it can be inlined and vectorized.
+ *
+ * Every function takes a 'pool', NULL for nv_thread_pool_default().
+ * Callbacks run concurrently on different chunks and must not touch the list's size or capacity.
+ */
+
+#ifndef NV_STD_CONTAINERS_LIST_PARALLEL_H
+#define NV_STD_CONTAINERS_LIST_PARALLEL_H
+
+#include "../error.h"
+#include "../hash.h"
+#include "../stdafx.h"
+#include "../threadpool.h"
+#include "list.h"
+
+#include <stddef.h>
+
+NOVA_HEADER_START
+
+#ifndef NV_LIST_PARALLEL_CHUNK_BYTES
+#  define NV_LIST_PARALLEL_CHUNK_BYTES (256 * 1024)
+#endif
+
+/**
+ * Process 'count' elements starting at 'elems', which are elements [first, first + count) of the list.
+ */
+typedef void (*nv_list_chunk_fn)(void* elems, size_t count, size_t first, void* user_data);
+
+/**
+ * Fold 'count' elements starting at 'elems' into the accumulator 'acc'.
+ */
+typedef void (*nv_list_reduce_fn)(void* acc, const void* elems, size_t count, void* user_data);
+
+/**
+ * acc = acc (op) other. The operation must be associative, it does not have to be commutative.
+ */
+typedef void (*nv_list_combine_fn)(void* acc, const void* other, void* user_data);
+
+/**
+ * Call 'fn' on every chunk of the list.
+ */
+void nv_list_parallel_for(nv_list_t* list, nv_list_chunk_fn fn, void* user_data, nv_thread_pool_t* pool);
+
+/**
+ * Reduce the list into 'result', an accumulator of 'acc_size' bytes.
+ * Each chunk is reduced into a copy of 'identity' with 'reduce', then the chunk results are combined in list order
+ * with 'combine', so the result is the same as a serial reduction for any associative operation.
+ */
+nv_error nv_list_parallel_reduce(const nv_list_t* list, size_t acc_size, const void* identity, nv_list_reduce_fn reduce, nv_list_combine_fn combine, void* user_data,
+                                 void* result, nv_thread_pool_t* pool);
+
+/**
+ * In place inclusive scan: element i becomes element 0 (op) element 1 (op) ... (op) element i.
+ * 'combine' works on two elements of the list. Three passes: scan every chunk, scan the chunk totals, then apply
+ * the carry of all previous chunks to every chunk.
+ */
+nv_error nv_list_parallel_scan(nv_list_t* list, nv_list_combine_fn combine, void* user_data, nv_thread_pool_t* pool);
+
+/**
+ * Merge sort with 'compare' (nv_compare_default if NULL). Runs are sorted in parallel with nv_sort(), then merged
+ * pairwise, every merge is split into independent pieces along the merge path so that all threads take part in
+ * every round, the last one included. Stable merges, but the run sorts are not stable.
+ * Needs a scratch buffer the size of the list, allocated through the list's allocator.
+ */
+nv_error nv_list_parallel_sort(nv_list_t* list, nv_compare_fn compare, void* user_data, nv_thread_pool_t* pool);
+
+NOVA_HEADER_END
+
+#endif // NV_STD_CONTAINERS_LIST_PARALLEL_H
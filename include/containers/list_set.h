@@ -0,0 +1,70 @@
+/*
+  MIT License
+
+  Copyright (c) 2025 Fouzan MD Ishaque (fouzanmdishaque@gmail.com)
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+/**
+ * Set operations on unsorted lists.
+ *
+ * Elements are compared byte for byte (padding must be zeroed) and hashed with nv_hash_murmur3(). Each operation
+ * builds a temporary open addressing table, sized up front from the list sizes so that it never has to grow, in
+ * the allocator of the list being written to. Everything is O(n) expected.
+ *
+ * The results are sets: every element appears once, in the order it first appears in the inputs.
+ * For sorted lists, nv_list_intersect() and nv_list_merge() in containers/sorted.h need no table.
+ */
+
+#ifndef NV_STD_CONTAINERS_LIST_SET_H
+#define NV_STD_CONTAINERS_LIST_SET_H
+
+#include "../error.h"
+#include "../stdafx.h"
+#include "list.h"
+
+#include <stddef.h>
+
+NOVA_HEADER_START
+
+/**
+ * Remove every element that already appeared earlier in the list, keeping the order of the rest.
+ */
+nv_error nv_list_unique(nv_list_t* list);
+
+/**
+ * Replace the contents of 'out' with the distinct elements of 'a' followed by those of 'b' that are not in 'a'.
+ * All three lists must have the same type_size, 'out' can't be 'a' or 'b'.
+ */
+nv_error nv_list_union(const nv_list_t* a, const nv_list_t* b, nv_list_t* out);
+
+/**
+ * Replace the contents of 'out' with the distinct elements of 'a' that are not in 'b'.
+ */
+nv_error nv_list_difference(const nv_list_t* a, const nv_list_t* b, nv_list_t* out);
+
+/**
+ * Replace the contents of 'out' with the distinct elements of 'a' that are also in 'b'.
+ */
+nv_error nv_list_intersection(const nv_list_t* a, const nv_list_t* b, nv_list_t* out);
+
+NOVA_HEADER_END
+
+#endif // NV_STD_CONTAINERS_LIST_SET_H
@@ -0,0 +1,121 @@
+/*
+  MIT License
+
+  Copyright (c) 2025 Fouzan MD Ishaque (fouzanmdishaque@gmail.com)
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+/**
+ * Numeric kernels for arrays and lists of i32, i64, f32 and f64: sum, min, max, argmin, argmax and inclusive scan.
+ *
+ * The array kernels are picked at runtime from AVX-512, AVX2 or scalar code (see cpu.h).
+ * Integer sums and scans wrap around like the integer type would, except for i32 sums which are summed as i64.
+ * f32 sums are summed as f64. Vectorized float sums and scans add in a different order than a plain loop,
+ * so the last bits of the result may differ from one. Results are unspecified if the data contains NaNs.
+ *
+ * The list functions describe the element type with an nv_sort_key (the unsigned keys are not supported) and spread
+ * large lists over a thread pool.
+ */
+
+#ifndef NV_STD_CONTAINERS_NUMERIC_H
+#define NV_STD_CONTAINERS_NUMERIC_H
+
+#include "../error.h"
+#include "../stdafx.h"
+#include "../threadpool.h"
+#include "../types.h"
+#include "analytics.h"
+#include "list.h"
+#include "sort.h"
+
+#include <stddef.h>
+
+NOVA_HEADER_START
+
+#ifndef NV_NUMERIC_PARALLEL_BYTES
+/* Lists smaller than this are processed on the calling thread, the pool is only worth waking up for large ones. */
+#  define NV_NUMERIC_PARALLEL_BYTES (4 * 1024 * 1024)
+#endif
+
+i64 nv_sum_i32(const i32* data, size_t count);
+i64 nv_sum_i64(const i64* data, size_t count);
+f64 nv_sum_f32(const f32* data, size_t count);
+f64 nv_sum_f64(const f64* data, size_t count);
+
+/**
+ * The smallest/largest element. An empty array gives the type's largest/smallest value (infinity for floats).
+ */
+i32 nv_min_i32(const i32* data, size_t count);
+i64 nv_min_i64(const i64* data, size_t count);
+f32 nv_min_f32(const f32* data, size_t count);
+f64 nv_min_f64(const f64* data, size_t count);
+i32 nv_max_i32(const i32* data, size_t count);
+i64 nv_max_i64(const i64* data, size_t count);
+f32 nv_max_f32(const f32* data, size_t count);
+f64 nv_max_f64(const f64* data, size_t count);
+
+/**
+ * The index of the first smallest/largest element, 'count' if the array is empty.
+ */
+size_t nv_argmin_i32(const i32* data, size_t count);
+size_t nv_argmin_i64(const i64* data, size_t count);
+size_t nv_argmin_f32(const f32* data, size_t count);
+size_t nv_argmin_f64(const f64* data, size_t count);
+size_t nv_argmax_i32(const i32* data, size_t count);
+size_t nv_argmax_i64(const i64* data, size_t count);
+size_t nv_argmax_f32(const f32* data, size_t count);
+size_t nv_argmax_f64(const f64* data, size_t count);
+
+/**
+ * Inclusive prefix sum: dst[i] = src[0] + ... + src[i]. 'src' and 'dst' may be the same array.
+ */
+void nv_scan_i32(const i32* src, i32* dst, size_t count);
+void nv_scan_i64(const i64* src, i64* dst, size_t count);
+void nv_scan_f32(const f32* src, f32* dst, size_t count);
+void nv_scan_f64(const f64* src, f64* dst, size_t count);
+
+/**
+ * Everything about a numeric list in one go. The nv_agg_value members used are 'i' for the integer types
+ * and 'f' for the float types.
+ */
+typedef struct nv_numeric_summary
+{
+  size_t       count;
+  nv_agg_value sum;
+  nv_agg_value min;
+  nv_agg_value max;
+  size_t       argmin; // first index of min, 'count' if the list is empty
+  size_t       argmax; // first index of max, 'count' if the list is empty
+} nv_numeric_summary_t;
+
+/**
+ * Summarize a list of 'type' elements. Lists of atleast NV_NUMERIC_PARALLEL_BYTES are split in to chunks
+ * that are summarized on 'pool' (NULL for nv_thread_pool_default()).
+ */
+nv_error nv_list_summarize(const nv_list_t* list, nv_sort_key type, nv_thread_pool_t* pool, nv_numeric_summary_t* summary);
+
+/**
+ * In place inclusive prefix sum of a list of 'type' elements, in parallel on 'pool' for large lists like nv_list_summarize().
+ */
+nv_error nv_list_inclusive_scan(nv_list_t* list, nv_sort_key type, nv_thread_pool_t* pool);
+
+NOVA_HEADER_END
+
+#endif // NV_STD_CONTAINERS_NUMERIC_H
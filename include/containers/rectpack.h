@@ -33,6 +33,7 @@
 #ifndef NV_STD_CONTAINERS_RECTPACK_H
 #define NV_STD_CONTAINERS_RECTPACK_H
 
+#include "../alloc.h"
 #include "../attributes.h"
 #include "../error.h"
 #include "../stdafx.h"
@@ -57,9 +58,16 @@ struct nv_skyline_bin
   size_t             width, height;
   size_t             allocated_rect_count;
   size_t             num_rects;
+  nv_allocator_t*    alloc;
 };
 
 nv_error nv_skyline_bin_init(size_t width, size_t height, nv_skyline_bin_t* bin);
+
+/**
+ * Same as nv_skyline_bin_init(), but the skyline and rects are allocated through 'allocator'.
+ * 'allocator' may be NULL for the default allocator. It must outlive the bin.
+ */
+nv_error nv_skyline_bin_init_with_allocator(size_t width, size_t height, nv_allocator_t* allocator, nv_skyline_bin_t* bin);
 void     nv_skyline_bin_destroy(nv_skyline_bin_t* bin);
 
 /**
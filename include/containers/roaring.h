@@ -0,0 +1,168 @@
+/*
+  MIT License
+
+  Copyright (c) 2025 Fouzan MD Ishaque (fouzanmdishaque@gmail.com)
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+/**
+ * Compressed bitmaps of u32 values (Roaring bitmaps).
+ *
+ * The value space is split into 2^16 chunks by the high 16 bits of the values. Each chunk that has any values gets a
+ * container holding the low 16 bits in whichever of three forms is smallest:
+ *  array:  a sorted array of u16, for up to NV_ROARING_ARRAY_MAX values (at most 8 KB).
+ *  bitmap: 2^16 bits (8 KB), for chunks with more values than an array may hold.
+ *  run:    sorted runs of consecutive values, for long ranges. A full chunk is a single 4 byte run.
+ *
+ * Arrays become bitmaps when they outgrow NV_ROARING_ARRAY_MAX and bitmaps go back to arrays when they shrink to it.
+ * Run containers come from nv_roaring_add_range() and nv_roaring_run_optimize(), a run container that ends up with
+ * more runs than NV_ROARING_RUN_MAX turns into an array or a bitmap.
+ *
+ * Set operations work a container at a time, so a handful of values and 100M values cost about what they weigh.
+ * Bitmap containers are combined through nv_bitset_t (containers/bitset.h), 64 bits per step.
+ */
+
+#ifndef NV_STD_CONTAINERS_ROARING_H
+#define NV_STD_CONTAINERS_ROARING_H
+
+#include "../alloc.h"
+#include "../error.h"
+#include "../stdafx.h"
+#include "../stream.h"
+#include "../types.h"
+#include "list.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+NOVA_HEADER_START
+
+#define NV_ROARING_ARRAY_MAX 4096
+#define NV_ROARING_BITMAP_WORDS 1024
+#define NV_ROARING_RUN_MAX 2048 // 4 bytes per run, any more and a bitmap is smaller
+#define NV_ROARING_FORMAT_VERSION 1
+
+typedef enum nv_roaring_kind
+{
+  NV_ROARING_ARRAY  = 0,
+  NV_ROARING_BITMAP = 1,
+  NV_ROARING_RUN    = 2,
+} nv_roaring_kind;
+
+/* The values start .. start + length, both inclusive. */
+typedef struct nv_roaring_run
+{
+  u16 start;
+  u16 length;
+} nv_roaring_run_t;
+
+typedef struct nv_roaring_container
+{
+  u16 key; // the high 16 bits of every value in the container
+  u8  kind;
+  u32 cardinality;
+
+  /**
+   * array:  number of u16 values in data.
+   * bitmap: unused, data is always NV_ROARING_BITMAP_WORDS u64 words.
+   * run:    number of nv_roaring_run_t in data.
+   */
+  u32   size;
+  u32   capacity;
+  void* data;
+} nv_roaring_container_t;
+
+typedef struct nv_roaring
+{
+  nv_roaring_container_t* containers; // sorted by key
+  size_t                  size;
+  size_t                  capacity;
+  nv_allocator_t*         alloc;
+} nv_roaring_t;
+
+nv_error nv_roaring_init(nv_roaring_t* r);
+
+/**
+ * Same as nv_roaring_init(), but everything is allocated through 'allocator'.
+ * 'allocator' may be NULL for the default allocator. It must outlive the bitmap.
+ */
+nv_error nv_roaring_init_with_allocator(nv_allocator_t* allocator, nv_roaring_t* r);
+void     nv_roaring_destroy(nv_roaring_t* r);
+
+/**
+ * Remove every value.
+ */
+void nv_roaring_clear(nv_roaring_t* r);
+
+nv_error nv_roaring_add(nv_roaring_t* r, u32 value);
+
+/**
+ * Add the 'count' values starting at 'first', clamped to UINT32_MAX.
+ * Chunks that were empty get a single run container, whatever the size of the range.
+ */
+nv_error nv_roaring_add_range(nv_roaring_t* r, u32 first, u64 count);
+
+/**
+ * Removing a value that is not in the bitmap is not an error.
+ * Removing from the middle of a run splits it, which can allocate.
+ */
+nv_error nv_roaring_remove(nv_roaring_t* r, u32 value);
+bool     nv_roaring_contains(const nv_roaring_t* r, u32 value);
+
+/**
+ * The number of values in the bitmap, O(number of containers).
+ */
+u64 nv_roaring_cardinality(const nv_roaring_t* r);
+
+/**
+ * Replace the contents of 'out' with the values in 'a' or 'b' (union) or in both (intersection).
+ * 'out' must be initialized and can't be 'a' or 'b'.
+ */
+nv_error nv_roaring_union(const nv_roaring_t* a, const nv_roaring_t* b, nv_roaring_t* out);
+nv_error nv_roaring_intersection(const nv_roaring_t* a, const nv_roaring_t* b, nv_roaring_t* out);
+
+/**
+ * Convert every container to runs where that is smaller, and run containers back where it is not.
+ * Worth calling once a bitmap is built and before serializing it.
+ */
+nv_error nv_roaring_run_optimize(nv_roaring_t* r);
+
+/**
+ * Replace the contents of 'out' (a list of u32) with the values in increasing order.
+ */
+nv_error nv_roaring_to_list(const nv_roaring_t* r, nv_list_t* out);
+
+/**
+ * Format:
+ *  "NVRB" followed by a version byte and the u32 number of containers.
+ *  Then for each container: u16 key, u8 kind, u32 size, and its data (size u16 values, size runs or 1024 u64 words).
+ * Everything is in the byte order of the machine, little endian on every target we support.
+ */
+nv_error nv_roaring_serialize(const nv_roaring_t* r, nv_stream_t* stream);
+
+/**
+ * Read a bitmap written by nv_roaring_serialize() into 'r', which is initialized with 'allocator' (may be NULL).
+ * The input is validated, a malformed one fails with NV_ERROR_INVALID_INPUT and leaves 'r' empty.
+ */
+nv_error nv_roaring_deserialize(nv_stream_t* stream, nv_allocator_t* allocator, nv_roaring_t* r);
+
+NOVA_HEADER_END
+
+#endif // NV_STD_CONTAINERS_ROARING_H
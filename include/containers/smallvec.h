@@ -0,0 +1,141 @@
+/*
+  MIT License
+
+  Copyright (c) 2025 Fouzan MD Ishaque (fouzanmdishaque@gmail.com)
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+/**
+ * Small vectors, lists with inline storage.
+ *
+ * NV_DECL_SMALLVEC() declares a vector type that keeps its first N elements inside the struct itself,
+ * and only allocates once it grows beyond that. For the many lists that only ever hold a handful of elements
+ * this removes the allocation entirely.
+ *
+ * Unlike nv_list_t the vector is typed, the inline storage needs to know the element type.
+ * The data pointer is never stored in the struct, so a small vector can be copied around by value like any other struct
+ * (the copy shares the heap buffer if there is one, so only one of them may be destroyed).
+ */
+
+#ifndef NV_STD_CONTAINERS_SMALLVEC_H
+#define NV_STD_CONTAINERS_SMALLVEC_H
+
+#include "../alloc.h"
+#include "../attributes.h"
+#include "../error.h"
+#include "../stdafx.h"
+#include "../types.h"
+
+#include <stddef.h>
+
+NOVA_HEADER_START
+
+/**
+ * Declare the type NAME##_t, a vector of TYPE with room for N elements inline, and its functions:
+ *
+ *  void     NAME##_init(NAME##_t* vec)
+ *  void     NAME##_init_with_allocator(NAME##_t* vec, nv_allocator_t* allocator)   'allocator' may be NULL
+ *  void     NAME##_destroy(NAME##_t* vec)
+ *  TYPE*    NAME##_data(NAME##_t* vec)
+ *  size_t   NAME##_size(const NAME##_t* vec)
+ *  size_t   NAME##_capacity(const NAME##_t* vec)
+ *  bool     NAME##_is_inline(const NAME##_t* vec)
+ *  nv_error NAME##_reserve(NAME##_t* vec, size_t new_capacity)
+ *  nv_error NAME##_push_back(NAME##_t* vec, TYPE value)
+ *  bool     NAME##_pop_back(NAME##_t* vec, TYPE* out)                              'out' may be NULL
+ *  TYPE*    NAME##_get(NAME##_t* vec, size_t i)                                     NULL if i is out of range
+ *  void     NAME##_clear(NAME##_t* vec)
+ *
+ * N must be atleast 1. A zero initialized NAME##_t is a valid, empty vector using the current allocator.
+ * Pointers from NAME##_data() and NAME##_get() are invalidated by pushes and reserves.
+ */
+#define NV_DECL_SMALLVEC(TYPE, NAME, N)                                                                                                                                       \
+  typedef struct NAME                                                                                                                                                         \
+  {                                                                                                                                                                           \
+    size_t          size;                                                                                                                                                     \
+    size_t          heap_capacity; /* 0 while the elements are inline */                                                                                                      \
+    nv_allocator_t* alloc;                                                                                                                                                    \
+    union                                                                                                                                                                     \
+    {                                                                                                                                                                         \
+      TYPE  inline_data[N];                                                                                                                                                   \
+      TYPE* heap;                                                                                                                                                             \
+    } storage;                                                                                                                                                                \
+  } NAME##_t;                                                                                                                                                                 \
+  static inline void NAME##_init_with_allocator(NAME##_t* vec, nv_allocator_t* allocator)                                                                                     \
+  {                                                                                                                                                                           \
+    vec->size          = 0;                                                                                                                                                   \
+    vec->heap_capacity = 0;                                                                                                                                                   \
+    vec->alloc         = allocator ? allocator : nv_alloc_current;                                                                                                            \
+  }                                                                                                                                                                           \
+  static inline void NAME##_init(NAME##_t* vec) { NAME##_init_with_allocator(vec, NULL); }                                                                                    \
+  static inline void NAME##_destroy(NAME##_t* vec)                                                                                                                            \
+  {                                                                                                                                                                           \
+    if (vec->heap_capacity) { nv_alloc_free(vec->alloc ? vec->alloc : nv_alloc_current, vec->storage.heap); }                                                                 \
+    vec->size          = 0;                                                                                                                                                   \
+    vec->heap_capacity = 0;                                                                                                                                                   \
+  }                                                                                                                                                                           \
+  static inline bool NAME##_is_inline(const NAME##_t* vec) { return vec->heap_capacity == 0; }                                                                                \
+  static inline TYPE* NAME##_data(NAME##_t* vec) { return vec->heap_capacity ? vec->storage.heap : vec->storage.inline_data; }                                                \
+  static inline size_t NAME##_size(const NAME##_t* vec) { return vec->size; }                                                                                                 \
+  static inline size_t NAME##_capacity(const NAME##_t* vec) { return vec->heap_capacity ? vec->heap_capacity : (size_t)(N); }                                                 \
+  static inline void NAME##_clear(NAME##_t* vec) { vec->size = 0; }                                                                                                           \
+  static inline nv_error NAME##_reserve(NAME##_t* vec, size_t new_capacity)                                                                                                   \
+  {                                                                                                                                                                           \
+    if (new_capacity <= NAME##_capacity(vec)) { return NV_ERROR_SUCCESS; }                                                                                                    \
+    if (!vec->alloc) { vec->alloc = nv_alloc_current; }                                                                                                                       \
+    TYPE* heap = NULL;                                                                                                                                                        \
+    if (vec->heap_capacity) { heap = (TYPE*)nv_alloc_realloc(vec->alloc, vec->storage.heap, new_capacity * sizeof(TYPE)); }                                                   \
+    else                                                                                                                                                                      \
+    {                                                                                                                                                                         \
+      /* spill, the inline elements are copied out before the union is overwritten with the heap pointer */                                                                   \
+      heap = (TYPE*)nv_alloc_zmalloc(vec->alloc, new_capacity * sizeof(TYPE));                                                                                                \
+      if (heap) { nv_memcpy_small(heap, vec->storage.inline_data, vec->size * sizeof(TYPE)); }                                                                                \
+    }                                                                                                                                                                         \
+    if (!heap) { return NV_ERROR_MALLOC_FAILED; }                                                                                                                             \
+    vec->storage.heap  = heap;                                                                                                                                                \
+    vec->heap_capacity = new_capacity;                                                                                                                                        \
+    return NV_ERROR_SUCCESS;                                                                                                                                                  \
+  }                                                                                                                                                                           \
+  static inline nv_error NAME##_push_back(NAME##_t* vec, TYPE value)                                                                                                          \
+  {                                                                                                                                                                           \
+    if (NV_UNLIKELY(vec->size == NAME##_capacity(vec)))                                                                                                                       \
+    {                                                                                                                                                                         \
+      nv_error e = NAME##_reserve(vec, vec->size * 2);                                                                                                                        \
+      if (e != NV_ERROR_SUCCESS) { return e; }                                                                                                                                \
+    }                                                                                                                                                                         \
+    NAME##_data(vec)[vec->size++] = value;                                                                                                                                    \
+    return NV_ERROR_SUCCESS;                                                                                                                                                  \
+  }                                                                                                                                                                           \
+  static inline bool NAME##_pop_back(NAME##_t* vec, TYPE* out)                                                                                                                \
+  {                                                                                                                                                                           \
+    if (vec->size == 0) { return false; }                                                                                                                                     \
+    vec->size--;                                                                                                                                                              \
+    if (out) { *out = NAME##_data(vec)[vec->size]; }                                                                                                                          \
+    return true;                                                                                                                                                              \
+  }                                                                                                                                                                           \
+  static inline TYPE* NAME##_get(NAME##_t* vec, size_t i)                                                                                                                     \
+  {                                                                                                                                                                           \
+    if (i >= vec->size) { return NULL; }                                                                                                                                      \
+    return &NAME##_data(vec)[i];                                                                                                                                              \
+  }
+
+NOVA_HEADER_END
+
+#endif // NV_STD_CONTAINERS_SMALLVEC_H
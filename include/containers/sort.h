@@ -0,0 +1,264 @@
+/*
+  MIT License
+
+  Copyright (c) 2025 Fouzan MD Ishaque (fouzanmdishaque@gmail.com)
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+/**
+ * Sorting for nv_list and plain arrays.
+ *
+ * NV_DECL_SORT() generates an introsort for a single element type, so the comparison is inlined instead of being
+ * called through a function pointer like qsort() does. It is already instantiated for the integer and float types.
+ *
+ * The radix sorts are for large lists of integer and float keys (or records with such a key), where they beat any
+ * comparison sort. nv_list_sort_strings() is an MSD radix sort for lists of C strings.
+ *
+ * When only part of the order is needed, nv_nth_element() and nv_list_top_k() don't sort the rest.
+ */
+
+#ifndef NV_STD_CONTAINERS_SORT_H
+#define NV_STD_CONTAINERS_SORT_H
+
+#include "../alloc.h"
+#include "../error.h"
+#include "../hash.h"
+#include "../stdafx.h"
+#include "../types.h"
+#include "list.h"
+
+#include <stddef.h>
+
+NOVA_HEADER_START
+
+#ifndef NV_SORT_INSERTION_THRESHOLD
+/* Partitions of this many elements or less are finished with an insertion sort. */
+#  define NV_SORT_INSERTION_THRESHOLD 16
+#endif
+
+#define NV_SORT_LESS(a, b) ((a) < (b))
+#define NV_SORT_GREATER(a, b) ((a) > (b))
+
+/**
+ * Declare NAME(TYPE* data, size_t count) and NAME##_list(nv_list_t* list), sorting with LESS(a, b).
+ * NAME##_nth_element(TYPE* data, size_t count, size_t nth) puts the element that would be at 'nth' after sorting
+ * there, with nothing greater before it and nothing less after it, in O(count) on average.
+ * LESS must be a strict weak ordering, it can be a function-like macro or a function.
+ * The sort is not stable.
+ */
+#define NV_DECL_SORT(TYPE, NAME, LESS)                                                                                                                                        \
+  static inline void NAME##_insertion(TYPE* data, size_t count)                                                                                                               \
+  {                                                                                                                                                                           \
+    for (size_t i = 1; i < count; i++)                                                                                                                                        \
+    {                                                                                                                                                                         \
+      TYPE   value = data[i];                                                                                                                                                 \
+      size_t j     = i;                                                                                                                                                       \
+      for (; j > 0 && LESS(value, data[j - 1]); j--) { data[j] = data[j - 1]; }                                                                                               \
+      data[j] = value;                                                                                                                                                        \
+    }                                                                                                                                                                         \
+  }                                                                                                                                                                           \
+  static inline void NAME##_sift_down(TYPE* data, size_t root, size_t count)                                                                                                  \
+  {                                                                                                                                                                           \
+    TYPE value = data[root];                                                                                                                                                  \
+    for (;;)                                                                                                                                                                  \
+    {                                                                                                                                                                         \
+      size_t child = (2 * root) + 1;                                                                                                                                          \
+      if (child >= count) { break; }                                                                                                                                          \
+      if (child + 1 < count && LESS(data[child], data[child + 1])) { child++; }                                                                                               \
+      if (!LESS(value, data[child])) { break; }                                                                                                                               \
+      data[root] = data[child];                                                                                                                                               \
+      root       = child;                                                                                                                                                     \
+    }                                                                                                                                                                         \
+    data[root] = value;                                                                                                                                                       \
+  }                                                                                                                                                                           \
+  static inline void NAME##_heapsort(TYPE* data, size_t count)                                                                                                                \
+  {                                                                                                                                                                           \
+    for (size_t i = count / 2; i-- > 0;) { NAME##_sift_down(data, i, count); }                                                                                                \
+    for (size_t i = count; i-- > 1;)                                                                                                                                          \
+    {                                                                                                                                                                         \
+      TYPE tmp = data[0];                                                                                                                                                     \
+      data[0]  = data[i];                                                                                                                                                     \
+      data[i]  = tmp;                                                                                                                                                         \
+      NAME##_sift_down(data, 0, i);                                                                                                                                           \
+    }                                                                                                                                                                         \
+  }                                                                                                                                                                           \
+  /* Hoare partition around a median of three, returns 'left': [0, left) <= pivot <= [left, count). Needs count >= 3. */                                                      \
+  static inline size_t NAME##_partition(TYPE* data, size_t count)                                                                                                             \
+  {                                                                                                                                                                           \
+    /* median of three, which also leaves sentinels at both ends for the partition */                                                                                         \
+    TYPE   tmp;                                                                                                                                                               \
+    size_t mid = count / 2;                                                                                                                                                   \
+    if (LESS(data[mid], data[0])) { tmp = data[mid], data[mid] = data[0], data[0] = tmp; }                                                                                    \
+    if (LESS(data[count - 1], data[mid])) { tmp = data[count - 1], data[count - 1] = data[mid], data[mid] = tmp; }                                                            \
+    if (LESS(data[mid], data[0])) { tmp = data[mid], data[mid] = data[0], data[0] = tmp; }                                                                                    \
+    const TYPE pivot = data[mid];                                                                                                                                             \
+    size_t     i     = 0;                                                                                                                                                     \
+    size_t     j     = count - 1;                                                                                                                                             \
+    for (;;)                                                                                                                                                                  \
+    {                                                                                                                                                                         \
+      while (LESS(data[i], pivot)) { i++; }                                                                                                                                   \
+      while (LESS(pivot, data[j])) { j--; }                                                                                                                                   \
+      if (i >= j) { break; }                                                                                                                                                  \
+      tmp = data[i], data[i] = data[j], data[j] = tmp;                                                                                                                        \
+      i++, j--;                                                                                                                                                               \
+    }                                                                                                                                                                         \
+    return j + 1;                                                                                                                                                             \
+  }                                                                                                                                                                           \
+  static inline void NAME##_introsort(TYPE* data, size_t count, size_t depth)                                                                                                 \
+  {                                                                                                                                                                           \
+    while (count > NV_SORT_INSERTION_THRESHOLD)                                                                                                                               \
+    {                                                                                                                                                                         \
+      if (depth-- == 0)                                                                                                                                                       \
+      {                                                                                                                                                                       \
+        NAME##_heapsort(data, count);                                                                                                                                         \
+        return;                                                                                                                                                               \
+      }                                                                                                                                                                       \
+      /* recurse into the smaller half, loop on the larger one */                                                                                                             \
+      const size_t left = NAME##_partition(data, count);                                                                                                                      \
+      if (left < count - left)                                                                                                                                                \
+      {                                                                                                                                                                       \
+        NAME##_introsort(data, left, depth);                                                                                                                                  \
+        data += left;                                                                                                                                                         \
+        count -= left;                                                                                                                                                        \
+      }                                                                                                                                                                       \
+      else                                                                                                                                                                    \
+      {                                                                                                                                                                       \
+        NAME##_introsort(data + left, count - left, depth);                                                                                                                   \
+        count = left;                                                                                                                                                         \
+      }                                                                                                                                                                       \
+    }                                                                                                                                                                         \
+    NAME##_insertion(data, count);                                                                                                                                            \
+  }                                                                                                                                                                           \
+  /* Introselect: only the side holding 'nth' is partitioned further, falling back to a heapsort of it if that takes too long. */                                             \
+  static inline void NAME##_nth_element(TYPE* data, size_t count, size_t nth)                                                                                                 \
+  {                                                                                                                                                                           \
+    if (nth >= count) { return; }                                                                                                                                             \
+    size_t depth = 0;                                                                                                                                                         \
+    for (size_t n = count; n > 1; n >>= 1U) { depth += 2; }                                                                                                                   \
+    while (count > NV_SORT_INSERTION_THRESHOLD)                                                                                                                               \
+    {                                                                                                                                                                         \
+      if (depth-- == 0)                                                                                                                                                       \
+      {                                                                                                                                                                       \
+        NAME##_heapsort(data, count);                                                                                                                                         \
+        return;                                                                                                                                                               \
+      }                                                                                                                                                                       \
+      const size_t left = NAME##_partition(data, count);                                                                                                                      \
+      if (nth < left) { count = left; }                                                                                                                                       \
+      else                                                                                                                                                                    \
+      {                                                                                                                                                                       \
+        data += left;                                                                                                                                                         \
+        count -= left;                                                                                                                                                        \
+        nth -= left;                                                                                                                                                          \
+      }                                                                                                                                                                       \
+    }                                                                                                                                                                         \
+    NAME##_insertion(data, count);                                                                                                                                            \
+  }                                                                                                                                                                           \
+  static inline void NAME(TYPE* data, size_t count)                                                                                                                           \
+  {                                                                                                                                                                           \
+    size_t depth = 0;                                                                                                                                                         \
+    for (size_t n = count; n > 1; n >>= 1U) { depth += 2; }                                                                                                                   \
+    NAME##_introsort(data, count, depth);                                                                                                                                     \
+  }                                                                                                                                                                           \
+  static inline void NAME##_list(nv_list_t* list)                                                                                                                             \
+  {                                                                                                                                                                           \
+    nv_assert_else_return(NOVA_CONT_IS_VALID(list) && list->type_size == sizeof(TYPE), );                                                                                     \
+    NAME((TYPE*)list->data, list->size);                                                                                                                                      \
+  }
+
+NV_DECL_SORT(u32, nv_sort_u32, NV_SORT_LESS)
+NV_DECL_SORT(u64, nv_sort_u64, NV_SORT_LESS)
+NV_DECL_SORT(i32, nv_sort_i32, NV_SORT_LESS)
+NV_DECL_SORT(i64, nv_sort_i64, NV_SORT_LESS)
+NV_DECL_SORT(f32, nv_sort_f32, NV_SORT_LESS)
+NV_DECL_SORT(f64, nv_sort_f64, NV_SORT_LESS)
+
+/**
+ * Sort 'count' elements of 'size' bytes with 'compare' (nv_compare_default if NULL), like qsort() but with the
+ * nv_compare_fn signature. Prefer a NV_DECL_SORT() instance when the element type is known.
+ */
+void nv_sort(void* data, size_t count, size_t size, nv_compare_fn compare, void* user_data);
+
+/**
+ * Introselect: move the element that would be at index 'nth' after nv_sort() there, with no greater element
+ * before it and no lesser one after it. O(count) on average, O(count log count) at worst. Does nothing if nth >= count.
+ */
+void nv_nth_element(void* data, size_t count, size_t size, size_t nth, nv_compare_fn compare, void* user_data);
+
+/**
+ * nv_nth_element() on a list. 'nth' must be less than the list's size.
+ */
+nv_error nv_list_nth_element(nv_list_t* list, size_t nth, nv_compare_fn compare, void* user_data);
+
+/**
+ * Replace the contents of 'out' (same type_size as 'list') with the min(k, size) greatest elements of 'list' by
+ * 'compare', greatest first. For the k smallest, reverse the comparison.
+ * Keeps a heap of k elements instead of sorting the list: O(size log k), and most elements only cost one comparison.
+ */
+nv_error nv_list_top_k(const nv_list_t* list, size_t k, nv_compare_fn compare, void* user_data, nv_list_t* out);
+
+typedef enum nv_sort_key
+{
+  NV_SORT_KEY_U32,
+  NV_SORT_KEY_U64,
+  NV_SORT_KEY_I32,
+  NV_SORT_KEY_I64,
+  NV_SORT_KEY_F32,
+  NV_SORT_KEY_F64,
+} nv_sort_key;
+
+/**
+ * LSD radix sort (8 bits per pass) of 'count' elements of 'stride' bytes, ordered by the key of type 'key'
+ * found 'key_offset' bytes into each element. The sort is stable.
+ * Passes where every key has the same digit are skipped, so small keys in wide types are cheap.
+ * Floats are ordered like the IEEE total order, -0.0 comes before 0.0 and NaNs go to the ends (by their sign).
+ * Needs a scratch buffer of count * stride bytes, allocated through 'allocator' (NULL for the default allocator).
+ */
+nv_error nv_radix_sort(void* data, size_t count, size_t stride, size_t key_offset, nv_sort_key key, nv_allocator_t* allocator);
+
+/**
+ * Radix sort a list whose elements are keys of type 'key'. The scratch buffer comes from the list's allocator.
+ */
+nv_error nv_list_radix_sort(nv_list_t* list, nv_sort_key key);
+
+/**
+ * Radix sort a list of records by the key of type 'key' at 'key_offset' in each record (use offsetof()).
+ */
+nv_error nv_list_radix_sort_by(nv_list_t* list, size_t key_offset, nv_sort_key key);
+
+/**
+ * nv_list_top_k() for a list of 'key' values (both lists must have the key's size), greatest first.
+ * With AVX2, vectors of elements are checked against the smallest kept element at once and skipped if none beat it.
+ * The order of NaNs is unspecified.
+ */
+nv_error nv_list_top_k_key(const nv_list_t* list, size_t k, nv_sort_key key, nv_list_t* out);
+
+#ifndef NV_SORT_STRING_INSERTION_THRESHOLD
+#  define NV_SORT_STRING_INSERTION_THRESHOLD 32
+#endif
+
+/**
+ * MSD radix sort of a list of 'const char*' (type_size must be sizeof(char*)), in strcmp() order.
+ * The strings themselves are not moved, only the pointers. Not stable.
+ */
+nv_error nv_list_sort_strings(nv_list_t* list);
+
+NOVA_HEADER_END
+
+#endif // NV_STD_CONTAINERS_SORT_H
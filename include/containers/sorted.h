@@ -0,0 +1,141 @@
+/*
+  MIT License
+
+  Copyright (c) 2025 Fouzan MD Ishaque (fouzanmdishaque@gmail.com)
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+/**
+ * Operations on sorted lists: binary search, k-way merging and intersection.
+ *
+ * Every function expects its inputs to already be sorted by the same ordering it is given (see sort.h).
+ * The generic versions take an nv_compare_fn (nv_compare_default if NULL), NV_DECL_SEARCH() generates typed
+ * binary searches with an inlined comparison.
+ *
+ * The binary searches are branchless: every step is a conditional move instead of a branch, so they don't
+ * suffer from branch mispredictions. The Eytzinger layout stores the same elements in breadth first order of
+ * the search tree, which keeps the first levels of every search in the same few cache lines and lets us
+ * prefetch the levels after.
+ */
+
+#ifndef NV_STD_CONTAINERS_SORTED_H
+#define NV_STD_CONTAINERS_SORTED_H
+
+#include "../error.h"
+#include "../hash.h"
+#include "../stdafx.h"
+#include "../types.h"
+#include "list.h"
+#include "sort.h"
+
+#include <stddef.h>
+
+NOVA_HEADER_START
+
+#ifndef NV_INTERSECT_GALLOP_RATIO
+/* Intersections gallop through the larger list when it is atleast this many times larger than the smaller one. */
+#  define NV_INTERSECT_GALLOP_RATIO 32
+#endif
+
+/**
+ * Declare NAME##_lower_bound(const TYPE* data, size_t count, TYPE key) and NAME##_upper_bound(), ordered by LESS(a, b).
+ * lower_bound returns the index of the first element not less than 'key', upper_bound the first one greater than 'key'.
+ * Both return 'count' if there is no such element.
+ */
+#define NV_DECL_SEARCH(TYPE, NAME, LESS)                                                                                                                                      \
+  static inline size_t NAME##_lower_bound(const TYPE* data, size_t count, TYPE key)                                                                                           \
+  {                                                                                                                                                                           \
+    if (count == 0) { return 0; }                                                                                                                                             \
+    const TYPE* base = data;                                                                                                                                                  \
+    while (count > 1)                                                                                                                                                         \
+    {                                                                                                                                                                         \
+      const size_t half = count / 2;                                                                                                                                          \
+      base              = LESS(base[half], key) ? base + half : base;                                                                                                         \
+      count -= half;                                                                                                                                                          \
+    }                                                                                                                                                                         \
+    return (size_t)(base - data) + (LESS(*base, key) ? 1 : 0);                                                                                                                \
+  }                                                                                                                                                                           \
+  static inline size_t NAME##_upper_bound(const TYPE* data, size_t count, TYPE key)                                                                                           \
+  {                                                                                                                                                                           \
+    if (count == 0) { return 0; }                                                                                                                                             \
+    const TYPE* base = data;                                                                                                                                                  \
+    while (count > 1)                                                                                                                                                         \
+    {                                                                                                                                                                         \
+      const size_t half = count / 2;                                                                                                                                          \
+      base              = LESS(key, base[half]) ? base : base + half;                                                                                                         \
+      count -= half;                                                                                                                                                          \
+    }                                                                                                                                                                         \
+    return (size_t)(base - data) + (LESS(key, *base) ? 0 : 1);                                                                                                                \
+  }
+
+NV_DECL_SEARCH(u32, nv_search_u32, NV_SORT_LESS)
+NV_DECL_SEARCH(u64, nv_search_u64, NV_SORT_LESS)
+NV_DECL_SEARCH(i32, nv_search_i32, NV_SORT_LESS)
+NV_DECL_SEARCH(i64, nv_search_i64, NV_SORT_LESS)
+NV_DECL_SEARCH(f32, nv_search_f32, NV_SORT_LESS)
+NV_DECL_SEARCH(f64, nv_search_f64, NV_SORT_LESS)
+
+/**
+ * The index of the first element in 'list' that is not less than 'key', nv_list_size(list) if there is none.
+ */
+size_t nv_list_lower_bound(const nv_list_t* list, const void* key, nv_compare_fn compare, void* user_data);
+
+/**
+ * The index of the first element in 'list' that is greater than 'key', nv_list_size(list) if there is none.
+ */
+size_t nv_list_upper_bound(const nv_list_t* list, const void* key, nv_compare_fn compare, void* user_data);
+
+/**
+ * Store the elements of the sorted list 'sorted' in Eytzinger (breadth first) order in 'layout', replacing its contents.
+ * 'layout' must be initialized with the same type size. It is indexed from 1, element 0 is unused (and zeroed),
+ * so it ends up with nv_list_size(sorted) + 1 elements.
+ */
+nv_error nv_list_eytzinger(const nv_list_t* NV_RESTRICT sorted, nv_list_t* NV_RESTRICT layout);
+
+/**
+ * Find the first element of an Eytzinger 'layout' that is not less than 'key'.
+ * Returns its index in 'layout' (use nv_list_get()), or 0 if every element is less than 'key'.
+ */
+size_t nv_eytzinger_lower_bound(const nv_list_t* layout, const void* key, nv_compare_fn compare, void* user_data);
+
+/**
+ * Merge 'count' sorted lists in to 'out', replacing its contents. 'out' must be initialized with the same type size,
+ * and must not be one of the inputs. The merge is stable, equal elements keep the order of the lists they came from.
+ * Uses a heap of the lists' heads, so merging k lists of n elements in total is O(n log k).
+ */
+nv_error nv_list_merge(const nv_list_t* const* lists, size_t count, nv_compare_fn compare, void* user_data, nv_list_t* out);
+
+/**
+ * Store the elements found in both 'a' and 'b' in 'out', replacing its contents. 'out' must be initialized with the
+ * same type size. An element that occurs m times in 'a' and n times in 'b' occurs min(m, n) times in 'out'.
+ * If one list is much larger (see NV_INTERSECT_GALLOP_RATIO), the smaller list gallops through it
+ * (exponential then binary search), otherwise the two are merged linearly.
+ */
+nv_error nv_list_intersect(const nv_list_t* a, const nv_list_t* b, nv_compare_fn compare, void* user_data, nv_list_t* out);
+
+/**
+ * nv_list_intersect() for sorted sets of u32 (strictly increasing, no duplicates), like lists of ids.
+ * Blocks of both lists are compared all against all with SSE2 or AVX2 instead of one element at a time.
+ */
+nv_error nv_list_intersect_u32(const nv_list_t* a, const nv_list_t* b, nv_list_t* out);
+
+NOVA_HEADER_END
+
+#endif // NV_STD_CONTAINERS_SORTED_H
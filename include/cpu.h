@@ -0,0 +1,79 @@
+/*
+  MIT License
+
+  Copyright (c) 2025 Fouzan MD Ishaque (fouzanmdishaque@gmail.com)
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+/**
+ * Runtime CPU feature detection, for picking SIMD code paths.
+ *
+ * Code for an instruction set the build was not compiled for goes in functions marked with NV_CPU_TARGET(),
+ * and is only called after checking nv_cpu_has(). Define NV_NO_SIMD to make nv_cpu_features() report nothing,
+ * which forces every scalar fallback.
+ */
+
+#ifndef NV_STD_CPU_H
+#define NV_STD_CPU_H
+
+#include "stdafx.h"
+
+#include <stdbool.h>
+
+NOVA_HEADER_START
+
+/* x86 SIMD paths are written with GCC/clang intrinsics and target attributes. */
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__)) && !defined(NV_NO_SIMD)
+#  define NV_CPU_X86_SIMD 1
+#  define NV_CPU_TARGET(isa) __attribute__((target(isa)))
+#else
+#  define NV_CPU_X86_SIMD 0
+#  define NV_CPU_TARGET(isa)
+#endif
+
+typedef enum nv_cpu_feature
+{
+  NV_CPU_SSE2     = 1 << 0,
+  NV_CPU_SSE41    = 1 << 1,
+  NV_CPU_POPCNT   = 1 << 2,
+  NV_CPU_AVX2     = 1 << 3,
+  NV_CPU_BMI2     = 1 << 4,
+  NV_CPU_AVX512F  = 1 << 5,
+  NV_CPU_AVX512BW = 1 << 6,
+  NV_CPU_AVX512VL = 1 << 7,
+} nv_cpu_feature;
+
+/**
+ * The nv_cpu_feature flags supported by this CPU (and OS). Detected once, then cached.
+ */
+unsigned nv_cpu_features(void);
+
+/**
+ * Are all of the flags in 'features' supported?
+ */
+static inline bool
+nv_cpu_has(unsigned features)
+{
+  return (nv_cpu_features() & features) == features;
+}
+
+NOVA_HEADER_END
+
+#endif // NV_STD_CPU_H
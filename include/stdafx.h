@@ -89,6 +89,19 @@ NOVA_HEADER_START
 #  endif
 #endif
 
+#ifndef NV_THREAD_LOCAL
+#  if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_THREADS__) // C11+
+#    define NV_THREAD_LOCAL _Thread_local
+#  elif defined(__GNUC__) || defined(__clang__)
+#    define NV_THREAD_LOCAL __thread
+#  elif defined(_MSC_VER)
+#    define NV_THREAD_LOCAL __declspec(thread)
+#  else
+#    pragma message("NV_THREAD_LOCAL not available")
+#    define NV_THREAD_LOCAL
+#  endif
+#endif
+
 #ifndef NV_USED
 #  if defined(__GNUC__) || defined(__clang__)
 #    define NV_USED __attribute__((__used__))
@@ -136,6 +149,55 @@ NOVA_HEADER_START
 #  define NV_MIN(a, b) ((a) < (b) ? (a) : (b))
 #endif
 
+/*
+ * Bit counting on 64 bit words. nv_ctz64() is the index of the lowest set bit, undefined for 0 (like the builtin).
+ */
+#if defined(__GNUC__) || defined(__clang__)
+static inline unsigned
+nv_ctz64(uint64_t x)
+{
+  return (unsigned)__builtin_ctzll(x);
+}
+static inline unsigned
+nv_popcount64(uint64_t x)
+{
+  return (unsigned)__builtin_popcountll(x);
+}
+#else
+#  if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+#    include <intrin.h>
+#  endif
+
+static inline unsigned
+nv_ctz64(uint64_t x)
+{
+#  if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+  unsigned long index;
+  _BitScanForward64(&index, x);
+  return (unsigned)index;
+#  else
+  // the lowest set bit times a de Bruijn sequence puts a unique pattern in the top 6 bits.
+  static const unsigned char positions[64]
+      = { 0,  1,  48, 2,  57, 49, 28, 3,  61, 58, 50, 42, 38, 29, 17, 4,  62, 55, 59, 36, 53, 51, 43, 22, 45, 39, 33, 30, 24, 18, 12, 5,
+          63, 47, 56, 27, 60, 41, 37, 16, 54, 35, 52, 21, 44, 32, 23, 11, 46, 26, 40, 15, 34, 20, 31, 10, 25, 14, 19, 9,  13, 8,  7,  6 };
+  return positions[((x & (~x + 1)) * 0x03F79D71B4CB0A89ULL) >> 58U];
+#  endif
+}
+
+static inline unsigned
+nv_popcount64(uint64_t x)
+{
+#  if defined(_MSC_VER) && defined(_M_X64)
+  return (unsigned)__popcnt64(x);
+#  else
+  x = x - ((x >> 1U) & 0x5555555555555555ULL);
+  x = (x & 0x3333333333333333ULL) + ((x >> 2U) & 0x3333333333333333ULL);
+  x = (x + (x >> 4U)) & 0x0F0F0F0F0F0F0F0FULL;
+  return (unsigned)((x * 0x0101010101010101ULL) >> 56U);
+#  endif
+}
+#endif
+
 /*
  * GNUC and builtin have protection from accidentally passing in pointers instead of stack arrays
  */
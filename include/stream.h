@@ -30,6 +30,7 @@ extern "C"
 {
 #endif
 
+#include "alloc.h"
 #include "error.h"
 #include "stdafx.h"
 #include "types.h"
@@ -75,6 +76,12 @@ extern "C"
    */
   nv_error nv_open_bufstream(size_t init_size, struct nv_stream** stm);
 
+  /**
+   * Same as nv_open_bufstream, but the stream and its buffer are allocated through 'allocator'.
+   * 'allocator' may be NULL for the default allocator. It must outlive the stream.
+   */
+  nv_error nv_open_bufstream_with_allocator(size_t init_size, nv_allocator_t* allocator, struct nv_stream** stm);
+
   /**
    * Open a pipe stream to a libc FILE.
    * All calls will just be passed over to libc.
@@ -85,6 +85,16 @@ void* nv_memmove(void* dst, const void* src, size_t sz) NOVA_ATTR_NONNULL(1, 2)
  */
 #define nv_memcpy nv_memmove
 
+/**
+ * Copy for small, non overlapping blocks (usually of a size known at compile time) in hot loops.
+ * nv_memcpy() is an out of line call, this compiles down to plain loads and stores where the compiler can manage it.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#  define nv_memcpy_small __builtin_memcpy
+#else
+#  define nv_memcpy_small nv_memmove
+#endif
+
 /**
  * Swap nbyte of memory between ptr1 and ptr2.
  * Returns the number of bytes swapped. Always nbyte unless you did something catostrophically wrong.
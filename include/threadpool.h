@@ -0,0 +1,93 @@
+/*
+  MIT License
+
+  Copyright (c) 2025 Fouzan MD Ishaque (fouzanmdishaque@gmail.com)
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+/**
+ * A fixed size pool of worker threads for data parallel work.
+ *
+ * Work is submitted as a batch of 'count' independent tasks, nv_thread_pool_run() returns once all of them are done.
+ * The calling thread works on the batch too, and tasks are handed out one at a time through an atomic counter,
+ * so uneven tasks balance themselves out.
+ *
+ * A pool runs one batch at a time, concurrent nv_thread_pool_run() calls on the same pool wait for each other.
+ * A batch submitted from inside a task runs serially on the calling thread instead of deadlocking.
+ *
+ * Threads are pthreads. Where those are not available (or NV_NO_THREADS is defined) every batch runs serially.
+ */
+
+#ifndef NV_STD_THREADPOOL_H
+#define NV_STD_THREADPOOL_H
+
+#include "error.h"
+#include "stdafx.h"
+
+#include <stddef.h>
+
+NOVA_HEADER_START
+
+#if defined(_WIN32) || defined(NV_NO_THREADS)
+#  define NV_THREAD_POOL_SERIAL
+#endif
+
+typedef struct nv_thread_pool nv_thread_pool_t;
+
+/**
+ * A single task of a batch. 'index' is in [0, count).
+ */
+typedef void (*nv_task_fn)(void* user_data, size_t index);
+
+/**
+ * The number of hardware threads, atleast 1.
+ */
+size_t nv_hardware_concurrency(void);
+
+/**
+ * Create a pool with 'num_threads' threads in total, the thread calling nv_thread_pool_run() included.
+ * 0 uses nv_hardware_concurrency().
+ */
+nv_error nv_thread_pool_create(size_t num_threads, nv_thread_pool_t** pool);
+
+/**
+ * Stop and join the workers. Must not be called while a batch is running.
+ */
+void nv_thread_pool_destroy(nv_thread_pool_t* pool);
+
+/**
+ * The shared pool, created with nv_hardware_concurrency() threads on first use and never destroyed.
+ * NULL if it could not be created, which every function here treats as a pool of one thread.
+ */
+nv_thread_pool_t* nv_thread_pool_default(void);
+
+/**
+ * Number of threads that work on a batch, the calling thread included.
+ */
+size_t nv_thread_pool_size(const nv_thread_pool_t* pool);
+
+/**
+ * Run fn(user_data, i) for every i in [0, count) and wait for all of them.
+ */
+void nv_thread_pool_run(nv_thread_pool_t* pool, size_t count, nv_task_fn fn, void* user_data);
+
+NOVA_HEADER_END
+
+#endif // NV_STD_THREADPOOL_H
@@ -0,0 +1,235 @@
+#include "../../include/allocators/budget.h"
+
+#include "../../include/alloc.h"
+#include "../../include/atomic.h"
+#include "../../include/error.h"
+#include "../../include/stdafx.h"
+#include "../../include/string.h"
+#include "../../include/types.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define HEADER_SIZE 16
+#define HEADER_TAG 0x4E564247U // "NVBG"
+
+typedef struct block_header
+{
+  size_t size;
+  u32    reallocating; // set while the block waits on an eviction to grow, it must not be freed by the callback
+  u32    tag;
+} block_header;
+
+NV_STATIC_ASSERT(sizeof(block_header) <= HEADER_SIZE, block_header_must_fit);
+
+/* Set while this thread is inside an eviction callback, so that the callback can not recurse into another eviction. */
+static NV_THREAD_LOCAL bool in_eviction = false;
+
+static inline void
+update_peak(nv_alloc_budget_t* budget, size_t used)
+{
+  size_t peak = nv_atomic_load(&budget->peak);
+  while (used > peak && !nv_atomic_cas(&budget->peak, peak, used)) {}
+}
+
+/**
+ * Charge 'cost' bytes if they fit in the budget.
+ */
+static inline bool
+try_charge(nv_alloc_budget_t* budget, size_t cost)
+{
+  const size_t limit = nv_atomic_load(&budget->limit);
+
+  size_t used = nv_atomic_load(&budget->used);
+  do
+  {
+    if (cost > limit || used > limit - cost) { return false; }
+  } while (!nv_atomic_cas(&budget->used, used, used + cost));
+
+  update_peak(budget, used + cost);
+  return true;
+}
+
+static inline void
+uncharge(nv_alloc_budget_t* budget, size_t cost)
+{
+  nv_atomic_sub(&budget->used, cost);
+}
+
+/**
+ * Charge 'cost' bytes, asking the eviction callback to make room until they fit.
+ */
+static bool
+charge(nv_alloc_budget_t* budget, size_t cost)
+{
+  if (NV_LIKELY(try_charge(budget, cost))) { return true; }
+
+  if (budget->evict && !in_eviction)
+  {
+    for (size_t round = 0; round < NV_ALLOC_BUDGET_MAX_EVICTIONS; round++)
+    {
+      const size_t limit  = nv_atomic_load(&budget->limit);
+      const size_t used   = nv_atomic_load(&budget->used);
+      const size_t needed = (used + cost > limit) ? used + cost - limit : 0;
+
+      nv_atomic_add(&budget->evictions, 1);
+
+      in_eviction           = true;
+      const size_t released = budget->evict(budget, needed, budget->user_data);
+      in_eviction           = false;
+
+      if (try_charge(budget, cost)) { return true; }
+      if (released == 0) { break; }
+    }
+  }
+
+  nv_atomic_add(&budget->failures, 1);
+  return false;
+}
+
+nv_error
+nv_alloc_budget_init(nv_allocator_t* parent, size_t limit, nv_alloc_budget_evict_fn evict, void* user_data, nv_alloc_budget_t* budget, nv_allocator_t* allocator)
+{
+  nv_assert_else_return(budget != NULL, NV_ERROR_INVALID_ARG);
+  nv_assert_else_return(allocator != NULL, NV_ERROR_INVALID_ARG);
+
+  nv_bzero(budget, sizeof(*budget));
+  budget->parent    = parent ? parent : NV_ALLOC_DEFAULT;
+  budget->evict     = evict;
+  budget->user_data = user_data;
+  nv_atomic_store(&budget->limit, limit);
+
+  *allocator         = nv_zinit(nv_allocator_t);
+  allocator->alloc   = nv_alloc_budget_zmalloc;
+  allocator->realloc = nv_alloc_budget_realloc;
+  allocator->free    = nv_alloc_budget_free;
+  allocator->ctx     = budget;
+
+  return NV_SUCCESS;
+}
+
+void*
+nv_alloc_budget_zmalloc(nv_allocator_t* self, size_t size)
+{
+  nv_alloc_budget_t* budget = (nv_alloc_budget_t*)self->ctx;
+
+  const size_t cost = nv_alloc_budget_block_cost(size);
+  if (!charge(budget, cost)) { return NULL; }
+
+  uchar* base = (uchar*)budget->parent->alloc(budget->parent, cost);
+  if (!base)
+  {
+    uncharge(budget, cost);
+    return NULL;
+  }
+
+  block_header* hdr = (block_header*)base;
+  hdr->size         = size;
+  hdr->tag          = HEADER_TAG;
+
+  return base + HEADER_SIZE;
+}
+
+void*
+nv_alloc_budget_realloc(nv_allocator_t* self, void* oldptr, size_t size)
+{
+  nv_alloc_budget_t* budget = (nv_alloc_budget_t*)self->ctx;
+
+  if (!oldptr) { return nv_alloc_budget_zmalloc(self, size); }
+
+  block_header* old_hdr = (block_header*)((uchar*)oldptr - HEADER_SIZE);
+  nv_assert_else_return(old_hdr->tag == HEADER_TAG, NULL);
+
+  const size_t old_size = old_hdr->size;
+
+  // only the growth is charged, a shrink is released after the parent succeeds.
+  if (size > old_size)
+  {
+    old_hdr->reallocating = 1;
+    const bool charged    = charge(budget, size - old_size);
+    old_hdr->reallocating = 0;
+    if (!charged) { return NULL; }
+  }
+
+  uchar* base = (uchar*)budget->parent->realloc(budget->parent, old_hdr, nv_alloc_budget_block_cost(size));
+  if (!base)
+  {
+    if (size > old_size) { uncharge(budget, size - old_size); }
+    return NULL;
+  }
+
+  if (size < old_size) { uncharge(budget, old_size - size); }
+
+  block_header* hdr = (block_header*)base;
+  hdr->size         = size;
+
+  return base + HEADER_SIZE;
+}
+
+void
+nv_alloc_budget_free(nv_allocator_t* self, void* ptr)
+{
+  nv_alloc_budget_t* budget = (nv_alloc_budget_t*)self->ctx;
+
+  if (!ptr) { return; }
+
+  block_header* hdr = (block_header*)((uchar*)ptr - HEADER_SIZE);
+  nv_assert_else_return(hdr->tag == HEADER_TAG, );
+
+  // an eviction callback tried to free the block that is being reallocated, keep it alive for the realloc.
+  if (NV_UNLIKELY(hdr->reallocating))
+  {
+    nv_log_error("eviction callback freed the block that is being reallocated, ignoring the free\n");
+    return;
+  }
+
+  uncharge(budget, nv_alloc_budget_block_cost(hdr->size));
+
+  hdr->tag = 0;
+  budget->parent->free(budget->parent, hdr);
+}
+
+void
+nv_alloc_budget_set_limit(nv_alloc_budget_t* budget, size_t limit)
+{
+  nv_assert_else_return(budget != NULL, );
+  nv_atomic_store(&budget->limit, limit);
+}
+
+size_t
+nv_alloc_budget_used(const nv_alloc_budget_t* budget)
+{
+  nv_assert_else_return(budget != NULL, 0);
+  return nv_atomic_load((nv_atomic_size*)&budget->used);
+}
+
+size_t
+nv_alloc_budget_available(const nv_alloc_budget_t* budget)
+{
+  nv_assert_else_return(budget != NULL, 0);
+
+  const size_t limit = nv_atomic_load((nv_atomic_size*)&budget->limit);
+  const size_t used  = nv_atomic_load((nv_atomic_size*)&budget->used);
+  return used < limit ? limit - used : 0;
+}
+
+size_t
+nv_alloc_budget_block_cost(size_t size)
+{
+  return size + HEADER_SIZE;
+}
+
+void
+nv_alloc_budget_usage(const nv_alloc_budget_t* budget, nv_alloc_budget_usage_t* out)
+{
+  nv_assert_else_return(budget != NULL && out != NULL, );
+
+  nv_alloc_budget_t* b = (nv_alloc_budget_t*)budget;
+
+  out->limit     = nv_atomic_load(&b->limit);
+  out->used      = nv_atomic_load(&b->used);
+  out->available = out->used < out->limit ? out->limit - out->used : 0;
+  out->peak      = nv_atomic_load(&b->peak);
+  out->evictions = nv_atomic_load(&b->evictions);
+  out->failures  = nv_atomic_load(&b->failures);
+}
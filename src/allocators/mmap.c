@@ -0,0 +1,334 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+/* mremap() */
+#  define _GNU_SOURCE
+#endif
+
+#include "../../include/allocators/mmap.h"
+
+#include "../../include/alloc.h"
+#include "../../include/error.h"
+#include "../../include/stdafx.h"
+#include "../../include/string.h"
+#include "../../include/types.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if !defined(_WIN32)
+#  include <sys/mman.h>
+#  include <unistd.h>
+#  define NV_MMAP_AVAILABLE 1
+#else
+#  define NV_MMAP_AVAILABLE 0
+#endif
+
+/**
+ * Every block has a header in front of it, the last 8 bytes of which is a tag telling us where the block came from.
+ * Mapped blocks have a 64 byte header so that the data stays cache line aligned.
+ * Fallback blocks only need to store the tag, 16 bytes keeps the fallback allocators alignment.
+ */
+#define MAPPED_HEADER_SIZE 64
+#define FALLBACK_HEADER_SIZE 16
+
+#define TAG_MAPPED 0x4E564D4150504544ULL   // "NVMAPPED"
+#define TAG_FALLBACK 0x4E5646414C4C4241ULL // "NVFALLBA"
+
+typedef struct mapped_header
+{
+  size_t map_size; // size of the entire mapping, header included
+  bool   hugetlb;  // backed by MAP_HUGETLB, so the mapping size must stay a multiple of the huge page size
+} mapped_header;
+
+NV_STATIC_ASSERT(sizeof(mapped_header) <= MAPPED_HEADER_SIZE - sizeof(u64), mapped_header_must_fit);
+
+static inline u64
+block_tag(const void* ptr)
+{
+  u64 tag = 0;
+  nv_memcpy(&tag, (const uchar*)ptr - sizeof(u64), sizeof(u64));
+  return tag;
+}
+
+static inline void
+block_set_tag(void* ptr, u64 tag)
+{
+  nv_memcpy((uchar*)ptr - sizeof(u64), &tag, sizeof(u64));
+}
+
+static inline size_t
+round_up(size_t value, size_t granule)
+{
+  return (value + granule - 1) & ~(granule - 1);
+}
+
+size_t
+nv_mmap_page_size(void)
+{
+#if NV_MMAP_AVAILABLE
+  static size_t cached = 0;
+  if (NV_UNLIKELY(cached == 0))
+  {
+    long sz = sysconf(_SC_PAGESIZE);
+    cached  = sz > 0 ? (size_t)sz : 4096;
+  }
+  return cached;
+#else
+  return 4096;
+#endif
+}
+
+#if NV_MMAP_AVAILABLE
+
+static inline void
+advise_huge(const nv_mmap_ctx_t* ctx, void* base, size_t size)
+{
+#  if defined(MADV_HUGEPAGE)
+  if ((ctx->flags & (NV_MMAP_TRANSPARENT_HUGE_PAGES | NV_MMAP_HUGETLB)) && size >= NV_MMAP_HUGE_PAGE_SIZE) { madvise(base, size, MADV_HUGEPAGE); }
+#  else
+  (void)ctx;
+  (void)base;
+  (void)size;
+#  endif
+}
+
+/**
+ * Map 'size' bytes, rounding up as needed. The actual size of the mapping is written to 'out_size'.
+ */
+static void*
+map_pages(const nv_mmap_ctx_t* ctx, size_t size, size_t* out_size, bool* out_hugetlb)
+{
+  *out_hugetlb = false;
+
+#  if defined(MAP_HUGETLB)
+  if (ctx->flags & NV_MMAP_HUGETLB)
+  {
+    size_t huge_size = round_up(size, NV_MMAP_HUGE_PAGE_SIZE);
+    void*  p         = mmap(NULL, huge_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (p != MAP_FAILED)
+    {
+      *out_size    = huge_size;
+      *out_hugetlb = true;
+      return p;
+    }
+    // no huge pages reserved, fall through to a regular mapping.
+  }
+#  endif
+
+  size_t map_size = round_up(size, nv_mmap_page_size());
+
+  if ((ctx->flags & (NV_MMAP_TRANSPARENT_HUGE_PAGES | NV_MMAP_HUGETLB)) && map_size >= NV_MMAP_HUGE_PAGE_SIZE)
+  {
+    /**
+     * The kernel can only back huge page aligned ranges with huge pages.
+     * Over-map by a huge page and trim the unaligned head and tail.
+     */
+    size_t over = map_size + NV_MMAP_HUGE_PAGE_SIZE;
+    uchar* p    = (uchar*)mmap(NULL, over, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) { return NULL; }
+
+    uchar* aligned = (uchar*)round_up((uintptr_t)p, NV_MMAP_HUGE_PAGE_SIZE);
+    size_t head    = (size_t)(aligned - p);
+    size_t tail    = over - head - map_size;
+    if (head) { munmap(p, head); }
+    if (tail) { munmap(aligned + map_size, tail); }
+
+    advise_huge(ctx, aligned, map_size);
+
+    *out_size = map_size;
+    return aligned;
+  }
+
+  void* p = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED) { return NULL; }
+
+  *out_size = map_size;
+  return p;
+}
+
+static void*
+mapped_alloc(const nv_mmap_ctx_t* ctx, size_t size)
+{
+  size_t map_size = 0;
+  bool   hugetlb  = false;
+  uchar* base     = (uchar*)map_pages(ctx, size + MAPPED_HEADER_SIZE, &map_size, &hugetlb);
+  if (!base) { return NULL; }
+
+  mapped_header* hdr = (mapped_header*)base;
+  hdr->map_size      = map_size;
+  hdr->hugetlb       = hugetlb;
+
+  // anonymous mappings are zero filled by the kernel, no memset needed.
+  void* ptr = base + MAPPED_HEADER_SIZE;
+  block_set_tag(ptr, TAG_MAPPED);
+  return ptr;
+}
+
+static void
+mapped_free(void* ptr)
+{
+  uchar*         base = (uchar*)ptr - MAPPED_HEADER_SIZE;
+  mapped_header* hdr  = (mapped_header*)base;
+  munmap(base, hdr->map_size);
+}
+
+static void*
+mapped_realloc(const nv_mmap_ctx_t* ctx, void* ptr, size_t size)
+{
+  uchar*         base     = (uchar*)ptr - MAPPED_HEADER_SIZE;
+  mapped_header* hdr      = (mapped_header*)base;
+  const size_t   old_size = hdr->map_size;
+  const size_t   granule  = hdr->hugetlb ? (size_t)NV_MMAP_HUGE_PAGE_SIZE : nv_mmap_page_size();
+  const size_t   new_size = round_up(size + MAPPED_HEADER_SIZE, granule);
+
+  if (new_size == old_size) { return ptr; }
+
+#  if defined(__linux__) && defined(MREMAP_MAYMOVE)
+  {
+    // the kernel moves the page table entries, the data is never copied.
+    uchar* p = (uchar*)mremap(base, old_size, new_size, MREMAP_MAYMOVE);
+    if (p != MAP_FAILED)
+    {
+      ((mapped_header*)p)->map_size = new_size;
+      if (new_size > old_size && !hdr->hugetlb) { advise_huge(ctx, p, new_size); }
+      return p + MAPPED_HEADER_SIZE;
+    }
+  }
+#  endif
+
+  if (new_size < old_size)
+  {
+    // give the tail back to the kernel, the block stays where it is.
+    munmap(base + new_size, old_size - new_size);
+    hdr->map_size = new_size;
+    return ptr;
+  }
+
+  // no mremap, map a new block and copy over.
+  void* new_ptr = mapped_alloc(ctx, size);
+  if (!new_ptr) { return NULL; }
+  nv_memcpy(new_ptr, ptr, old_size - MAPPED_HEADER_SIZE);
+  mapped_free(ptr);
+  return new_ptr;
+}
+
+#endif // NV_MMAP_AVAILABLE
+
+static void*
+fallback_alloc(const nv_mmap_ctx_t* ctx, size_t size)
+{
+  uchar* base = (uchar*)ctx->fallback->alloc(ctx->fallback, size + FALLBACK_HEADER_SIZE);
+  if (!base) { return NULL; }
+
+  void* ptr = base + FALLBACK_HEADER_SIZE;
+  block_set_tag(ptr, TAG_FALLBACK);
+  return ptr;
+}
+
+static void
+fallback_free(const nv_mmap_ctx_t* ctx, void* ptr)
+{
+  ctx->fallback->free(ctx->fallback, (uchar*)ptr - FALLBACK_HEADER_SIZE);
+}
+
+nv_error
+nv_mmap_allocator_init(unsigned flags, size_t threshold, nv_allocator_t* fallback, nv_mmap_ctx_t* ctx, nv_allocator_t* allocator)
+{
+  nv_assert_else_return(ctx != NULL, NV_ERROR_INVALID_ARG);
+  nv_assert_else_return(allocator != NULL, NV_ERROR_INVALID_ARG);
+
+  ctx->fallback  = fallback ? fallback : NV_ALLOC_DEFAULT;
+  ctx->threshold = threshold ? threshold : NV_MMAP_DEFAULT_THRESHOLD;
+  ctx->flags     = flags;
+
+  *allocator         = nv_zinit(nv_allocator_t);
+  allocator->alloc   = nv_mmap_zmalloc;
+  allocator->realloc = nv_mmap_realloc;
+  allocator->free    = nv_mmap_free;
+  allocator->ctx     = ctx;
+
+  return NV_SUCCESS;
+}
+
+void*
+nv_mmap_zmalloc(nv_allocator_t* self, size_t size)
+{
+  const nv_mmap_ctx_t* ctx = (const nv_mmap_ctx_t*)self->ctx;
+
+#if NV_MMAP_AVAILABLE
+  if (size >= ctx->threshold) { return mapped_alloc(ctx, size); }
+#endif
+
+  return fallback_alloc(ctx, size);
+}
+
+void*
+nv_mmap_realloc(nv_allocator_t* self, void* oldptr, size_t size)
+{
+  const nv_mmap_ctx_t* ctx = (const nv_mmap_ctx_t*)self->ctx;
+
+  if (!oldptr) { return nv_mmap_zmalloc(self, size); }
+
+#if NV_MMAP_AVAILABLE
+  if (block_tag(oldptr) == TAG_MAPPED) { return mapped_realloc(ctx, oldptr, size); }
+
+  if (size >= ctx->threshold)
+  {
+    // the block grew past the threshold, move it into its own mapping.
+    void* new_ptr = mapped_alloc(ctx, size);
+    if (!new_ptr) { return NULL; }
+
+    /**
+     * The allocator interface does not tell us the size of the old block, it is below 'threshold' bytes though.
+     * Reallocating it to 'threshold' first guarantees that copying 'threshold' bytes stays in bounds.
+     */
+    uchar* grown = (uchar*)ctx->fallback->realloc(ctx->fallback, (uchar*)oldptr - FALLBACK_HEADER_SIZE, ctx->threshold + FALLBACK_HEADER_SIZE);
+    if (!grown)
+    {
+      mapped_free(new_ptr);
+      return NULL;
+    }
+    nv_memcpy(new_ptr, grown + FALLBACK_HEADER_SIZE, ctx->threshold);
+    ctx->fallback->free(ctx->fallback, grown);
+    return new_ptr;
+  }
+#endif
+
+  nv_assert_else_return(block_tag(oldptr) == TAG_FALLBACK, NULL);
+
+  uchar* base = (uchar*)ctx->fallback->realloc(ctx->fallback, (uchar*)oldptr - FALLBACK_HEADER_SIZE, size + FALLBACK_HEADER_SIZE);
+  if (!base) { return NULL; }
+  return base + FALLBACK_HEADER_SIZE;
+}
+
+void
+nv_mmap_free(nv_allocator_t* self, void* ptr)
+{
+  const nv_mmap_ctx_t* ctx = (const nv_mmap_ctx_t*)self->ctx;
+
+  if (!ptr) { return; }
+
+#if NV_MMAP_AVAILABLE
+  if (block_tag(ptr) == TAG_MAPPED)
+  {
+    mapped_free(ptr);
+    return;
+  }
+#endif
+
+  nv_assert_else_return(block_tag(ptr) == TAG_FALLBACK, );
+  fallback_free(ctx, ptr);
+}
+
+bool
+nv_mmap_is_mapped(const void* ptr)
+{
+  return ptr && block_tag(ptr) == TAG_MAPPED;
+}
+
+size_t
+nv_mmap_mapped_size(const void* ptr)
+{
+  if (!nv_mmap_is_mapped(ptr)) { return 0; }
+  return ((const mapped_header*)((const uchar*)ptr - MAPPED_HEADER_SIZE))->map_size;
+}
@@ -0,0 +1,346 @@
+#include "../../include/allocators/stats.h"
+
+#include "../../include/alloc.h"
+#include "../../include/atomic.h"
+#include "../../include/error.h"
+#include "../../include/stdafx.h"
+#include "../../include/string.h"
+#include "../../include/types.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define HEADER_SIZE 16
+#define HEADER_TAG 0x4E565354U // "NVST"
+
+typedef struct block_header
+{
+  size_t size;
+  u32    site;
+  u32    tag;
+} block_header;
+
+NV_STATIC_ASSERT(sizeof(block_header) <= HEADER_SIZE, block_header_must_fit);
+
+static nv_atomic_uint               next_shard   = 0;
+static NV_THREAD_LOCAL unsigned int thread_shard = 0; // shard index + 1, 0 if not assigned yet
+
+static inline nv_alloc_stats_shard_t*
+current_shard(nv_alloc_stats_t* stats)
+{
+  if (NV_UNLIKELY(thread_shard == 0)) { thread_shard = (nv_atomic_add(&next_shard, 1) % NV_ALLOC_STATS_SHARDS) + 1; }
+  return &stats->shards[thread_shard - 1];
+}
+
+static inline size_t
+size_bucket(size_t size)
+{
+  if (size == 0) { return 0; }
+
+  size_t bits = 0;
+#if defined(__GNUC__) || defined(__clang__)
+  bits = (sizeof(unsigned long long) * 8) - (size_t)__builtin_clzll((unsigned long long)size);
+#else
+  while (size) { size >>= 1U, bits++; }
+#endif
+  return NV_MIN(bits, (size_t)NV_ALLOC_STATS_BUCKETS - 1);
+}
+
+/**
+ * Track the live bytes of the shard, flushing them into the shared counter (and updating the peak)
+ * once they drift too far from what was last flushed.
+ */
+static inline void
+account_live(nv_alloc_stats_t* stats, nv_alloc_stats_shard_t* shard, long delta)
+{
+  long pending = nv_atomic_add(&shard->unflushed, delta) + delta;
+  if (NV_LIKELY(pending < NV_ALLOC_STATS_PEAK_GRANULARITY && pending > -NV_ALLOC_STATS_PEAK_GRANULARITY)) { return; }
+
+  long taken = nv_atomic_exchange(&shard->unflushed, 0);
+  long live  = nv_atomic_add(&stats->flushed_live, taken) + taken;
+  long peak  = nv_atomic_load(&stats->peak);
+  while (live > peak && !nv_atomic_cas(&stats->peak, peak, live)) {}
+}
+
+static inline size_t
+site_key(const char* file, int line)
+{
+  u64 key = (u64)(uintptr_t)file ^ ((u64)(unsigned)line * 0x9E3779B97F4A7C15ULL);
+  key ^= key >> 29U;
+  key *= 0xBF58476D1CE4E5B9ULL;
+  key ^= key >> 32U;
+  return (size_t)key | 1U; // even keys are never a site, see SITE_FREE and SITE_CLAIMED
+}
+
+#define SITE_FREE    ((size_t)0)
+#define SITE_CLAIMED ((size_t)2) // file and line are being written
+
+/**
+ * Find (or claim) the slot of the call site of the allocation in flight.
+ * Returns 0, the unknown site, if call sites are not tracked, the site is not known or the table is full.
+ */
+static u32
+current_site(nv_alloc_stats_t* stats)
+{
+  const char* file = nv_alloc_current_site.file;
+  if (!stats->sites || !file) { return 0; }
+
+  const int    line = nv_alloc_current_site.line;
+  const size_t key  = site_key(file, line);
+
+  // slot 0 is the unknown site, probe the rest.
+  for (size_t probe = 0; probe < NV_ALLOC_STATS_MAX_SITES - 1; probe++)
+  {
+    size_t                 index = 1 + ((key + probe) % (NV_ALLOC_STATS_MAX_SITES - 1));
+    nv_alloc_stats_site_t* site  = &stats->sites[index];
+
+    size_t existing = nv_atomic_load(&site->key);
+    if (existing == SITE_FREE && nv_atomic_cas(&site->key, existing, SITE_CLAIMED))
+    {
+      // the key is only published once file and line are written, so whoever sees it can read them.
+      site->line = line;
+      site->file = file;
+      nv_atomic_store(&site->key, key);
+      return (u32)index;
+    }
+
+    // another thread took the slot first and may still be filling it in, it could be for this same site.
+    do { existing = nv_atomic_load(&site->key); } while (existing == SITE_CLAIMED);
+    if (existing == key) { return (u32)index; }
+  }
+
+  return 0;
+}
+
+nv_error
+nv_alloc_stats_init(nv_allocator_t* parent, bool track_sites, nv_alloc_stats_t* stats, nv_allocator_t* allocator)
+{
+  nv_assert_else_return(stats != NULL, NV_ERROR_INVALID_ARG);
+  nv_assert_else_return(allocator != NULL, NV_ERROR_INVALID_ARG);
+
+  nv_bzero(stats, sizeof(*stats));
+  stats->parent = parent ? parent : NV_ALLOC_DEFAULT;
+
+  if (track_sites)
+  {
+    stats->sites = (nv_alloc_stats_site_t*)stats->parent->alloc(stats->parent, NV_ALLOC_STATS_MAX_SITES * sizeof(nv_alloc_stats_site_t));
+    nv_assert_else_return(stats->sites != NULL, NV_ERROR_MALLOC_FAILED);
+  }
+
+  *allocator         = nv_zinit(nv_allocator_t);
+  allocator->alloc   = nv_alloc_stats_zmalloc;
+  allocator->realloc = nv_alloc_stats_realloc;
+  allocator->free    = nv_alloc_stats_free;
+  allocator->ctx     = stats;
+
+  return NV_SUCCESS;
+}
+
+void
+nv_alloc_stats_destroy(nv_alloc_stats_t* stats)
+{
+  if (!stats) { return; }
+  if (stats->sites) { stats->parent->free(stats->parent, stats->sites); }
+  stats->sites = NULL;
+}
+
+void*
+nv_alloc_stats_zmalloc(nv_allocator_t* self, size_t size)
+{
+  nv_alloc_stats_t* stats = (nv_alloc_stats_t*)self->ctx;
+
+  uchar* base = (uchar*)stats->parent->alloc(stats->parent, size + HEADER_SIZE);
+  if (!base) { return NULL; }
+
+  block_header* hdr = (block_header*)base;
+  hdr->size         = size;
+  hdr->site         = current_site(stats);
+  hdr->tag          = HEADER_TAG;
+
+  nv_alloc_stats_shard_t* shard = current_shard(stats);
+  nv_atomic_add(&shard->allocs, 1);
+  nv_atomic_add(&shard->bytes_allocated, size);
+  nv_atomic_add(&shard->histogram[size_bucket(size)], 1);
+  account_live(stats, shard, (long)size);
+
+  if (stats->sites)
+  {
+    nv_atomic_add(&stats->sites[hdr->site].allocs, 1);
+    nv_atomic_add(&stats->sites[hdr->site].live_bytes, size);
+  }
+
+  return base + HEADER_SIZE;
+}
+
+void*
+nv_alloc_stats_realloc(nv_allocator_t* self, void* oldptr, size_t size)
+{
+  nv_alloc_stats_t* stats = (nv_alloc_stats_t*)self->ctx;
+
+  if (!oldptr) { return nv_alloc_stats_zmalloc(self, size); }
+
+  block_header* old_hdr = (block_header*)((uchar*)oldptr - HEADER_SIZE);
+  nv_assert_else_return(old_hdr->tag == HEADER_TAG, NULL);
+
+  const size_t old_size = old_hdr->size;
+  const u32    old_site = old_hdr->site;
+
+  // a realloc with a known call site moves the block to that site, otherwise it stays where it was allocated.
+  const u32 new_site = nv_alloc_current_site.file ? current_site(stats) : old_site;
+
+  uchar* base = (uchar*)stats->parent->realloc(stats->parent, old_hdr, size + HEADER_SIZE);
+  if (!base) { return NULL; }
+
+  block_header* hdr = (block_header*)base;
+  hdr->size         = size;
+  hdr->site         = new_site;
+
+  nv_alloc_stats_shard_t* shard = current_shard(stats);
+  nv_atomic_add(&shard->reallocs, 1);
+  nv_atomic_add(&shard->bytes_allocated, size);
+  nv_atomic_add(&shard->bytes_freed, old_size);
+  nv_atomic_add(&shard->histogram[size_bucket(size)], 1);
+  account_live(stats, shard, (long)size - (long)old_size);
+
+  if (stats->sites)
+  {
+    nv_atomic_sub(&stats->sites[old_site].live_bytes, old_size);
+    nv_atomic_add(&stats->sites[new_site].live_bytes, size);
+  }
+
+  return base + HEADER_SIZE;
+}
+
+void
+nv_alloc_stats_free(nv_allocator_t* self, void* ptr)
+{
+  nv_alloc_stats_t* stats = (nv_alloc_stats_t*)self->ctx;
+
+  if (!ptr) { return; }
+
+  block_header* hdr = (block_header*)((uchar*)ptr - HEADER_SIZE);
+  nv_assert_else_return(hdr->tag == HEADER_TAG, );
+
+  nv_alloc_stats_shard_t* shard = current_shard(stats);
+  nv_atomic_add(&shard->frees, 1);
+  nv_atomic_add(&shard->bytes_freed, hdr->size);
+  account_live(stats, shard, -(long)hdr->size);
+
+  if (stats->sites) { nv_atomic_sub(&stats->sites[hdr->site].live_bytes, hdr->size); }
+
+  hdr->tag = 0;
+  stats->parent->free(stats->parent, hdr);
+}
+
+void
+nv_alloc_stats_snapshot(const nv_alloc_stats_t* stats, nv_alloc_stats_snapshot_t* out)
+{
+  nv_assert_else_return(stats != NULL && out != NULL, );
+
+  nv_bzero(out, sizeof(*out));
+
+  size_t bytes_freed = 0;
+  for (size_t i = 0; i < NV_ALLOC_STATS_SHARDS; i++)
+  {
+    nv_alloc_stats_shard_t* shard = (nv_alloc_stats_shard_t*)&stats->shards[i];
+
+    out->allocs += nv_atomic_load(&shard->allocs);
+    out->reallocs += nv_atomic_load(&shard->reallocs);
+    out->frees += nv_atomic_load(&shard->frees);
+    out->total_bytes_allocated += nv_atomic_load(&shard->bytes_allocated);
+    bytes_freed += nv_atomic_load(&shard->bytes_freed);
+    for (size_t b = 0; b < NV_ALLOC_STATS_BUCKETS; b++) { out->histogram[b] += nv_atomic_load(&shard->histogram[b]); }
+  }
+
+  out->live_bytes  = out->total_bytes_allocated - bytes_freed;
+  out->live_blocks = out->allocs - out->frees;
+
+  long peak       = nv_atomic_load((nv_atomic_long*)&stats->peak);
+  out->peak_bytes = NV_MAX(out->live_bytes, (size_t)NV_MAX(peak, 0L));
+}
+
+static int
+compare_site_live_bytes(const void* a, const void* b)
+{
+  size_t la = ((const nv_alloc_site_stats_t*)a)->live_bytes;
+  size_t lb = ((const nv_alloc_site_stats_t*)b)->live_bytes;
+  return (la < lb) - (la > lb);
+}
+
+size_t
+nv_alloc_stats_sites(const nv_alloc_stats_t* stats, nv_alloc_site_stats_t* out, size_t max)
+{
+  nv_assert_else_return(stats != NULL, 0);
+  if (!stats->sites || max == 0) { return 0; }
+
+  nv_alloc_site_stats_t* all = (nv_alloc_site_stats_t*)stats->parent->alloc(stats->parent, NV_ALLOC_STATS_MAX_SITES * sizeof(nv_alloc_site_stats_t));
+  nv_assert_else_return(all != NULL, 0);
+
+  size_t count = 0;
+  for (size_t i = 0; i < NV_ALLOC_STATS_MAX_SITES; i++)
+  {
+    nv_alloc_stats_site_t* site   = (nv_alloc_stats_site_t*)&stats->sites[i];
+    size_t                 allocs = nv_atomic_load(&site->allocs);
+
+    // the unknown site has no key, it is only reported if something was counted against it.
+    if (i == 0 ? allocs == 0 : (nv_atomic_load(&site->key) & 1U) == 0) { continue; }
+
+    all[count].file       = i == 0 ? NULL : site->file;
+    all[count].line       = i == 0 ? 0 : site->line;
+    all[count].allocs     = allocs;
+    all[count].live_bytes = nv_atomic_load(&site->live_bytes);
+    count++;
+  }
+
+  qsort(all, count, sizeof(nv_alloc_site_stats_t), compare_site_live_bytes);
+
+  count = NV_MIN(count, max);
+  nv_memcpy(out, all, count * sizeof(nv_alloc_site_stats_t));
+
+  stats->parent->free(stats->parent, all);
+  return count;
+}
+
+void
+nv_alloc_stats_dump(const nv_alloc_stats_t* stats, size_t max_sites, FILE* f)
+{
+  nv_assert_else_return(stats != NULL && f != NULL, );
+
+  nv_alloc_stats_snapshot_t snap = nv_zinit(nv_alloc_stats_snapshot_t);
+  nv_alloc_stats_snapshot(stats, &snap);
+
+  fprintf(f, "live: %zu bytes in %zu blocks, peak: %zu bytes\n", snap.live_bytes, snap.live_blocks, snap.peak_bytes);
+  fprintf(f, "calls: %zu allocs, %zu reallocs, %zu frees, %zu bytes requested in total\n", snap.allocs, snap.reallocs, snap.frees, snap.total_bytes_allocated);
+
+  fprintf(f, "sizes:\n");
+  for (size_t b = 0; b < NV_ALLOC_STATS_BUCKETS; b++)
+  {
+    if (snap.histogram[b] == 0) { continue; }
+    if (b == 0) { fprintf(f, "  %20s : %zu\n", "0", snap.histogram[b]); }
+    else
+    {
+      fprintf(f, "  %9zu..%-9zu : %zu\n", (size_t)1 << (b - 1), ((size_t)1 << b) - 1, snap.histogram[b]);
+    }
+  }
+
+  if (!stats->sites || max_sites == 0) { return; }
+
+  nv_alloc_site_stats_t* sites = (nv_alloc_site_stats_t*)stats->parent->alloc(stats->parent, max_sites * sizeof(nv_alloc_site_stats_t));
+  if (!sites) { return; }
+
+  size_t nsites = nv_alloc_stats_sites(stats, sites, max_sites);
+  fprintf(f, "call sites:\n");
+  for (size_t i = 0; i < nsites; i++)
+  {
+    if (sites[i].file) { fprintf(f, "  %s:%d : %zu live bytes, %zu allocs\n", nv_basename(sites[i].file), sites[i].line, sites[i].live_bytes, sites[i].allocs); }
+    else
+    {
+      fprintf(f, "  (unknown) : %zu live bytes, %zu allocs\n", sites[i].live_bytes, sites[i].allocs);
+    }
+  }
+
+  stats->parent->free(stats->parent, sites);
+}
@@ -0,0 +1,578 @@
+#include "../../include/allocators/trace.h"
+
+#include "../../include/alloc.h"
+#include "../../include/allocators/mmap.h"
+#include "../../include/atomic.h"
+#include "../../include/containers/list.h"
+#include "../../include/error.h"
+#include "../../include/stdafx.h"
+#include "../../include/stream.h"
+#include "../../include/string.h"
+#include "../../include/types.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#define TRACE_MAGIC "NVAT"
+#define TRACE_MAGIC_LEN 4
+
+#define OP_ALLOC 'a'
+#define OP_REALLOC 'r'
+#define OP_FREE 'f'
+
+/* op byte + atmost 3 varints of 10 bytes each */
+#define MAX_RECORD_SIZE (1 + 3 * 10)
+
+static inline size_t
+put_varint(uchar* dst, u64 value)
+{
+  size_t n = 0;
+  while (value >= 0x80)
+  {
+    dst[n++] = (uchar)(value | 0x80);
+    value >>= 7U;
+  }
+  dst[n++] = (uchar)value;
+  return n;
+}
+
+static inline u64
+zigzag_encode(i64 value)
+{
+  return ((u64)value << 1U) ^ (u64)(value >> 63);
+}
+
+static inline i64
+zigzag_decode(u64 value)
+{
+  return (i64)(value >> 1U) ^ -(i64)(value & 1U);
+}
+
+static inline size_t
+put_ptr(nv_alloc_trace_t* trace, uchar* dst, const void* ptr)
+{
+  u64 value       = (u64)(uintptr_t)ptr;
+  i64 delta       = (i64)(value - trace->last_ptr);
+  trace->last_ptr = value;
+  return put_varint(dst, zigzag_encode(delta));
+}
+
+// set while this thread holds a trace lock, so that allocations the stream makes while writing don't spin on it.
+static NV_THREAD_LOCAL bool recording = false;
+
+/* Take the lock of 'trace', false if this thread is already writing a record and the call should not be recorded. */
+static inline bool
+trace_lock(nv_alloc_trace_t* trace)
+{
+  if (NV_UNLIKELY(recording)) { return false; }
+  while (nv_atomic_exchange(&trace->lock, 1) != 0) {}
+  recording = true;
+  return true;
+}
+
+static inline void
+trace_unlock(nv_alloc_trace_t* trace)
+{
+  recording = false;
+  nv_atomic_store(&trace->lock, 0);
+}
+
+static void
+write_record(nv_alloc_trace_t* trace, uchar op, const void* old_ptr, size_t size, const void* new_ptr)
+{
+  uchar  record[MAX_RECORD_SIZE];
+  size_t n = 0;
+
+  record[n++] = op;
+  if (op != OP_ALLOC) { n += put_ptr(trace, record + n, old_ptr); }
+  if (op != OP_FREE)
+  {
+    n += put_varint(record + n, (u64)size);
+    n += put_ptr(trace, record + n, new_ptr);
+  }
+
+  nv_stream_write(record, n, trace->stream);
+  trace->records++;
+}
+
+nv_error
+nv_alloc_trace_init(nv_allocator_t* parent, nv_stream_t* stream, nv_alloc_trace_t* trace, nv_allocator_t* allocator)
+{
+  nv_assert_else_return(stream != NULL, NV_ERROR_INVALID_ARG);
+  nv_assert_else_return(trace != NULL, NV_ERROR_INVALID_ARG);
+  nv_assert_else_return(allocator != NULL, NV_ERROR_INVALID_ARG);
+
+  nv_bzero(trace, sizeof(*trace));
+  trace->parent = parent ? parent : NV_ALLOC_DEFAULT;
+  trace->stream = stream;
+
+  const uchar version = NV_ALLOC_TRACE_VERSION;
+  if (nv_stream_write(TRACE_MAGIC, TRACE_MAGIC_LEN, stream) != TRACE_MAGIC_LEN || nv_stream_write(&version, 1, stream) != 1) { return NV_ERROR_IO_ERROR; }
+
+  *allocator         = nv_zinit(nv_allocator_t);
+  allocator->alloc   = nv_alloc_trace_zmalloc;
+  allocator->realloc = nv_alloc_trace_realloc;
+  allocator->free    = nv_alloc_trace_free;
+  allocator->ctx     = trace;
+
+  return NV_SUCCESS;
+}
+
+void*
+nv_alloc_trace_zmalloc(nv_allocator_t* self, size_t size)
+{
+  nv_alloc_trace_t* trace = (nv_alloc_trace_t*)self->ctx;
+
+  if (!trace_lock(trace)) { return trace->parent->alloc(trace->parent, size); }
+  void* ptr = trace->parent->alloc(trace->parent, size);
+  write_record(trace, OP_ALLOC, NULL, size, ptr);
+  trace_unlock(trace);
+
+  return ptr;
+}
+
+void*
+nv_alloc_trace_realloc(nv_allocator_t* self, void* oldptr, size_t size)
+{
+  nv_alloc_trace_t* trace = (nv_alloc_trace_t*)self->ctx;
+
+  if (!trace_lock(trace)) { return trace->parent->realloc(trace->parent, oldptr, size); }
+  void* ptr = trace->parent->realloc(trace->parent, oldptr, size);
+  write_record(trace, OP_REALLOC, oldptr, size, ptr);
+  trace_unlock(trace);
+
+  return ptr;
+}
+
+void
+nv_alloc_trace_free(nv_allocator_t* self, void* ptr)
+{
+  nv_alloc_trace_t* trace = (nv_alloc_trace_t*)self->ctx;
+
+  if (!ptr) { return; }
+
+  if (!trace_lock(trace))
+  {
+    trace->parent->free(trace->parent, ptr);
+    return;
+  }
+  write_record(trace, OP_FREE, ptr, 0, NULL);
+  trace->parent->free(trace->parent, ptr);
+  trace_unlock(trace);
+}
+
+/**
+ * Replaying.
+ * The trace is decoded into a flat array of calls on slots first, so that the timed loop does no lookups.
+ */
+
+typedef struct replay_op
+{
+  uchar  op;
+  u32    slot;
+  size_t size;
+} replay_op;
+
+/**
+ * Recorded pointer -> slot table.
+ * Linear probing with backward shift deletion, traces free pointers constantly so tombstones would pile up.
+ */
+typedef struct ptr_table
+{
+  u64*   keys; // 0 is empty, the recorder never records a NULL block
+  u32*   slots;
+  size_t capacity;
+  size_t size;
+} ptr_table;
+
+static inline size_t
+ptr_hash(u64 key)
+{
+  key ^= key >> 33U;
+  key *= 0xFF51AFD7ED558CCDULL;
+  key ^= key >> 33U;
+  return (size_t)key;
+}
+
+static bool ptr_table_put(ptr_table* table, u64 key, u32 slot);
+
+static bool
+ptr_table_grow(ptr_table* table)
+{
+  ptr_table old = *table;
+
+  table->capacity = old.capacity ? old.capacity * 2 : 1024;
+  table->size     = 0;
+  table->keys     = (u64*)nv_zmalloc(table->capacity * sizeof(u64));
+  table->slots    = (u32*)nv_zmalloc(table->capacity * sizeof(u32));
+  if (!table->keys || !table->slots)
+  {
+    nv_free(table->keys);
+    nv_free(table->slots);
+    *table = old;
+    return false;
+  }
+
+  for (size_t i = 0; i < old.capacity; i++)
+  {
+    if (old.keys[i]) { ptr_table_put(table, old.keys[i], old.slots[i]); }
+  }
+
+  nv_free(old.keys);
+  nv_free(old.slots);
+  return true;
+}
+
+static bool
+ptr_table_put(ptr_table* table, u64 key, u32 slot)
+{
+  if ((table->size + 1) * 2 > table->capacity && !ptr_table_grow(table)) { return false; }
+
+  size_t mask = table->capacity - 1;
+  size_t i    = ptr_hash(key) & mask;
+  while (table->keys[i] && table->keys[i] != key) { i = (i + 1) & mask; }
+
+  if (!table->keys[i]) { table->size++; }
+  table->keys[i]  = key;
+  table->slots[i] = slot;
+  return true;
+}
+
+static size_t
+ptr_table_index(const ptr_table* table, u64 key)
+{
+  if (table->capacity == 0) { return SIZE_MAX; }
+
+  size_t mask = table->capacity - 1;
+  size_t i    = ptr_hash(key) & mask;
+  while (table->keys[i])
+  {
+    if (table->keys[i] == key) { return i; }
+    i = (i + 1) & mask;
+  }
+  return SIZE_MAX;
+}
+
+static void
+ptr_table_remove_at(ptr_table* table, size_t i)
+{
+  size_t mask = table->capacity - 1;
+  size_t hole = i;
+  size_t j    = i;
+
+  // shift every entry that would have landed in the hole back into it
+  for (;;)
+  {
+    j = (j + 1) & mask;
+    if (!table->keys[j]) { break; }
+
+    size_t home = ptr_hash(table->keys[j]) & mask;
+    if (((j - home) & mask) >= ((j - hole) & mask))
+    {
+      table->keys[hole]  = table->keys[j];
+      table->slots[hole] = table->slots[j];
+      hole               = j;
+    }
+  }
+
+  table->keys[hole] = 0;
+  table->size--;
+}
+
+typedef struct trace_reader
+{
+  nv_stream_t* stream;
+  uchar        buffer[64 * 1024];
+  size_t       length;
+  size_t       offset;
+  u64          last_ptr;
+} trace_reader;
+
+static inline bool
+read_byte(trace_reader* reader, uchar* out)
+{
+  if (reader->offset >= reader->length)
+  {
+    nv_stream_seterror(reader->stream, NV_SUCCESS);
+    reader->length = nv_stream_read(reader->buffer, sizeof(reader->buffer), reader->stream);
+    reader->offset = 0;
+    if (reader->length == 0) { return false; }
+  }
+  *out = reader->buffer[reader->offset++];
+  return true;
+}
+
+static inline bool
+read_varint(trace_reader* reader, u64* out)
+{
+  u64      value = 0;
+  unsigned shift = 0;
+  uchar    byte  = 0;
+  do
+  {
+    if (shift > 63 || !read_byte(reader, &byte)) { return false; }
+    value |= (u64)(byte & 0x7F) << shift;
+    shift += 7;
+  } while (byte & 0x80);
+
+  *out = value;
+  return true;
+}
+
+static inline bool
+read_ptr(trace_reader* reader, u64* out)
+{
+  u64 delta = 0;
+  if (!read_varint(reader, &delta)) { return false; }
+  reader->last_ptr += (u64)zigzag_decode(delta);
+  *out = reader->last_ptr;
+  return true;
+}
+
+typedef struct replay_state
+{
+  nv_list_t ops;        // replay_op
+  nv_list_t slot_sizes; // size_t, size of the block in each slot
+  nv_list_t free_slots; // u32
+  ptr_table table;
+  size_t    live;
+  size_t    peak_live;
+  size_t    skipped;
+} replay_state;
+
+static u32
+claim_slot(replay_state* state, size_t size)
+{
+  u32 slot = 0;
+  if (!nv_list_empty(&state->free_slots))
+  {
+    slot = *(u32*)nv_list_back(&state->free_slots);
+    nv_list_pop_back(&state->free_slots);
+    *(size_t*)nv_list_get(&state->slot_sizes, slot) = size;
+  }
+  else
+  {
+    slot = (u32)nv_list_size(&state->slot_sizes);
+    nv_list_push_back(&state->slot_sizes, &size);
+  }
+  return slot;
+}
+
+static void
+release_slot(replay_state* state, u32 slot)
+{
+  nv_list_push_back(&state->free_slots, &slot);
+}
+
+static inline void
+track_live(replay_state* state, size_t old_size, size_t new_size)
+{
+  state->live = state->live - old_size + new_size;
+  if (state->live > state->peak_live) { state->peak_live = state->live; }
+}
+
+static nv_error
+decode_trace(trace_reader* reader, replay_state* state)
+{
+  uchar op = 0;
+  while (read_byte(reader, &op))
+  {
+    u64 old_ptr = 0;
+    u64 size    = 0;
+    u64 new_ptr = 0;
+
+    if (op != OP_ALLOC && op != OP_REALLOC && op != OP_FREE) { return NV_ERROR_INVALID_INPUT; }
+    if (op != OP_ALLOC && !read_ptr(reader, &old_ptr)) { return NV_ERROR_EOF; }
+    if (op != OP_FREE && (!read_varint(reader, &size) || !read_ptr(reader, &new_ptr))) { return NV_ERROR_EOF; }
+
+    size_t    index = old_ptr ? ptr_table_index(&state->table, old_ptr) : SIZE_MAX;
+    replay_op rop   = { op, 0, (size_t)size };
+
+    if (op == OP_FREE)
+    {
+      if (index == SIZE_MAX)
+      {
+        state->skipped++;
+        continue;
+      }
+      rop.slot = state->table.slots[index];
+      ptr_table_remove_at(&state->table, index);
+      track_live(state, *(size_t*)nv_list_get(&state->slot_sizes, rop.slot), 0);
+      release_slot(state, rop.slot);
+    }
+    else if (new_ptr == 0)
+    {
+      // the call failed when it was recorded.
+      state->skipped++;
+      continue;
+    }
+    else if (op == OP_REALLOC && index != SIZE_MAX)
+    {
+      rop.slot = state->table.slots[index];
+      ptr_table_remove_at(&state->table, index);
+
+      size_t* slot_size = (size_t*)nv_list_get(&state->slot_sizes, rop.slot);
+      track_live(state, *slot_size, rop.size);
+      *slot_size = rop.size;
+      if (!ptr_table_put(&state->table, new_ptr, rop.slot)) { return NV_ERROR_MALLOC_FAILED; }
+    }
+    else
+    {
+      // an alloc, or a realloc of a block from before the recording which is replayed as an alloc.
+      if (old_ptr) { state->skipped++; }
+      rop.op   = OP_ALLOC;
+      rop.slot = claim_slot(state, rop.size);
+      track_live(state, 0, rop.size);
+      if (!ptr_table_put(&state->table, new_ptr, rop.slot)) { return NV_ERROR_MALLOC_FAILED; }
+    }
+
+    nv_list_push_back(&state->ops, &rop);
+  }
+
+  return NV_SUCCESS;
+}
+
+static double
+now_seconds(void)
+{
+#if !defined(_WIN32)
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + ((double)ts.tv_nsec * 1e-9);
+#else
+  return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+static size_t
+current_rss(void)
+{
+#if defined(__linux__)
+  FILE* f = fopen("/proc/self/statm", "re");
+  if (!f) { return 0; }
+
+  unsigned long pages    = 0;
+  unsigned long resident = 0;
+  int           read     = fscanf(f, "%lu %lu", &pages, &resident);
+  fclose(f);
+  if (read != 2) { return 0; }
+
+  return (size_t)resident * nv_mmap_page_size();
+#else
+  return 0;
+#endif
+}
+
+static inline void
+touch_pages(void* ptr, size_t size)
+{
+  volatile uchar* p    = (volatile uchar*)ptr;
+  const size_t    page = nv_mmap_page_size();
+  for (size_t offset = 0; offset < size; offset += page) { p[offset] = 1; }
+}
+
+nv_error
+nv_alloc_trace_replay(nv_stream_t* stream, nv_allocator_t* allocator, bool touch, nv_alloc_replay_result_t* result)
+{
+  nv_assert_else_return(stream != NULL, NV_ERROR_INVALID_ARG);
+  nv_assert_else_return(allocator != NULL, NV_ERROR_INVALID_ARG);
+  nv_assert_else_return(result != NULL, NV_ERROR_INVALID_ARG);
+
+  nv_bzero(result, sizeof(*result));
+
+  char  magic[TRACE_MAGIC_LEN] = { 0 };
+  uchar version                = 0;
+  if (nv_stream_read(magic, TRACE_MAGIC_LEN, stream) != TRACE_MAGIC_LEN || nv_memcmp(magic, TRACE_MAGIC, TRACE_MAGIC_LEN) != 0) { return NV_ERROR_INVALID_INPUT; }
+  if (nv_stream_read(&version, 1, stream) != 1 || version != NV_ALLOC_TRACE_VERSION) { return NV_ERROR_INVALID_INPUT; }
+
+  trace_reader* reader = (trace_reader*)nv_zmalloc(sizeof(trace_reader));
+  if (!reader) { return NV_ERROR_MALLOC_FAILED; }
+  reader->stream = stream;
+
+  replay_state state = nv_zinit(replay_state);
+  nv_list_init(sizeof(replay_op), 1024, &state.ops);
+  nv_list_init(sizeof(size_t), 1024, &state.slot_sizes);
+  nv_list_init(sizeof(u32), 1024, &state.free_slots);
+
+  nv_error err = decode_trace(reader, &state);
+  nv_free(reader);
+  nv_free(state.table.keys);
+  nv_free(state.table.slots);
+  nv_list_destroy(&state.free_slots);
+
+  if (err != NV_SUCCESS)
+  {
+    nv_list_destroy(&state.ops);
+    nv_list_destroy(&state.slot_sizes);
+    return err;
+  }
+
+  const replay_op* ops    = (const replay_op*)nv_list_data(&state.ops);
+  const size_t     nops   = nv_list_size(&state.ops);
+  void**           blocks = (void**)nv_zmalloc(NV_MAX(nv_list_size(&state.slot_sizes), 1) * sizeof(void*));
+  if (!blocks)
+  {
+    nv_list_destroy(&state.ops);
+    nv_list_destroy(&state.slot_sizes);
+    return NV_ERROR_MALLOC_FAILED;
+  }
+
+  const size_t base_rss = current_rss();
+  size_t       peak_rss = base_rss;
+  double       sampling = 0.0;
+
+  const double start = now_seconds();
+  for (size_t i = 0; i < nops; i++)
+  {
+    const replay_op* rop = &ops[i];
+    switch (rop->op)
+    {
+      case OP_ALLOC:
+        blocks[rop->slot] = allocator->alloc(allocator, rop->size);
+        result->allocs++;
+        break;
+      case OP_REALLOC:
+        blocks[rop->slot] = allocator->realloc(allocator, blocks[rop->slot], rop->size);
+        result->reallocs++;
+        break;
+      case OP_FREE:
+        allocator->free(allocator, blocks[rop->slot]);
+        blocks[rop->slot] = NULL;
+        result->frees++;
+        break;
+      default: break;
+    }
+
+    if (touch && rop->op != OP_FREE && blocks[rop->slot]) { touch_pages(blocks[rop->slot], rop->size); }
+
+    if (NV_UNLIKELY(i % NV_ALLOC_REPLAY_RSS_INTERVAL == 0))
+    {
+      // keep the sampling out of the timing.
+      double sample_start = now_seconds();
+      peak_rss            = NV_MAX(peak_rss, current_rss());
+      sampling += now_seconds() - sample_start;
+    }
+  }
+  result->seconds = now_seconds() - start - sampling;
+
+  peak_rss = NV_MAX(peak_rss, current_rss());
+
+  for (size_t slot = 0; slot < nv_list_size(&state.slot_sizes); slot++)
+  {
+    if (blocks[slot]) { allocator->free(allocator, blocks[slot]); }
+  }
+
+  result->skipped         = state.skipped;
+  result->peak_live_bytes = state.peak_live;
+  result->peak_rss_bytes  = peak_rss - base_rss;
+  result->fragmentation   = state.peak_live ? (double)result->peak_rss_bytes / (double)state.peak_live : 0.0;
+
+  nv_free(blocks);
+  nv_list_destroy(&state.ops);
+  nv_list_destroy(&state.slot_sizes);
+
+  return NV_SUCCESS;
+}
@@ -0,0 +1,304 @@
+#include "../../include/containers/analytics.h"
+
+#include "../../include/alloc.h"
+#include "../../include/containers/hashmap.h"
+#include "../../include/containers/list.h"
+#include "../../include/error.h"
+#include "../../include/hash.h"
+#include "../../include/stdafx.h"
+#include "../../include/string.h"
+#include "../../include/types.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Group-by
+ */
+
+static inline size_t
+value_width(nv_sort_key type)
+{
+  switch (type)
+  {
+    case NV_SORT_KEY_U32:
+    case NV_SORT_KEY_I32:
+    case NV_SORT_KEY_F32: return 4;
+    case NV_SORT_KEY_U64:
+    case NV_SORT_KEY_I64:
+    case NV_SORT_KEY_F64: return 8;
+  }
+  return 0;
+}
+
+static inline nv_agg_value
+read_value(const uchar* p, nv_sort_key type)
+{
+  nv_agg_value v = { 0 };
+  switch (type)
+  {
+    case NV_SORT_KEY_U32:
+    {
+      u32 x;
+      nv_memcpy_small(&x, p, 4);
+      v.u = x;
+      break;
+    }
+    case NV_SORT_KEY_I32:
+    {
+      i32 x;
+      nv_memcpy_small(&x, p, 4);
+      v.i = x;
+      break;
+    }
+    case NV_SORT_KEY_F32:
+    {
+      f32 x;
+      nv_memcpy_small(&x, p, 4);
+      v.f = x;
+      break;
+    }
+    case NV_SORT_KEY_U64: nv_memcpy_small(&v.u, p, 8); break;
+    case NV_SORT_KEY_I64: nv_memcpy_small(&v.i, p, 8); break;
+    case NV_SORT_KEY_F64: nv_memcpy_small(&v.f, p, 8); break;
+  }
+  return v;
+}
+
+static inline void
+aggregate(nv_group_t* group, nv_agg_value v, nv_sort_key type)
+{
+  if (group->count++ == 0)
+  {
+    group->sum = group->min = group->max = v;
+    return;
+  }
+
+  switch (type)
+  {
+    case NV_SORT_KEY_I32:
+    case NV_SORT_KEY_I64:
+      group->sum.i = (i64)((u64)group->sum.i + (u64)v.i);
+      group->min.i = NV_MIN(group->min.i, v.i);
+      group->max.i = NV_MAX(group->max.i, v.i);
+      break;
+    case NV_SORT_KEY_U32:
+    case NV_SORT_KEY_U64:
+      group->sum.u += v.u;
+      group->min.u = NV_MIN(group->min.u, v.u);
+      group->max.u = NV_MAX(group->max.u, v.u);
+      break;
+    case NV_SORT_KEY_F32:
+    case NV_SORT_KEY_F64:
+      group->sum.f += v.f;
+      group->min.f = NV_MIN(group->min.f, v.f);
+      group->max.f = NV_MAX(group->max.f, v.f);
+      break;
+  }
+}
+
+nv_error
+nv_list_group_by(const nv_list_t* records, size_t key_offset, size_t key_size, size_t value_offset, nv_sort_key value_type, nv_list_t* keys, nv_list_t* groups)
+{
+  nv_assert_else_return(NOVA_CONT_IS_VALID(records) && NOVA_CONT_IS_VALID(keys) && NOVA_CONT_IS_VALID(groups), NV_ERROR_INVALID_ARG);
+  nv_assert_else_return(key_size > 0 && key_offset + key_size <= records->type_size, NV_ERROR_INVALID_ARG);
+  nv_assert_else_return(value_width(value_type) > 0 && value_offset + value_width(value_type) <= records->type_size, NV_ERROR_INVALID_ARG);
+  nv_assert_else_return(keys->type_size == key_size && groups->type_size == sizeof(nv_group_t), NV_ERROR_INVALID_ARG);
+
+  nv_list_clear(keys);
+  nv_list_clear(groups);
+  if (records->size == 0) { return NV_ERROR_SUCCESS; }
+
+  // key -> index of its group
+  nv_hashmap_t map;
+  nv_error     e = nv_hashmap_init_with_allocator(key_size, sizeof(size_t), NULL, NULL, 16, groups->alloc, &map);
+  if (e != NV_ERROR_SUCCESS) { return e; }
+
+  const uchar* row    = (const uchar*)records->data;
+  const size_t stride = records->type_size;
+
+  for (size_t i = 0; i < records->size; i++, row += stride)
+  {
+    const uchar*  key   = row + key_offset;
+    const size_t* found = (const size_t*)nv_hashmap_find(&map, key);
+    size_t        index = 0;
+
+    if (found) { index = *found; }
+    else
+    {
+      index = groups->size;
+      if (!nv_hashmap_insert(&map, key, &index))
+      {
+        e = NV_ERROR_MALLOC_FAILED;
+        break;
+      }
+      nv_list_push_back(keys, key);
+      nv_list_push_empty(groups);
+    }
+
+    aggregate((nv_group_t*)groups->data + index, read_value(row + value_offset, value_type), value_type);
+  }
+
+  nv_hashmap_destroy(&map);
+  return e;
+}
+
+/*
+ * Hash join
+ * Both sides are scattered in to 2^bits partitions by the low bits of their key's hash (a counting sort),
+ * so that matching rows always land in the same partition. Each partition of the build side then gets a small
+ * open addressing table indexed by the higher hash bits, which the same partition of the probe side is looked up in.
+ */
+
+typedef struct join_entry
+{
+  u32    hash;
+  size_t row;
+} join_entry;
+
+typedef struct join_side
+{
+  const uchar* data;
+  size_t       stride;
+  size_t       key_offset;
+  size_t       count;
+  join_entry*  entries; // partitioned
+  size_t*      offsets; // partition p is entries[offsets[p], offsets[p + 1])
+} join_side;
+
+#define MAX_PARTITION_BITS 10
+
+static nv_error
+partition_side(join_side* side, size_t key_size, u32 bits, nv_allocator_t* alloc)
+{
+  const size_t partitions = (size_t)1 << bits;
+  const u32    mask       = (u32)partitions - 1;
+
+  u32* hashes   = nv_alloc_zmalloc(alloc, side->count * sizeof(u32));
+  side->entries = nv_alloc_zmalloc(alloc, side->count * sizeof(join_entry));
+  side->offsets = nv_alloc_zmalloc(alloc, (partitions + 1) * sizeof(size_t));
+  if (!hashes || !side->entries || !side->offsets)
+  {
+    if (hashes) { nv_alloc_free(alloc, hashes); }
+    return NV_ERROR_MALLOC_FAILED;
+  }
+
+  const uchar* key = side->data + side->key_offset;
+  for (size_t i = 0; i < side->count; i++, key += side->stride)
+  {
+    hashes[i] = nv_hash_murmur3(key, key_size, NULL);
+    side->offsets[(hashes[i] & mask) + 1]++;
+  }
+  for (size_t p = 0; p < partitions; p++) { side->offsets[p + 1] += side->offsets[p]; }
+
+  // scatter, using offsets as the write heads, then shift them back to the partition starts
+  for (size_t i = 0; i < side->count; i++)
+  {
+    const size_t p                    = hashes[i] & mask;
+    side->entries[side->offsets[p]++] = (join_entry){ hashes[i], i };
+  }
+  for (size_t p = partitions; p > 0; p--) { side->offsets[p] = side->offsets[p - 1]; }
+  side->offsets[0] = 0;
+
+  nv_alloc_free(alloc, hashes);
+  return NV_ERROR_SUCCESS;
+}
+
+// nv_list_reserve() does not return on failure, so neither can fail here.
+static inline void
+emit_pair(nv_list_t* pairs, size_t left, size_t right)
+{
+  if (NV_UNLIKELY(pairs->size == pairs->capacity)) { nv_list_reserve(pairs, NV_MAX((size_t)64, pairs->capacity * 2)); }
+  ((nv_join_pair_t*)pairs->data)[pairs->size++] = (nv_join_pair_t){ left, right };
+}
+
+static inline size_t
+next_power_of_two(size_t n)
+{
+  size_t p = 1;
+  while (p < n) { p <<= 1; }
+  return p;
+}
+
+nv_error
+nv_list_hash_join(const nv_list_t* left, size_t left_key_offset, const nv_list_t* right, size_t right_key_offset, size_t key_size, nv_list_t* pairs)
+{
+  nv_assert_else_return(NOVA_CONT_IS_VALID(left) && NOVA_CONT_IS_VALID(right) && NOVA_CONT_IS_VALID(pairs), NV_ERROR_INVALID_ARG);
+  nv_assert_else_return(key_size > 0 && left_key_offset + key_size <= left->type_size && right_key_offset + key_size <= right->type_size, NV_ERROR_INVALID_ARG);
+  nv_assert_else_return(pairs->type_size == sizeof(nv_join_pair_t), NV_ERROR_INVALID_ARG);
+
+  nv_list_clear(pairs);
+  if (left->size == 0 || right->size == 0) { return NV_ERROR_SUCCESS; }
+
+  join_side l = { (const uchar*)left->data, left->type_size, left_key_offset, left->size, NULL, NULL };
+  join_side r = { (const uchar*)right->data, right->type_size, right_key_offset, right->size, NULL, NULL };
+
+  const bool left_builds = left->size <= right->size;
+  join_side* build       = left_builds ? &l : &r;
+  join_side* probe       = left_builds ? &r : &l;
+
+  // a build row costs its entry and two table slots
+  const size_t build_bytes = build->count * (sizeof(join_entry) + (2 * sizeof(u32)));
+  u32          bits        = 0;
+  while (bits < MAX_PARTITION_BITS && (build_bytes >> bits) > NV_JOIN_PARTITION_BYTES) { bits++; }
+
+  nv_allocator_t* alloc = pairs->alloc;
+  u32*            table = NULL;
+  nv_error        e     = partition_side(build, key_size, bits, alloc);
+  if (e == NV_ERROR_SUCCESS) { e = partition_side(probe, key_size, bits, alloc); }
+
+  const size_t partitions = (size_t)1 << bits;
+  size_t       largest    = 0;
+  if (e == NV_ERROR_SUCCESS)
+  {
+    for (size_t p = 0; p < partitions; p++) { largest = NV_MAX(largest, build->offsets[p + 1] - build->offsets[p]); }
+    table = nv_alloc_zmalloc(alloc, next_power_of_two(NV_MAX((size_t)16, largest * 2)) * sizeof(u32));
+    if (!table) { e = NV_ERROR_MALLOC_FAILED; }
+  }
+
+  for (size_t p = 0; e == NV_ERROR_SUCCESS && p < partitions; p++)
+  {
+    const join_entry* b_entries = build->entries + build->offsets[p];
+    const size_t      b_count   = build->offsets[p + 1] - build->offsets[p];
+    const join_entry* p_entries = probe->entries + probe->offsets[p];
+    const size_t      p_count   = probe->offsets[p + 1] - probe->offsets[p];
+    if (b_count == 0 || p_count == 0) { continue; }
+
+    // slots hold the index of a build entry + 1, 0 is empty. Equal keys take a slot each.
+    const size_t capacity = next_power_of_two(NV_MAX((size_t)16, b_count * 2));
+    const size_t mask     = capacity - 1;
+    nv_memset(table, 0, capacity * sizeof(u32));
+
+    for (size_t i = 0; i < b_count; i++)
+    {
+      size_t slot = (b_entries[i].hash >> bits) & mask;
+      while (table[slot]) { slot = (slot + 1) & mask; }
+      table[slot] = (u32)i + 1;
+    }
+
+    for (size_t i = 0; i < p_count; i++)
+    {
+      const join_entry* pe   = &p_entries[i];
+      const uchar*      pkey = probe->data + (pe->row * probe->stride) + probe->key_offset;
+
+      for (size_t slot = (pe->hash >> bits) & mask; table[slot]; slot = (slot + 1) & mask)
+      {
+        const join_entry* be = &b_entries[table[slot] - 1];
+        if (be->hash != pe->hash || nv_memcmp(build->data + (be->row * build->stride) + build->key_offset, pkey, key_size) != 0) { continue; }
+
+        left_builds ? emit_pair(pairs, be->row, pe->row) : emit_pair(pairs, pe->row, be->row);
+      }
+    }
+  }
+
+  if (table) { nv_alloc_free(alloc, table); }
+  join_side* sides[2] = { &l, &r };
+  for (int s = 0; s < 2; s++)
+  {
+    if (sides[s]->entries) { nv_alloc_free(alloc, sides[s]->entries); }
+    if (sides[s]->offsets) { nv_alloc_free(alloc, sides[s]->offsets); }
+  }
+
+  return e;
+}
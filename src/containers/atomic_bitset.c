@@ -0,0 +1,241 @@
+#include "../../include/containers/atomic_bitset.h"
+
+#include "../../include/atomic.h"
+#include "../../include/error.h"
+#include "../../include/stdafx.h"
+#include "../../include/string.h"
+#include "../../include/types.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define WORD_BITS 64
+#define FULL      (~(u64)0)
+
+static inline u64
+bit_mask(size_t bitindex)
+{
+  return (u64)1 << (bitindex % WORD_BITS);
+}
+
+nv_error
+nv_atomic_bitset_init(size_t init_capacity, nv_atomic_bitset_t* set)
+{
+  return nv_atomic_bitset_init_with_allocator(init_capacity, NULL, set);
+}
+
+nv_error
+nv_atomic_bitset_init_with_allocator(size_t init_capacity, nv_allocator_t* allocator, nv_atomic_bitset_t* set)
+{
+  nv_assert_else_return(set != NULL, NV_ERROR_INVALID_ARG);
+  nv_assert_else_return(init_capacity > 0, NV_ERROR_INVALID_ARG);
+
+  *set       = nv_zinit(nv_atomic_bitset_t);
+  set->alloc = allocator ? allocator : nv_alloc_current;
+
+  const size_t words = (init_capacity + WORD_BITS - 1) / WORD_BITS;
+
+  set->data = nv_alloc_zmalloc(set->alloc, words * sizeof(nv_atomic_u64));
+  nv_assert_else_return(set->data != NULL, NV_ERROR_MALLOC_FAILED);
+
+  set->size  = init_capacity;
+  set->words = words;
+
+  return NV_ERROR_SUCCESS;
+}
+
+void
+nv_atomic_bitset_destroy(nv_atomic_bitset_t* set)
+{
+  if (!set) { return; }
+
+  nv_alloc_free(set->alloc, (void*)set->data);
+
+  nv_bzero(set, sizeof(nv_atomic_bitset_t));
+}
+
+bool
+nv_atomic_bitset_set_bit(nv_atomic_bitset_t* set, size_t bitindex)
+{
+  return (nv_atomic_or(&set->data[bitindex / WORD_BITS], bit_mask(bitindex)) & bit_mask(bitindex)) != 0;
+}
+
+bool
+nv_atomic_bitset_clear_bit(nv_atomic_bitset_t* set, size_t bitindex)
+{
+  return (nv_atomic_and(&set->data[bitindex / WORD_BITS], ~bit_mask(bitindex)) & bit_mask(bitindex)) != 0;
+}
+
+bool
+nv_atomic_bitset_access_bit(const nv_atomic_bitset_t* set, size_t bitindex)
+{
+  return (nv_atomic_load_u64(&set->data[bitindex / WORD_BITS]) & bit_mask(bitindex)) != 0;
+}
+
+size_t
+nv_atomic_bitset_popcount(const nv_atomic_bitset_t* set)
+{
+  nv_assert_else_return(set != NULL, 0);
+
+  size_t bits = 0;
+  for (size_t i = 0; i < set->words; i++) { bits += (size_t)nv_popcount64(nv_atomic_load_u64(&set->data[i])); }
+  return bits;
+}
+
+/*
+ * Slot allocator
+ *
+ * A set bit at level l > 0 means that word index of level l - 1 is full. Those summary bits are hints that trail the
+ * words they describe: whoever fills a word sets its summary bit afterwards, whoever frees a bit in a full word clears it.
+ *
+ * A summary bit that says full while the word has a free bit would hide slots, so mark_full() reads the word again
+ * after setting the bit and undoes it if a release got in between. Every release from a full word clears the summary
+ * bit after its own change, so with both sides re-checking, the last writer always leaves the right value.
+ * The opposite mistake (not full, but the word is) only costs a claim a retry, and the claim repairs it.
+ */
+
+/* The lowest clear bit of 'word', as a mask. */
+static inline u64
+word_lowest_clear(u64 word)
+{
+  return ~word & (word + 1);
+}
+
+static inline nv_atomic_u64*
+word_at(nv_slot_allocator_t* slots, size_t level, size_t index)
+{
+  return &slots->levels[level].data[index];
+}
+
+static void mark_free(nv_slot_allocator_t* slots, size_t level, size_t child);
+
+/* Word 'child' of the level below 'level' is full. */
+static void
+mark_full(nv_slot_allocator_t* slots, size_t level, size_t child)
+{
+  if (level >= slots->level_count) { return; }
+
+  const u64 bit = bit_mask(child);
+  const u64 old = nv_atomic_or(word_at(slots, level, child / WORD_BITS), bit);
+  if (old != FULL && (old | bit) == FULL) { mark_full(slots, level + 1, child / WORD_BITS); }
+
+  if (nv_atomic_load_u64(word_at(slots, level - 1, child)) != FULL) { mark_free(slots, level, child); }
+}
+
+/* Word 'child' of the level below 'level' has a clear bit. */
+static void
+mark_free(nv_slot_allocator_t* slots, size_t level, size_t child)
+{
+  if (level >= slots->level_count) { return; }
+
+  const u64 old = nv_atomic_and(word_at(slots, level, child / WORD_BITS), ~bit_mask(child));
+  if (old == FULL) { mark_free(slots, level + 1, child / WORD_BITS); }
+}
+
+nv_error
+nv_slot_allocator_init(size_t slot_count, nv_allocator_t* allocator, nv_slot_allocator_t* slots)
+{
+  nv_assert_else_return(slots != NULL, NV_ERROR_INVALID_ARG);
+  nv_assert_else_return(slot_count > 0, NV_ERROR_INVALID_ARG);
+
+  *slots            = nv_zinit(nv_slot_allocator_t);
+  slots->slot_count = slot_count;
+
+  // every level has a bit per word of the level below, until one word is enough.
+  for (size_t bits = slot_count;; bits = (bits + WORD_BITS - 1) / WORD_BITS)
+  {
+    if (slots->level_count == NV_SLOT_ALLOCATOR_MAX_LEVELS)
+    {
+      nv_slot_allocator_destroy(slots);
+      return NV_ERROR_TOO_BIG;
+    }
+
+    nv_atomic_bitset_t* level = &slots->levels[slots->level_count];
+    nv_error            e     = nv_atomic_bitset_init_with_allocator(bits, allocator, level);
+    if (e != NV_SUCCESS)
+    {
+      nv_slot_allocator_destroy(slots);
+      return e;
+    }
+    slots->level_count++;
+
+    // the bits past the end stand for slots (or words) that don't exist, they are claimed for good.
+    // the last word always keeps at least one real bit, so this never makes a word full.
+    for (size_t i = bits; i < level->words * WORD_BITS; i++) { nv_atomic_bitset_set_bit(level, i); }
+
+    if (level->words == 1) { break; }
+  }
+
+  return NV_SUCCESS;
+}
+
+void
+nv_slot_allocator_destroy(nv_slot_allocator_t* slots)
+{
+  if (!slots) { return; }
+
+  for (size_t i = 0; i < slots->level_count; i++) { nv_atomic_bitset_destroy(&slots->levels[i]); }
+
+  nv_bzero(slots, sizeof(nv_slot_allocator_t));
+}
+
+size_t
+nv_slot_allocator_claim(nv_slot_allocator_t* slots)
+{
+  nv_assert_else_return(slots != NULL && slots->level_count > 0, NV_SLOT_NONE);
+
+  const size_t top = slots->level_count - 1;
+
+  for (;;)
+  {
+    // walk down the summaries to a slot word that should have a clear bit.
+    size_t index = 0;
+    size_t level = top;
+    for (; level > 0; level--)
+    {
+      const u64 word = nv_atomic_load_u64(word_at(slots, level, index));
+      if (word == FULL) { break; }
+      index = (index * WORD_BITS) + (size_t)nv_ctz64(~word);
+    }
+
+    if (level > 0)
+    {
+      if (level == top) { return NV_SLOT_NONE; }
+
+      // the summary above sent us to a full word, fix it and start over.
+      mark_full(slots, level + 1, index);
+      continue;
+    }
+
+    nv_atomic_u64* slot_word = word_at(slots, 0, index);
+    u64            word      = nv_atomic_load_u64(slot_word);
+    while (word != FULL)
+    {
+      const u64 bit = word_lowest_clear(word);
+      const u64 old = nv_atomic_or(slot_word, bit);
+      if (!(old & bit))
+      {
+        if ((old | bit) == FULL) { mark_full(slots, 1, index); }
+        return (index * WORD_BITS) + (size_t)nv_ctz64(bit);
+      }
+      word = old | bit;
+    }
+
+    if (top == 0) { return NV_SLOT_NONE; }
+    mark_full(slots, 1, index);
+  }
+}
+
+nv_error
+nv_slot_allocator_release(nv_slot_allocator_t* slots, size_t slot)
+{
+  nv_assert_else_return(slots != NULL && slot < slots->slot_count, NV_ERROR_INVALID_ARG);
+
+  const u64 bit = bit_mask(slot);
+  const u64 old = nv_atomic_and(word_at(slots, 0, slot / WORD_BITS), ~bit);
+  if (!(old & bit)) { return NV_ERROR_INVALID_ARG; }
+
+  if (old == FULL) { mark_free(slots, 1, slot / WORD_BITS); }
+  return NV_SUCCESS;
+}
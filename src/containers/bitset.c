@@ -1,5 +1,6 @@
 #include "../../include/containers/bitset.h"
 
+#include "../../include/cpu.h"
 #include "../../include/error.h"
 #include "../../include/stdafx.h"
 #include "../../include/string.h"
@@ -13,34 +14,88 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if NV_CPU_X86_SIMD
+#  include <immintrin.h>
+#endif
+
+#define WORD_BITS NV_BITSET_WORD_BITS
+#define ALL_ONES  (~(u64)0)
+
+static inline u64
+bit_mask(size_t bitindex)
+{
+  return (u64)1 << (bitindex % WORD_BITS);
+}
+
+// keep the bits past set->size clear, popcount and find rely on it.
+static inline void
+clear_tail(nv_bitset_t* set)
+{
+  const size_t used = set->size % WORD_BITS;
+  if (used && set->words) { set->data[set->words - 1] &= (bit_mask(used) - 1); }
+}
+
 nv_error
 nv_bitset_init(size_t init_capacity, nv_bitset_t* set)
+{
+  return nv_bitset_init_with_allocator(init_capacity, NULL, set);
+}
+
+nv_error
+nv_bitset_init_with_allocator(size_t init_capacity, nv_allocator_t* allocator, nv_bitset_t* set)
 {
   nv_assert_else_return(set != NULL, NV_ERROR_INVALID_ARG);
   nv_assert_else_return(init_capacity > 0, NV_ERROR_INVALID_ARG);
 
-  *set = nv_zinit(nv_bitset_t);
+  *set       = nv_zinit(nv_bitset_t);
+  set->alloc = allocator ? allocator : nv_alloc_current;
 
-  if (init_capacity > 0)
-  {
-    init_capacity = (init_capacity + 7) / 8;
-    set->size     = init_capacity;
+  const size_t words = nv_bitset_word_count(init_capacity);
 
-    set->data = nv_zmalloc(init_capacity * sizeof(uint8_t));
-    nv_assert_else_return(set->data != NULL, NV_ERROR_MALLOC_FAILED);
-  }
-  else
+  set->data = nv_alloc_zmalloc(set->alloc, words * sizeof(u64));
+  nv_assert_else_return(set->data != NULL, NV_ERROR_MALLOC_FAILED);
+
+  set->size  = init_capacity;
+  set->words = words;
+
+  return NV_ERROR_SUCCESS;
+}
+
+nv_error
+nv_bitset_resize(nv_bitset_t* set, size_t bits)
+{
+  nv_assert_else_return(set != NULL, NV_ERROR_INVALID_ARG);
+
+  // zeroed or destroyed sets have no allocator yet, they get the current one like nv_zmalloc() would.
+  if (!set->alloc) { set->alloc = nv_alloc_current; }
+
+  const size_t words = nv_bitset_word_count(bits);
+
+  if (words != set->words)
   {
-    set->size = 0;
+    u64* data = NULL;
+    if (words == 0) { nv_alloc_free(set->alloc, set->data); }
+    else if (!set->data) { data = nv_alloc_zmalloc(set->alloc, words * sizeof(u64)); }
+    else { data = nv_alloc_realloc(set->alloc, set->data, words * sizeof(u64)); }
+
+    nv_assert_else_return(words == 0 || data != NULL, NV_ERROR_MALLOC_FAILED);
+
+    if (words > set->words && set->data) { nv_memset(data + set->words, 0, (words - set->words) * sizeof(u64)); }
+
+    set->data  = data;
+    set->words = words;
   }
 
+  set->size = bits;
+  clear_tail(set);
+
   return NV_ERROR_SUCCESS;
 }
 
 void
 nv_bitset_set_bit(nv_bitset_t* set, size_t bitindex)
 {
-  set->data[bitindex / 8] |= (1U << (bitindex % 8U));
+  set->data[bitindex / WORD_BITS] |= bit_mask(bitindex);
 }
 
 void
@@ -52,19 +107,19 @@ nv_bitset_set_bit_to(nv_bitset_t* set, size_t bitindex, nv_bitset_bit to)
 void
 nv_bitset_clear_bit(nv_bitset_t* set, size_t bitindex)
 {
-  set->data[bitindex / 8] &= ~(1U << (bitindex % 8U));
+  set->data[bitindex / WORD_BITS] &= ~bit_mask(bitindex);
 }
 
 void
 nv_bitset_toggle_bit(nv_bitset_t* set, size_t bitindex)
 {
-  set->data[bitindex / 8] ^= (1U << (bitindex % 8U));
+  set->data[bitindex / WORD_BITS] ^= bit_mask(bitindex);
 }
 
 nv_bitset_bit
 nv_bitset_access_bit(const nv_bitset_t* set, size_t bitindex)
 {
-  nv_bitset_bit bit = (set->data[bitindex / 8] & (1U << (bitindex % 8U))) != 0;
+  nv_bitset_bit bit = (set->data[bitindex / WORD_BITS] & bit_mask(bitindex)) != 0;
   return bit;
 }
 
@@ -72,13 +127,8 @@ void
 nv_bitset_copy_from(nv_bitset_t* dst, const nv_bitset_t* src)
 {
   if (!src->data) { return; }
-  if (src->size != dst->size && dst->data)
-  {
-    nv_free(dst->data);
-    dst->data = nv_zmalloc(src->size * sizeof(u8));
-    dst->size = src->size;
-  }
-  if (dst->data && src->data) { nv_memcpy(dst->data, src->data, src->size); }
+  if (nv_bitset_resize(dst, src->size) != NV_ERROR_SUCCESS) { return; }
+  nv_memcpy(dst->data, src->data, src->words * sizeof(u64));
 }
 
 void
@@ -86,22 +136,329 @@ nv_bitset_destroy(nv_bitset_t* set)
 {
   if (!set) { return; }
 
-  nv_free(set->data);
+  nv_alloc_free(set->alloc, set->data);
 
   nv_bzero(set, sizeof(nv_bitset_t));
 }
 
+/*
+ * Bool packing
+ *
+ * A bool is one byte holding 0 or 1. The vector versions compare 16 or 32 of them against zero and movemask the
+ * result into one bit per bool. The scalar version multiplies 8 of them so that byte i lands on bit 56 + i,
+ * the partial products never overlap so there are no carries.
+ */
+
+static inline u64
+pack_bools_scalar(const bool* array, size_t count)
+{
+  u64    word = 0;
+  size_t i    = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    u64 bytes;
+    nv_memcpy_small(&bytes, array + i, 8);
+    word |= ((bytes * 0x0102040810204080ULL) >> 56U) << i;
+  }
+  for (; i < count; i++) { word |= (u64)(array[i] != 0) << i; }
+  return word;
+}
+
+static void
+pack_bools_scalar_all(u64* words, const bool* array, size_t count)
+{
+  for (size_t w = 0; w * WORD_BITS < count; w++)
+  {
+    const size_t left = count - (w * WORD_BITS);
+    words[w]          = pack_bools_scalar(array + (w * WORD_BITS), left < WORD_BITS ? left : WORD_BITS);
+  }
+}
+
+#if NV_CPU_X86_SIMD
+
+NV_CPU_TARGET("sse2") static void
+pack_bools_sse2(u64* words, const bool* array, size_t count)
+{
+  const __m128i zero = _mm_setzero_si128();
+
+  size_t w = 0;
+  for (; (w + 1) * WORD_BITS <= count; w++)
+  {
+    const bool* p    = array + (w * WORD_BITS);
+    u64         word = 0;
+    for (size_t j = 0; j < 4; j++)
+    {
+      const __m128i v = _mm_loadu_si128((const __m128i*)(p + (j * 16)));
+      word |= (u64)(~(u32)_mm_movemask_epi8(_mm_cmpeq_epi8(v, zero)) & 0xFFFFU) << (j * 16);
+    }
+    words[w] = word;
+  }
+  if (w * WORD_BITS < count) { words[w] = pack_bools_scalar(array + (w * WORD_BITS), count - (w * WORD_BITS)); }
+}
+
+NV_CPU_TARGET("avx2") static void
+pack_bools_avx2(u64* words, const bool* array, size_t count)
+{
+  const __m256i zero = _mm256_setzero_si256();
+
+  size_t w = 0;
+  for (; (w + 1) * WORD_BITS <= count; w++)
+  {
+    const bool*   p  = array + (w * WORD_BITS);
+    const __m256i lo = _mm256_loadu_si256((const __m256i*)p);
+    const __m256i hi = _mm256_loadu_si256((const __m256i*)(p + 32));
+    const u32     ml = ~(u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, zero));
+    const u32     mh = ~(u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, zero));
+    words[w]         = (u64)ml | ((u64)mh << 32U);
+  }
+  if (w * WORD_BITS < count) { words[w] = pack_bools_scalar(array + (w * WORD_BITS), count - (w * WORD_BITS)); }
+}
+
+#endif
+
 void
 nv_bitset_copy_from_bool_array(nv_bitset_t* set, const bool* array, size_t array_size)
 {
   if (!set) { return; }
+  if (nv_bitset_resize(set, array_size) != NV_ERROR_SUCCESS) { return; }
+
+#if NV_CPU_X86_SIMD
+  if (nv_cpu_has(NV_CPU_AVX2)) { pack_bools_avx2(set->data, array, array_size); }
+  else if (nv_cpu_has(NV_CPU_SSE2)) { pack_bools_sse2(set->data, array, array_size); }
+  else { pack_bools_scalar_all(set->data, array, array_size); }
+#else
+  pack_bools_scalar_all(set->data, array, array_size);
+#endif
+}
+
+/*
+ * Ranges
+ */
+
+static void
+fill_range(nv_bitset_t* set, size_t first, size_t count, bool value)
+{
+  if (first >= set->size || count == 0) { return; }
+  if (count > set->size - first) { count = set->size - first; }
+
+  const size_t last       = first + count - 1;
+  const size_t first_word = first / WORD_BITS;
+  const size_t last_word  = last / WORD_BITS;
+  const u64    head       = ALL_ONES << (first % WORD_BITS);
+  const u64    tail       = ALL_ONES >> (WORD_BITS - 1 - (last % WORD_BITS));
 
-  if (set->size != array_size)
+  if (first_word == last_word)
   {
-    nv_free(set->data);
-    set->size = (array_size + 7) / 8;
-    set->data = nv_zmalloc(set->size * sizeof(uint8_t));
+    const u64 mask = head & tail;
+    value ? (set->data[first_word] |= mask) : (set->data[first_word] &= ~mask);
+    return;
   }
 
-  for (size_t i = 0; i < array_size; i++) { (array[i]) ? nv_bitset_set_bit(set, i) : nv_bitset_clear_bit(set, i); }
+  value ? (set->data[first_word] |= head) : (set->data[first_word] &= ~head);
+  nv_memset(set->data + first_word + 1, value ? 0xFF : 0, (last_word - first_word - 1) * sizeof(u64));
+  value ? (set->data[last_word] |= tail) : (set->data[last_word] &= ~tail);
+}
+
+void
+nv_bitset_set_range(nv_bitset_t* set, size_t first, size_t count)
+{
+  fill_range(set, first, count, true);
+}
+
+void
+nv_bitset_clear_range(nv_bitset_t* set, size_t first, size_t count)
+{
+  fill_range(set, first, count, false);
+}
+
+/*
+ * Whole set operations
+ */
+
+#define SCALAR_OP(NAME, EXPR)                                                                                                                                                 \
+  static void NAME##_scalar(u64* NV_RESTRICT dst, const u64* NV_RESTRICT src, size_t words)                                                                                   \
+  {                                                                                                                                                                           \
+    for (size_t i = 0; i < words; i++)                                                                                                                                        \
+    {                                                                                                                                                                         \
+      const u64 d = dst[i], s = src[i];                                                                                                                                       \
+      dst[i]      = (EXPR);                                                                                                                                                   \
+    }                                                                                                                                                                         \
+  }
+
+SCALAR_OP(op_and, d & s)
+SCALAR_OP(op_or, d | s)
+SCALAR_OP(op_xor, d ^ s)
+SCALAR_OP(op_andnot, d & ~s)
+
+#if NV_CPU_X86_SIMD
+
+// two vectors per iteration, the loads of the second overlap the first's store.
+#  define AVX2_OP(NAME, EXPR)                                                                                                                                                 \
+    NV_CPU_TARGET("avx2") static void NAME##_avx2(u64* NV_RESTRICT dst, const u64* NV_RESTRICT src, size_t words)                                                             \
+    {                                                                                                                                                                         \
+      size_t i = 0;                                                                                                                                                           \
+      for (; i + 8 <= words; i += 8)                                                                                                                                          \
+      {                                                                                                                                                                       \
+        __m256i d = _mm256_loadu_si256((const __m256i*)(dst + i)), s = _mm256_loadu_si256((const __m256i*)(src + i));                                                         \
+        _mm256_storeu_si256((__m256i*)(dst + i), (EXPR));                                                                                                                     \
+        d = _mm256_loadu_si256((const __m256i*)(dst + i + 4)), s = _mm256_loadu_si256((const __m256i*)(src + i + 4));                                                         \
+        _mm256_storeu_si256((__m256i*)(dst + i + 4), (EXPR));                                                                                                                 \
+      }                                                                                                                                                                       \
+      NAME##_scalar(dst + i, src + i, words - i);                                                                                                                             \
+    }
+
+AVX2_OP(op_and, _mm256_and_si256(d, s))
+AVX2_OP(op_or, _mm256_or_si256(d, s))
+AVX2_OP(op_xor, _mm256_xor_si256(d, s))
+AVX2_OP(op_andnot, _mm256_andnot_si256(s, d))
+
+#  define BINARY_OP(NAME, dst, src, words)                                                                                                                                    \
+    (nv_cpu_has(NV_CPU_AVX2) ? NAME##_avx2(dst, src, words) : NAME##_scalar(dst, src, words))
+#else
+#  define BINARY_OP(NAME, dst, src, words) NAME##_scalar(dst, src, words)
+#endif
+
+static inline size_t
+common_words(const nv_bitset_t* dst, const nv_bitset_t* src)
+{
+  return dst->words < src->words ? dst->words : src->words;
+}
+
+void
+nv_bitset_and(nv_bitset_t* dst, const nv_bitset_t* src)
+{
+  nv_assert_else_return(dst != NULL && src != NULL, );
+
+  if (dst == src) { return; }
+
+  const size_t words = common_words(dst, src);
+
+  BINARY_OP(op_and, dst->data, src->data, words);
+  if (dst->words > words) { nv_memset(dst->data + words, 0, (dst->words - words) * sizeof(u64)); }
+}
+
+void
+nv_bitset_or(nv_bitset_t* dst, const nv_bitset_t* src)
+{
+  nv_assert_else_return(dst != NULL && src != NULL, );
+  if (dst == src) { return; }
+
+  BINARY_OP(op_or, dst->data, src->data, common_words(dst, src));
+  clear_tail(dst);
+}
+
+void
+nv_bitset_xor(nv_bitset_t* dst, const nv_bitset_t* src)
+{
+  nv_assert_else_return(dst != NULL && src != NULL, );
+  if (dst == src)
+  {
+    nv_memset(dst->data, 0, dst->words * sizeof(u64));
+    return;
+  }
+
+  BINARY_OP(op_xor, dst->data, src->data, common_words(dst, src));
+  clear_tail(dst);
+}
+
+void
+nv_bitset_andnot(nv_bitset_t* dst, const nv_bitset_t* src)
+{
+  nv_assert_else_return(dst != NULL && src != NULL, );
+  if (dst == src)
+  {
+    nv_memset(dst->data, 0, dst->words * sizeof(u64));
+    return;
+  }
+
+  BINARY_OP(op_andnot, dst->data, src->data, common_words(dst, src));
+}
+
+/*
+ * Popcount
+ *
+ * With AVX2, the nibble lookup: each byte's two nibbles index a 16 entry table of bit counts through a shuffle,
+ * and sad against zero sums the byte counts into the four u64 lanes.
+ */
+
+static size_t
+popcount_scalar(const u64* words, size_t count)
+{
+  size_t bits = 0;
+  for (size_t i = 0; i < count; i++) { bits += (size_t)nv_popcount64(words[i]); }
+  return bits;
+}
+
+#if NV_CPU_X86_SIMD
+
+NV_CPU_TARGET("popcnt") static size_t
+popcount_popcnt(const u64* words, size_t count)
+{
+  size_t bits = 0;
+  for (size_t i = 0; i < count; i++) { bits += (size_t)__builtin_popcountll(words[i]); }
+  return bits;
+}
+
+NV_CPU_TARGET("avx2") static size_t
+popcount_avx2(const u64* words, size_t count)
+{
+  const __m256i table  = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  const __m256i nibble = _mm256_set1_epi8(0x0F);
+  __m256i       total  = _mm256_setzero_si256();
+
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    const __m256i v      = _mm256_loadu_si256((const __m256i*)(words + i));
+    const __m256i lo     = _mm256_shuffle_epi8(table, _mm256_and_si256(v, nibble));
+    const __m256i hi     = _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble));
+    const __m256i counts = _mm256_add_epi8(lo, hi);
+    total                = _mm256_add_epi64(total, _mm256_sad_epu8(counts, _mm256_setzero_si256()));
+  }
+
+  u64 lanes[4];
+  _mm256_storeu_si256((__m256i*)lanes, total);
+  return (size_t)(lanes[0] + lanes[1] + lanes[2] + lanes[3]) + popcount_scalar(words + i, count - i);
+}
+
+#endif
+
+size_t
+nv_bitset_popcount(const nv_bitset_t* set)
+{
+  nv_assert_else_return(set != NULL, 0);
+
+#if NV_CPU_X86_SIMD
+  if (nv_cpu_has(NV_CPU_AVX2)) { return popcount_avx2(set->data, set->words); }
+  if (nv_cpu_has(NV_CPU_POPCNT)) { return popcount_popcnt(set->data, set->words); }
+#endif
+  return popcount_scalar(set->data, set->words);
+}
+
+/*
+ * Find
+ */
+
+size_t
+nv_bitset_find_next_set(const nv_bitset_t* set, size_t from)
+{
+  nv_assert_else_return(set != NULL, SIZE_MAX);
+  if (from >= set->size) { return SIZE_MAX; }
+
+  size_t w    = from / WORD_BITS;
+  u64    word = set->data[w] & (ALL_ONES << (from % WORD_BITS));
+
+  while (word == 0)
+  {
+    if (++w >= set->words) { return SIZE_MAX; }
+    word = set->data[w];
+  }
+
+  return (w * WORD_BITS) + (size_t)nv_ctz64(word);
+}
+
+size_t
+nv_bitset_find_first_set(const nv_bitset_t* set)
+{
+  return nv_bitset_find_next_set(set, 0);
 }
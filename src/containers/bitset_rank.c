@@ -0,0 +1,224 @@
+#include "../../include/containers/bitset_rank.h"
+
+#include "../../include/containers/bitset.h"
+#include "../../include/cpu.h"
+#include "../../include/error.h"
+#include "../../include/stdafx.h"
+#include "../../include/types.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if NV_CPU_X86_SIMD
+#  include <immintrin.h>
+#endif
+
+#define BLOCK_BITS    NV_BITSET_RANK_BLOCK_BITS
+#define BLOCK_WORDS   (BLOCK_BITS / 64)
+#define SUB_WORDS     8
+#define SUB_MASK      0x3FFU
+#define STRETCH_SHIFT 21 // 2^21 blocks of 2048 bits make up the 2^32 bits one absolute count covers
+#define SAMPLE        NV_BITSET_SELECT_SAMPLE
+
+static inline u64
+pack_block(u64 before, const u32* subs)
+{
+  return before | ((u64)subs[0] << 32U) | ((u64)subs[1] << 42U) | ((u64)subs[2] << 52U);
+}
+
+static inline u32
+sub_count(u64 entry, size_t sub)
+{
+  return (u32)(entry >> (32U + (10U * sub))) & SUB_MASK;
+}
+
+/* The number of set bits before 'block'. */
+static inline size_t
+block_before(const nv_bitset_rank_t* index, size_t block)
+{
+  return (size_t)(index->counts[block >> STRETCH_SHIFT] + (index->blocks[block] & 0xFFFFFFFFU));
+}
+
+/* The position of the set bit of 'word' with 'k' set bits below it. */
+static inline u32
+select_in_word_generic(u64 word, u32 k)
+{
+  for (; k; k--) { word &= word - 1; }
+  return nv_ctz64(word);
+}
+
+#if NV_CPU_X86_SIMD
+NV_CPU_TARGET("bmi2") static inline u32
+select_in_word_pdep(u64 word, u32 k)
+{
+  return (u32)__builtin_ctzll(_pdep_u64((u64)1 << k, word));
+}
+#endif
+
+/*
+ * The kernels are stamped out once per instruction set so that the popcounts compile to popcnt where it is available.
+ * The generic ones stick to the portable helpers from stdafx.h.
+ */
+
+#define KERNELS(S, ATTR, POPCOUNT, SELECT_IN_WORD)                                                                                                                            \
+  ATTR static void build_##S(nv_bitset_rank_t* index)                                                                                                                         \
+  {                                                                                                                                                                           \
+    const u64*   words       = index->set->data;                                                                                                                              \
+    const size_t word_count  = index->set->words;                                                                                                                             \
+    u64          total       = 0;                                                                                                                                             \
+    u64          next_sample = 0;                                                                                                                                             \
+    size_t       samples     = 0;                                                                                                                                             \
+                                                                                                                                                                              \
+    for (size_t b = 0; b < index->block_count; b++)                                                                                                                           \
+    {                                                                                                                                                                         \
+      if ((b & (((size_t)1 << STRETCH_SHIFT) - 1)) == 0) { index->counts[b >> STRETCH_SHIFT] = total; }                                                                       \
+                                                                                                                                                                              \
+      u32          subs[4] = { 0 };                                                                                                                                           \
+      const size_t first   = b * BLOCK_WORDS;                                                                                                                                 \
+      const size_t end     = NV_MIN(first + BLOCK_WORDS, word_count);                                                                                                         \
+      for (size_t w = first; w < end; w++) { subs[(w - first) / SUB_WORDS] += (u32)POPCOUNT(words[w]); }                                                                      \
+                                                                                                                                                                              \
+      const u32 ones   = subs[0] + subs[1] + subs[2] + subs[3];                                                                                                               \
+      index->blocks[b] = pack_block(total - index->counts[b >> STRETCH_SHIFT], subs);                                                                                         \
+      for (; next_sample < total + ones; next_sample += SAMPLE) { index->samples[samples++] = (u32)b; }                                                                       \
+      total += ones;                                                                                                                                                          \
+    }                                                                                                                                                                         \
+  }                                                                                                                                                                           \
+                                                                                                                                                                              \
+  ATTR static size_t rank_##S(const nv_bitset_rank_t* index, size_t bitindex)                                                                                                 \
+  {                                                                                                                                                                           \
+    const u64*   words = index->set->data;                                                                                                                                    \
+    const size_t block = bitindex / BLOCK_BITS;                                                                                                                               \
+    const size_t sub   = (bitindex % BLOCK_BITS) / (SUB_WORDS * 64);                                                                                                          \
+    const size_t word  = bitindex / 64;                                                                                                                                       \
+    const u64    entry = index->blocks[block];                                                                                                                                \
+    size_t       rank  = block_before(index, block);                                                                                                                          \
+                                                                                                                                                                              \
+    for (size_t s = 0; s < sub; s++) { rank += sub_count(entry, s); }                                                                                                         \
+    for (size_t w = (block * BLOCK_WORDS) + (sub * SUB_WORDS); w < word; w++) { rank += (size_t)POPCOUNT(words[w]); }                                                         \
+    if (bitindex % 64) { rank += (size_t)POPCOUNT(words[word] & (((u64)1 << (bitindex % 64)) - 1)); }                                                                         \
+    return rank;                                                                                                                                                              \
+  }                                                                                                                                                                           \
+                                                                                                                                                                              \
+  ATTR static size_t select_##S(const nv_bitset_rank_t* index, size_t k)                                                                                                      \
+  {                                                                                                                                                                           \
+    /* the k-th set bit is in a block between the samples around it, find the last one with at most k before it. */                                                           \
+    const size_t sample = k / SAMPLE;                                                                                                                                         \
+    size_t       lo     = index->samples[sample];                                                                                                                             \
+    size_t       hi     = sample + 1 < index->sample_count ? (size_t)index->samples[sample + 1] + 1 : index->block_count;                                                     \
+    while (hi - lo > 1)                                                                                                                                                       \
+    {                                                                                                                                                                         \
+      const size_t mid = lo + ((hi - lo) / 2);                                                                                                                                \
+      if (block_before(index, mid) <= k) { lo = mid; }                                                                                                                        \
+      else { hi = mid; }                                                                                                                                                      \
+    }                                                                                                                                                                         \
+                                                                                                                                                                              \
+    const u64 entry = index->blocks[lo];                                                                                                                                      \
+    size_t    rest  = k - block_before(index, lo);                                                                                                                            \
+    size_t    sub   = 0;                                                                                                                                                      \
+    for (; sub < 3 && rest >= sub_count(entry, sub); sub++) { rest -= sub_count(entry, sub); }                                                                                \
+                                                                                                                                                                              \
+    const u64* words = index->set->data;                                                                                                                                      \
+    size_t     w     = (lo * BLOCK_WORDS) + (sub * SUB_WORDS);                                                                                                                \
+    for (;; w++)                                                                                                                                                              \
+    {                                                                                                                                                                         \
+      const size_t ones = (size_t)POPCOUNT(words[w]);                                                                                                                         \
+      if (rest < ones) { break; }                                                                                                                                             \
+      rest -= ones;                                                                                                                                                           \
+    }                                                                                                                                                                         \
+    return (w * 64) + SELECT_IN_WORD(words[w], (u32)rest);                                                                                                                    \
+  }
+
+KERNELS(generic, , nv_popcount64, select_in_word_generic)
+
+#if NV_CPU_X86_SIMD
+KERNELS(bmi2, NV_CPU_TARGET("popcnt,bmi2"), __builtin_popcountll, select_in_word_pdep)
+#  define FAST_KERNELS nv_cpu_has(NV_CPU_POPCNT | NV_CPU_BMI2)
+#else
+#  define FAST_KERNELS 0
+#  define build_bmi2   build_generic
+#  define rank_bmi2    rank_generic
+#  define select_bmi2  select_generic
+#endif
+
+static void
+free_tables(nv_bitset_rank_t* index)
+{
+  nv_alloc_free(index->alloc, index->counts);
+  nv_alloc_free(index->alloc, index->blocks);
+  nv_alloc_free(index->alloc, index->samples);
+  index->counts  = NULL;
+  index->blocks  = NULL;
+  index->samples = NULL;
+}
+
+nv_error
+nv_bitset_rank_init(const nv_bitset_t* set, nv_allocator_t* allocator, nv_bitset_rank_t* index)
+{
+  nv_assert_else_return(set != NULL, NV_ERROR_INVALID_ARG);
+  nv_assert_else_return(index != NULL, NV_ERROR_INVALID_ARG);
+
+  *index       = nv_zinit(nv_bitset_rank_t);
+  index->set   = set;
+  index->alloc = allocator ? allocator : (set->alloc ? set->alloc : nv_alloc_current);
+
+  return nv_bitset_rank_rebuild(index);
+}
+
+nv_error
+nv_bitset_rank_rebuild(nv_bitset_rank_t* index)
+{
+  nv_assert_else_return(index != NULL && index->set != NULL, NV_ERROR_INVALID_ARG);
+
+  const nv_bitset_t* set = index->set;
+
+  free_tables(index);
+  index->block_count  = (set->words + BLOCK_WORDS - 1) / BLOCK_WORDS;
+  index->count_count  = (index->block_count + ((size_t)1 << STRETCH_SHIFT) - 1) >> STRETCH_SHIFT;
+  index->ones         = nv_bitset_popcount(set);
+  index->sample_count = (index->ones + SAMPLE - 1) / SAMPLE;
+
+  // samples hold block indices as u32, enough for 2^43 bits.
+  nv_assert_else_return(index->block_count <= UINT32_MAX, NV_ERROR_TOO_BIG);
+
+  // one extra element each, so that an empty set still gets valid (if unused) tables.
+  index->counts  = nv_alloc_zmalloc(index->alloc, (index->count_count + 1) * sizeof(u64));
+  index->blocks  = nv_alloc_zmalloc(index->alloc, (index->block_count + 1) * sizeof(u64));
+  index->samples = nv_alloc_zmalloc(index->alloc, (index->sample_count + 1) * sizeof(u32));
+  if (!index->counts || !index->blocks || !index->samples)
+  {
+    free_tables(index);
+    return NV_ERROR_MALLOC_FAILED;
+  }
+
+  FAST_KERNELS ? build_bmi2(index) : build_generic(index);
+  return NV_SUCCESS;
+}
+
+void
+nv_bitset_rank_destroy(nv_bitset_rank_t* index)
+{
+  if (!index) { return; }
+
+  free_tables(index);
+
+  nv_bzero(index, sizeof(nv_bitset_rank_t));
+}
+
+size_t
+nv_bitset_rank(const nv_bitset_rank_t* index, size_t bitindex)
+{
+  nv_assert_else_return(index != NULL, 0);
+
+  if (bitindex >= index->set->size) { return index->ones; }
+  return FAST_KERNELS ? rank_bmi2(index, bitindex) : rank_generic(index, bitindex);
+}
+
+size_t
+nv_bitset_select(const nv_bitset_rank_t* index, size_t k)
+{
+  nv_assert_else_return(index != NULL, SIZE_MAX);
+
+  if (k >= index->ones) { return SIZE_MAX; }
+  return FAST_KERNELS ? select_bmi2(index, k) : select_generic(index, k);
+}
@@ -0,0 +1,237 @@
+#include "../../include/containers/deque.h"
+
+#include "../../include/alloc.h"
+#include "../../include/error.h"
+#include "../../include/stdafx.h"
+#include "../../include/string.h"
+#include "../../include/types.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+static inline size_t
+nv_deque_round_capacity(size_t capacity)
+{
+  size_t c = NV_DEQUE_MIN_CAPACITY;
+  while (c < capacity) { c <<= 1; }
+  return c;
+}
+
+static inline uchar*
+nv_deque_slot(const nv_deque_t* deque, size_t i)
+{
+  return (uchar*)deque->data + ((deque->head + i) & (deque->capacity - 1)) * deque->type_size;
+}
+
+nv_error
+nv_deque_init(size_t type_size, size_t init_capacity, nv_deque_t* deque)
+{
+  return nv_deque_init_with_allocator(type_size, init_capacity, NULL, deque);
+}
+
+nv_error
+nv_deque_init_with_allocator(size_t type_size, size_t init_capacity, nv_allocator_t* allocator, nv_deque_t* deque)
+{
+  nv_assert_else_return(type_size > 0, NV_ERROR_INVALID_ARG);
+
+  *deque = nv_zinit(nv_deque_t);
+
+  deque->type_size = type_size;
+  deque->canary    = NOVA_CONT_CANARY;
+  deque->alloc     = allocator ? allocator : nv_alloc_current;
+
+  if (init_capacity > 0) { return nv_deque_reserve(deque, init_capacity); }
+
+  return NV_ERROR_SUCCESS;
+}
+
+void
+nv_deque_destroy(nv_deque_t* deque)
+{
+  if (deque)
+  {
+    nv_assert(NOVA_CONT_IS_VALID(deque));
+    if (deque->data) { nv_alloc_free(deque->alloc, deque->data); }
+    deque->data     = NULL;
+    deque->capacity = 0;
+    deque->size     = 0;
+    deque->head     = 0;
+  }
+}
+
+nv_error
+nv_deque_reserve(nv_deque_t* deque, size_t new_capacity)
+{
+  nv_assert_else_return(NOVA_CONT_IS_VALID(deque), NV_ERROR_INVALID_ARG);
+  if (new_capacity <= deque->capacity) { return NV_ERROR_SUCCESS; }
+
+  const size_t old_capacity = deque->capacity;
+  new_capacity              = nv_deque_round_capacity(new_capacity);
+
+  void* data = NULL;
+  if (deque->data) { data = nv_alloc_realloc(deque->alloc, deque->data, new_capacity * deque->type_size); }
+  else
+  {
+    data = nv_alloc_zmalloc(deque->alloc, new_capacity * deque->type_size);
+  }
+  if (!data) { return NV_ERROR_MALLOC_FAILED; }
+
+  deque->data     = data;
+  deque->capacity = new_capacity;
+
+  /**
+   * If the elements wrapped around the old buffer, the wrapped part is at the start of the buffer.
+   * The capacity atleast doubled, so it always fits right after the old end, which unwraps the deque.
+   */
+  if (deque->head + deque->size > old_capacity)
+  {
+    const size_t wrapped = deque->head + deque->size - old_capacity;
+    nv_memcpy((uchar*)data + old_capacity * deque->type_size, data, wrapped * deque->type_size);
+  }
+
+  return NV_ERROR_SUCCESS;
+}
+
+void
+nv_deque_clear(nv_deque_t* deque)
+{
+  if (!deque) { return; }
+
+  nv_assert(NOVA_CONT_IS_VALID(deque));
+  deque->size = 0;
+  deque->head = 0;
+}
+
+nv_error
+nv_deque_push_back(nv_deque_t* NV_RESTRICT deque, const void* NV_RESTRICT elem)
+{
+  nv_assert_else_return(NOVA_CONT_IS_VALID(deque), NV_ERROR_INVALID_ARG);
+
+  if (NV_UNLIKELY(deque->size == deque->capacity))
+  {
+    nv_error e = nv_deque_reserve(deque, NV_MAX((size_t)1, deque->capacity * 2));
+    if (e != NV_ERROR_SUCCESS) { return e; }
+  }
+
+  nv_memcpy_small(nv_deque_slot(deque, deque->size), elem, deque->type_size);
+  deque->size++;
+
+  return NV_ERROR_SUCCESS;
+}
+
+nv_error
+nv_deque_push_front(nv_deque_t* NV_RESTRICT deque, const void* NV_RESTRICT elem)
+{
+  nv_assert_else_return(NOVA_CONT_IS_VALID(deque), NV_ERROR_INVALID_ARG);
+
+  if (NV_UNLIKELY(deque->size == deque->capacity))
+  {
+    nv_error e = nv_deque_reserve(deque, NV_MAX((size_t)1, deque->capacity * 2));
+    if (e != NV_ERROR_SUCCESS) { return e; }
+  }
+
+  deque->head = (deque->head - 1) & (deque->capacity - 1);
+  nv_memcpy_small(nv_deque_slot(deque, 0), elem, deque->type_size);
+  deque->size++;
+
+  return NV_ERROR_SUCCESS;
+}
+
+bool
+nv_deque_pop_back(nv_deque_t* NV_RESTRICT deque, void* NV_RESTRICT out)
+{
+  nv_assert_else_return(NOVA_CONT_IS_VALID(deque), false);
+  if (deque->size == 0) { return false; }
+
+  deque->size--;
+  if (out) { nv_memcpy_small(out, nv_deque_slot(deque, deque->size), deque->type_size); }
+
+  return true;
+}
+
+bool
+nv_deque_pop_front(nv_deque_t* NV_RESTRICT deque, void* NV_RESTRICT out)
+{
+  nv_assert_else_return(NOVA_CONT_IS_VALID(deque), false);
+  if (deque->size == 0) { return false; }
+
+  if (out) { nv_memcpy_small(out, nv_deque_slot(deque, 0), deque->type_size); }
+  deque->head = (deque->head + 1) & (deque->capacity - 1);
+  deque->size--;
+
+  // keep the elements from wrapping when we can, it keeps the spans whole
+  if (deque->size == 0) { deque->head = 0; }
+
+  return true;
+}
+
+nv_error
+nv_deque_push_back_n(nv_deque_t* NV_RESTRICT deque, const void* NV_RESTRICT elems, size_t count)
+{
+  nv_assert_else_return(NOVA_CONT_IS_VALID(deque), NV_ERROR_INVALID_ARG);
+  if (count == 0) { return NV_ERROR_SUCCESS; }
+  nv_assert_else_return(elems != NULL, NV_ERROR_INVALID_ARG);
+
+  if (deque->size + count > deque->capacity)
+  {
+    nv_error e = nv_deque_reserve(deque, NV_MAX(deque->size + count, deque->capacity * 2));
+    if (e != NV_ERROR_SUCCESS) { return e; }
+  }
+
+  const size_t tail  = (deque->head + deque->size) & (deque->capacity - 1);
+  const size_t first = NV_MIN(count, deque->capacity - tail);
+  const uchar* src   = (const uchar*)elems;
+
+  nv_memcpy((uchar*)deque->data + tail * deque->type_size, src, first * deque->type_size);
+  if (count > first) { nv_memcpy(deque->data, src + first * deque->type_size, (count - first) * deque->type_size); }
+
+  deque->size += count;
+
+  return NV_ERROR_SUCCESS;
+}
+
+size_t
+nv_deque_pop_front_n(nv_deque_t* NV_RESTRICT deque, void* NV_RESTRICT out, size_t count)
+{
+  nv_assert_else_return(NOVA_CONT_IS_VALID(deque), 0);
+
+  count = NV_MIN(count, deque->size);
+  if (count == 0) { return 0; }
+
+  if (out)
+  {
+    const size_t first = NV_MIN(count, deque->capacity - deque->head);
+    uchar*       dst   = (uchar*)out;
+
+    nv_memcpy(dst, (uchar*)deque->data + deque->head * deque->type_size, first * deque->type_size);
+    if (count > first) { nv_memcpy(dst + first * deque->type_size, deque->data, (count - first) * deque->type_size); }
+  }
+
+  deque->head = (deque->head + count) & (deque->capacity - 1);
+  deque->size -= count;
+  if (deque->size == 0) { deque->head = 0; }
+
+  return count;
+}
+
+int
+nv_deque_spans(const nv_deque_t* deque, nv_deque_span_t spans[2])
+{
+  nv_assert_else_return(NOVA_CONT_IS_VALID(deque), 0);
+
+  spans[0] = (nv_deque_span_t){ NULL, 0 };
+  spans[1] = (nv_deque_span_t){ NULL, 0 };
+
+  if (deque->size == 0) { return 0; }
+
+  const size_t first = NV_MIN(deque->size, deque->capacity - deque->head);
+
+  spans[0].data  = (uchar*)deque->data + deque->head * deque->type_size;
+  spans[0].count = first;
+  if (first == deque->size) { return 1; }
+
+  spans[1].data  = deque->data;
+  spans[1].count = deque->size - first;
+  return 2;
+}
@@ -38,14 +38,22 @@ next_power_of_two(u32 num)
 
 nv_error
 nv_hashmap_init(size_t key_size, size_t value_size, nv_hash_fn hash_fn, nv_compare_fn comp_fn, size_t init_capacity, nv_hashmap_t* dst)
+{
+  return nv_hashmap_init_with_allocator(key_size, value_size, hash_fn, comp_fn, init_capacity, NULL, dst);
+}
 
+nv_error
+nv_hashmap_init_with_allocator(
+    size_t key_size, size_t value_size, nv_hash_fn hash_fn, nv_compare_fn comp_fn, size_t init_capacity, nv_allocator_t* allocator, nv_hashmap_t* dst)
 {
   nv_assert_else_return(dst != NULL, NV_ERROR_INVALID_ARG);
 
   *dst = nv_zinit(nv_hashmap_t);
 
+  dst->alloc = allocator ? allocator : nv_alloc_current;
+
   init_capacity = next_power_of_two(init_capacity);
-  dst->nodes    = init_capacity == 0 ? NULL : (nv_hashmap_node_t*)nv_zmalloc(init_capacity * sizeof(nv_hashmap_node_t));
+  dst->nodes    = init_capacity == 0 ? NULL : (nv_hashmap_node_t*)nv_alloc_zmalloc(dst->alloc, init_capacity * sizeof(nv_hashmap_node_t));
   nv_assert_else_return(dst->nodes != NULL, NV_ERROR_MALLOC_FAILED);
 
   if (key_size != 0) { dst->hash_fn = hash_fn ? hash_fn : nv_hash_fnv1a; }
@@ -78,51 +86,53 @@ nv_hashmap_destroy(nv_hashmap_t* map)
 
       if (NODE_OCCUPIED(*node))
       {
-        nv_free(node->key);
-        nv_free(node->value);
+        nv_alloc_free(map->alloc, node->key);
+        nv_alloc_free(map->alloc, node->value);
       }
     }
-    nv_free(map->nodes);
+    nv_alloc_free(map->alloc, map->nodes);
     map->nodes = NULL;
   }
 }
 
-static inline void
+static inline bool
 nv_hashmap_resize_unsafe(nv_hashmap_t* map, size_t new_capacity)
 {
   nv_assert(NOVA_CONT_IS_VALID(map));
 
-  nv_hashmap_node_t* old_nodes   = map->nodes;
-  const size_t       old_entries = map->capacity;
-
   if (new_capacity <= 0) { new_capacity = 1; }
 
-  map->capacity = next_power_of_two(new_capacity);
-  map->size     = 0;
+  // never shrink below what the current nodes need, the probing would not terminate.
+  if ((double)new_capacity * NV_HASHMAP_LOAD_FACTOR < (double)map->size) { new_capacity = (size_t)((double)map->size / NV_HASHMAP_LOAD_FACTOR) + 1; }
+  new_capacity = next_power_of_two(new_capacity);
 
   // we can't do realloc here because we need to rehash all the nodes
-  map->nodes = (nv_hashmap_node_t*)nv_zmalloc(map->capacity * sizeof(nv_hashmap_node_t));
-  nv_assert(map->nodes != NULL);
+  nv_hashmap_node_t* new_nodes = (nv_hashmap_node_t*)nv_alloc_zmalloc(map->alloc, new_capacity * sizeof(nv_hashmap_node_t));
+  if (!new_nodes) { return false; } // keep the old table, it is still valid
 
-  if (old_nodes)
+  // move the nodes over as they are, the keys and values stay where they are and the hashes are already known.
+  if (map->nodes)
   {
-    for (size_t i = 0; i < old_entries; i++)
+    for (size_t i = 0; i < map->capacity; i++)
     {
-      nv_hashmap_node_t* old_node = &old_nodes[i];
-      if (NODE_OCCUPIED(*old_node))
+      nv_hashmap_node_t* old_node = &map->nodes[i];
+      if (!NODE_OCCUPIED(*old_node)) { continue; }
+
+      u32 index = old_node->hash & (new_capacity - 1);
+      u32 probe = 0;
+      while (NODE_OCCUPIED(new_nodes[index]))
       {
-        nv_hashmap_insert(map, old_node->key, old_node->value);
-
-        // node copied, free old key and value
-        nv_free(old_node->key);
-        nv_free(old_node->value);
-        // Safety!
-        old_node->key   = NULL;
-        old_node->value = NULL;
+        probe++;
+        index = (old_node->hash + probe + probe * probe) & (new_capacity - 1);
       }
+      new_nodes[index] = *old_node;
     }
-    nv_free(old_nodes);
+    nv_alloc_free(map->alloc, map->nodes);
   }
+
+  map->nodes    = new_nodes;
+  map->capacity = new_capacity;
+  return true;
 }
 
 void
@@ -143,11 +153,11 @@ nv_hashmap_clear(nv_hashmap_t* map)
     {
       if (map->key_size == 0) // key is string
       {
-        nv_free(node->key);
+        nv_alloc_free(map->alloc, node->key);
       }
       if (map->value_size == 0) // value is string
       {
-        nv_free(node->value);
+        nv_alloc_free(map->alloc, node->value);
       }
     }
   }
@@ -256,7 +266,7 @@ nv_hashmap_insert_internal_unsafe(nv_hashmap_t* map, const void* NV_RESTRICT key
   {
     // The check to whether map->entries is greater than 0 is already done in
     // resize();
-    nv_hashmap_resize_unsafe(map, map->capacity * 2);
+    if (!nv_hashmap_resize_unsafe(map, map->capacity * 2)) { return NULL; }
   }
 
   size_t actual_key_size   = map->key_size;
@@ -277,8 +287,11 @@ nv_hashmap_insert_internal_unsafe(nv_hashmap_t* map, const void* NV_RESTRICT key
       {
         if (map->value_size == 0) // is the value a string?
         {
-          if (node->value) { nv_free(node->value); }
-          node->value = nv_strdup((const char*)value);
+          // the old string is only freed once its replacement exists, a failed dup leaves the node as it was.
+          char* new_value = nv_alloc_strdup(map->alloc, (const char*)value);
+          if (NV_UNLIKELY(!new_value)) { return NULL; }
+          if (node->value) { nv_alloc_free(map->alloc, node->value); }
+          node->value = new_value;
         }
         else
         {
@@ -294,25 +307,22 @@ nv_hashmap_insert_internal_unsafe(nv_hashmap_t* map, const void* NV_RESTRICT key
     node = &map->nodes[index];
   }
 
-  *node = nv_zinit(nv_hashmap_node_t);
+  void* new_key   = nv_alloc_memdup(map->alloc, key, actual_key_size);
+  void* new_value = nv_alloc_memdup(map->alloc, value, actual_value_size);
 
-  node->key   = nv_zmalloc(actual_key_size);
-  node->value = nv_zmalloc(actual_value_size);
-  node->hash  = hash;
-
-  if (map->key_size != NV_HASHMAP_SIZE_STRING) { nv_memcpy(node->key, key, map->key_size); }
-  else
+  // the node is only claimed once both allocations went through, so a failed insert leaves the map untouched.
+  if (NV_UNLIKELY(!new_key || !new_value))
   {
-    if (node->key) { nv_free(node->key); }
-    node->key = nv_strdup((const char*)key);
+    if (new_key) { nv_alloc_free(map->alloc, new_key); }
+    if (new_value) { nv_alloc_free(map->alloc, new_value); }
+    return NULL;
   }
 
-  if (map->value_size != NV_HASHMAP_SIZE_STRING) { nv_memcpy(node->value, value, map->value_size); }
-  else
-  {
-    if (node->value) { nv_free(node->value); }
-    node->value = nv_strdup((const char*)value);
-  }
+  *node = nv_zinit(nv_hashmap_node_t);
+
+  node->key   = new_key;
+  node->value = new_value;
+  node->hash  = hash;
 
   map->size++;
 
@@ -413,7 +423,7 @@ nv_hashmap_deserialize(nv_hashmap_t* map, FILE* f)
       size_t len = 0;
       fread(&len, sizeof(len), 1, f);
 
-      char* s = nv_zmalloc(len + 1);
+      char* s = nv_alloc_zmalloc(map->alloc, len + 1);
       fread(s, sizeof(char), len, f);
       s[len] = 0;
 
@@ -421,7 +431,7 @@ nv_hashmap_deserialize(nv_hashmap_t* map, FILE* f)
     }
     else
     {
-      key = nv_zmalloc(map->key_size);
+      key = nv_alloc_zmalloc(map->alloc, map->key_size);
       fread(key, map->key_size, 1, f);
     }
 
@@ -431,7 +441,7 @@ nv_hashmap_deserialize(nv_hashmap_t* map, FILE* f)
       size_t len = 0;
       fread(&len, sizeof(len), 1, f);
 
-      char* s = nv_zmalloc(len + 1);
+      char* s = nv_alloc_zmalloc(map->alloc, len + 1);
       fread(s, sizeof(char), len, f);
       s[len] = 0;
 
@@ -439,14 +449,14 @@ nv_hashmap_deserialize(nv_hashmap_t* map, FILE* f)
     }
     else
     {
-      value = nv_zmalloc(map->value_size);
+      value = nv_alloc_zmalloc(map->alloc, map->value_size);
       fread(value, map->value_size, 1, f);
     }
 
     nv_hashmap_insert_internal_unsafe(map, key, value, true);
 
-    nv_free(key);
-    nv_free(value);
+    nv_alloc_free(map->alloc, key);
+    nv_alloc_free(map->alloc, value);
   }
 }
 
@@ -461,8 +471,8 @@ nv_hashmap_delete(nv_hashmap_t* map, const void* key)
   nv_hashmap_node_t* node = find_node(map, key);
   if (node)
   {
-    if (map->key_size == 0 && node->key != NULL) nv_free(node->key);       // key is string, free key
-    if (map->value_size == 0 && node->value != NULL) nv_free(node->value); // value is string free value
+    if (map->key_size == 0 && node->key != NULL) nv_alloc_free(map->alloc, node->key);       // key is string, free key
+    if (map->value_size == 0 && node->value != NULL) nv_alloc_free(map->alloc, node->value); // value is string free value
     *node = nv_zinit(nv_hashmap_node_t);
 
     deleted = true;
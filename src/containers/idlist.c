@@ -3,31 +3,181 @@
 #include "../../include/alloc.h"
 #include "../../include/string.h"
 
+#define FREE_SLOT_END UINT32_MAX
+
+/* Slots 0..MAX_SLOTS - 1, the last index is left out so that no ID can be NV_ID_LIST_INVALID_ID. */
+#define MAX_SLOTS (NV_ID_LIST_INDEX_MASK < UINT32_MAX ? NV_ID_LIST_INDEX_MASK : (size_t)UINT32_MAX)
+
+/*
+ * ID table, shared by nv_id_list_t and nv_id_columns_t.
+ * 'index_to_id' and 'size' belong to the container, they are passed in where a lookup needs to check the back reference.
+ */
+
+static inline size_t
+make_id(size_t slot, u32 generation)
+{
+  return ((size_t)generation << NV_ID_LIST_INDEX_BITS) | slot;
+}
+
+static nv_error
+table_init(nv_id_table_t* table, size_t capacity, nv_allocator_t* alloc)
+{
+  table->slots     = (nv_id_slot_t*)nv_alloc_zmalloc(alloc, capacity * sizeof(nv_id_slot_t));
+  table->count     = 0;
+  table->capacity  = capacity;
+  table->free_slot = FREE_SLOT_END;
+  return table->slots ? NV_SUCCESS : NV_ERROR_MALLOC_FAILED;
+}
+
+static bool
+table_reserve(nv_id_table_t* table, size_t count, nv_allocator_t* alloc)
+{
+  if (count <= table->capacity) { return true; }
+
+  nv_id_slot_t* new_slots = (nv_id_slot_t*)nv_alloc_realloc(alloc, table->slots, count * sizeof(nv_id_slot_t));
+  if (NV_UNLIKELY(!new_slots)) { return false; }
+
+  table->slots    = new_slots;
+  table->capacity = count;
+  return true;
+}
+
+/* Make sure that 'live' elements can have a slot, growing geometrically. */
+static bool
+table_reserve_for(nv_id_table_t* table, size_t live, nv_allocator_t* alloc)
+{
+  // every slot handed out but not live is on the free list, so 'live' slots are enough
+  if (live <= table->capacity) { return true; }
+  return table_reserve(table, NV_MIN(NV_MAX(live, table->capacity * 2), MAX_SLOTS), alloc);
+}
+
+/* Take a slot off the free list, or a new one. SIZE_MAX if the ID table is full or can't grow. */
+static size_t
+table_acquire(nv_id_table_t* table, nv_allocator_t* alloc)
+{
+  if (table->free_slot != FREE_SLOT_END)
+  {
+    const size_t slot = table->free_slot;
+    table->free_slot  = table->slots[slot].index;
+    return slot;
+  }
+
+  if (table->count >= MAX_SLOTS) return SIZE_MAX;
+  if (table->count == table->capacity && !table_reserve(table, NV_MIN(NV_MAX(table->capacity * 2, 2), MAX_SLOTS), alloc)) return SIZE_MAX;
+
+  table->slots[table->count].generation = 0;
+  return table->count++;
+}
+
+static inline void
+table_release(nv_id_table_t* table, size_t slot)
+{
+  nv_id_slot_t* s  = &table->slots[slot];
+  s->generation    = (u32)((s->generation + 1) & NV_ID_LIST_GENERATION_MASK);
+  s->index         = table->free_slot;
+  table->free_slot = (u32)slot;
+}
+
+/* The element index of a live ID, SIZE_MAX if it is stale or was never handed out. */
+static inline size_t
+table_lookup(const nv_id_table_t* table, const size_t* index_to_id, size_t size, size_t id)
+{
+  const size_t slot = nv_id_list_id_slot(id);
+  if (slot >= table->count) return SIZE_MAX;
+
+  const nv_id_slot_t s = table->slots[slot];
+  // a free slot's index is a free list link, the back reference check rejects it
+  if (s.generation != nv_id_list_id_generation(id) || s.index >= size || index_to_id[s.index] != id) return SIZE_MAX;
+  return s.index;
+}
+
+/* Hand out an ID for a new element at 'index', NV_ID_LIST_INVALID_ID if out of slots. */
+static inline size_t
+table_push(nv_id_table_t* table, size_t* index_to_id, size_t index, nv_allocator_t* alloc)
+{
+  const size_t slot = table_acquire(table, alloc);
+  if (NV_UNLIKELY(slot == SIZE_MAX)) return NV_ID_LIST_INVALID_ID;
+
+  const size_t id          = make_id(slot, table->slots[slot].generation);
+  table->slots[slot].index = (u32)index;
+  index_to_id[index]       = id;
+  return id;
+}
+
+/* The ID bookkeeping of a swap remove: the element at 'last' has moved to 'index', the one at 'index' is gone. */
+static inline void
+table_remove(nv_id_table_t* table, size_t* index_to_id, size_t index, size_t last)
+{
+  const size_t id = index_to_id[index];
+  if (index != last)
+  {
+    const size_t moved_id                            = index_to_id[last];
+    table->slots[nv_id_list_id_slot(moved_id)].index = (u32)index;
+    index_to_id[index]                               = moved_id;
+  }
+  table_release(table, nv_id_list_id_slot(id));
+  index_to_id[last] = NV_ID_LIST_INVALID_ID;
+}
+
+/*
+ * Capacity policy, shared as well.
+ * Storage doubles when full. It shrinks once the container is down to a quarter of its capacity, and only to half of it
+ * (repeatedly, after batch deletes), so that going back and forth over a power of two doesn't reallocate every time.
+ */
+
+static inline size_t
+grown_capacity(size_t capacity, size_t required)
+{
+  size_t new_capacity = NV_MAX(capacity, (size_t)NV_ID_LIST_MIN_CAPACITY);
+  while (new_capacity < required) { new_capacity *= 2; }
+  return new_capacity;
+}
+
+/* The capacity to shrink to, 'capacity' if it should stay. */
+static inline size_t
+shrunk_capacity(size_t capacity, size_t size, size_t reserved)
+{
+  const size_t floor        = NV_MAX(reserved, (size_t)NV_ID_LIST_MIN_CAPACITY);
+  size_t       new_capacity = capacity;
+  while (new_capacity > floor && size <= new_capacity / 4) { new_capacity = NV_MAX(new_capacity / 2, floor); }
+  return new_capacity;
+}
+
+/*
+ * nv_id_list_t
+ */
+
 nv_error
 nv_id_list_init(size_t type_size, size_t init_capacity, nv_id_list_t* idlist)
+{
+  return nv_id_list_init_with_allocator(type_size, init_capacity, NULL, idlist);
+}
+
+nv_error
+nv_id_list_init_with_allocator(size_t type_size, size_t init_capacity, nv_allocator_t* allocator, nv_id_list_t* idlist)
 {
   nv_bzero(idlist, sizeof(*idlist));
 
   if (init_capacity == 0) { init_capacity = 2; }
+  if (!allocator) { allocator = nv_alloc_current; }
 
-  /* Combined allocation for both the ID table and the elements. */
-  void*   data          = nv_zmalloc(init_capacity * type_size);
-  size_t* id_to_indices = (size_t*)nv_zmalloc(init_capacity * sizeof(size_t));
-  size_t* indices_to_id = (size_t*)nv_zmalloc(init_capacity * sizeof(size_t));
-  if (!data || !id_to_indices || !indices_to_id)
+  void*    data        = nv_alloc_zmalloc(allocator, init_capacity * type_size);
+  size_t*  index_to_id = (size_t*)nv_alloc_zmalloc(allocator, init_capacity * sizeof(size_t));
+  nv_error e           = table_init(&idlist->table, init_capacity, allocator);
+  if (!data || !index_to_id || e != NV_SUCCESS)
   {
-    nv_free(data);
-    nv_free(id_to_indices);
-    nv_free(indices_to_id);
+    nv_alloc_free(allocator, data);
+    nv_alloc_free(allocator, index_to_id);
+    nv_alloc_free(allocator, idlist->table.slots);
     return NV_ERROR_MALLOC_FAILED;
   }
 
   idlist->canary      = 0xFEF6324;
   idlist->capacity    = init_capacity;
   idlist->data        = data;
-  idlist->id_to_index = id_to_indices;
-  idlist->index_to_id = indices_to_id;
+  idlist->index_to_id = index_to_id;
   idlist->type_size   = type_size;
+  idlist->alloc       = allocator;
 
   return NV_SUCCESS;
 }
@@ -38,31 +188,77 @@ nv_id_list_destroy(nv_id_list_t* idlist)
   if (!idlist) return;
   if (idlist->canary != 0xFEF6324) return;
 
-  nv_free(idlist->id_to_index);
-  nv_free(idlist->index_to_id);
-  nv_free(idlist->data);
+  nv_alloc_free(idlist->alloc, idlist->table.slots);
+  nv_alloc_free(idlist->alloc, idlist->index_to_id);
+  nv_alloc_free(idlist->alloc, idlist->data);
 
   nv_memset(idlist, 0, sizeof(*idlist));
 }
 
+/* Move the element arrays to 'new_capacity', false if that failed (the list is still valid, at the smaller of the two capacities). */
+static bool
+resize_storage(size_t new_capacity, nv_id_list_t* idlist)
+{
+  // the capacity may never be larger than any of the arrays. A shrink lowers it before the first realloc and a grow
+  // raises it after the last one, so a failure in between only leaves some arrays oversized.
+  if (new_capacity < idlist->capacity) { idlist->capacity = new_capacity; }
+
+  void* new_data = nv_alloc_realloc(idlist->alloc, idlist->data, new_capacity * idlist->type_size);
+  if (NV_UNLIKELY(!new_data)) { return false; }
+  idlist->data = new_data;
+
+  size_t* new_index_to_id = (size_t*)nv_alloc_realloc(idlist->alloc, idlist->index_to_id, new_capacity * sizeof(size_t));
+  if (NV_UNLIKELY(!new_index_to_id)) { return false; }
+  idlist->index_to_id = new_index_to_id;
+
+  idlist->capacity = new_capacity;
+  return true;
+}
+
+static bool
+grow_for(size_t count, nv_id_list_t* idlist)
+{
+  const size_t required = idlist->size + count;
+  if (required <= idlist->capacity) { return true; }
+  return resize_storage(grown_capacity(idlist->capacity, required), idlist);
+}
+
+static void
+maybe_shrink(nv_id_list_t* idlist)
+{
+  const size_t new_capacity = shrunk_capacity(idlist->capacity, idlist->size, idlist->reserved);
+  if (new_capacity != idlist->capacity) { resize_storage(new_capacity, idlist); }
+}
+
 void
 nv_id_list_resize(size_t new_capacity, nv_id_list_t* idlist)
 {
   nv_assert_else_return(idlist && idlist->canary == 0xFEF6324, );
+  nv_assert_else_return(new_capacity >= idlist->size, );
 
-  size_t old_size = idlist->capacity * (idlist->type_size + sizeof(size_t));
-  size_t new_size = new_capacity * (idlist->type_size + sizeof(size_t));
+  resize_storage(NV_MAX(new_capacity, (size_t)1), idlist);
+}
 
-  void*   new_data        = nv_realloc(idlist->data, new_capacity * idlist->type_size);
-  size_t* new_id_to_index = (size_t*)nv_realloc(idlist->id_to_index, new_capacity * sizeof(size_t));
-  size_t* new_index_to_id = (size_t*)nv_realloc(idlist->index_to_id, new_capacity * sizeof(size_t));
+nv_error
+nv_id_list_reserve(size_t capacity, nv_id_list_t* idlist)
+{
+  nv_assert_else_return(idlist && idlist->canary == 0xFEF6324, NV_ERROR_INVALID_ARG);
+  nv_assert_else_return(capacity < MAX_SLOTS, NV_ERROR_INVALID_ARG);
 
-  if (NV_UNLIKELY(!new_data || !new_id_to_index || !new_index_to_id)) { return; }
+  if (capacity > idlist->capacity && !resize_storage(capacity, idlist)) { return NV_ERROR_MALLOC_FAILED; }
+  if (!table_reserve(&idlist->table, capacity, idlist->alloc)) { return NV_ERROR_MALLOC_FAILED; }
 
-  idlist->capacity    = new_capacity;
-  idlist->id_to_index = new_id_to_index;
-  idlist->index_to_id = new_index_to_id;
-  idlist->data        = new_data;
+  idlist->reserved = capacity;
+  return NV_SUCCESS;
+}
+
+void
+nv_id_list_shrink_to_fit(nv_id_list_t* idlist)
+{
+  nv_assert_else_return(idlist && idlist->canary == 0xFEF6324, );
+
+  idlist->reserved = 0;
+  if (idlist->capacity > idlist->size) { resize_storage(NV_MAX(idlist->size, (size_t)1), idlist); }
 }
 
 void*
@@ -82,40 +278,78 @@ void*
 nv_id_list_get(size_t id, const nv_id_list_t* idlist)
 {
   nv_assert_else_return(idlist && idlist->canary == 0xFEF6324, NULL);
-  if (id >= idlist->size) return NULL;
 
-  size_t idx  = idlist->id_to_index[id];
-  void*  elem = ((uchar*)idlist->data + (idx * idlist->type_size));
+  size_t idx = table_lookup(&idlist->table, idlist->index_to_id, idlist->size, id);
+  if (idx == SIZE_MAX) return NULL;
+
+  void* elem = ((uchar*)idlist->data + (idx * idlist->type_size));
   return elem;
 }
 
+bool
+nv_id_list_contains(size_t id, const nv_id_list_t* idlist)
+{
+  nv_assert_else_return(idlist && idlist->canary == 0xFEF6324, false);
+  return table_lookup(&idlist->table, idlist->index_to_id, idlist->size, id) != SIZE_MAX;
+}
+
 size_t
-nv_id_list_push(const void* elem, nv_id_list_t* idlist)
+nv_id_list_id_at(size_t index, const nv_id_list_t* idlist)
 {
-  nv_assert_else_return(idlist && idlist->canary == 0xFEF6324, SIZE_MAX);
+  nv_assert_else_return(idlist && idlist->canary == 0xFEF6324, NV_ID_LIST_INVALID_ID);
+  if (index >= idlist->size) return NV_ID_LIST_INVALID_ID;
+  return idlist->index_to_id[index];
+}
 
-  if (idlist->size + 1 >= idlist->capacity || !idlist->data || !idlist->id_to_index) { nv_id_list_resize(NV_MAX(idlist->capacity * 2, 1), idlist); }
+/* Push an element, there must be room for it. */
+static size_t
+push_one(const void* elem, nv_id_list_t* idlist)
+{
+  const size_t id = table_push(&idlist->table, idlist->index_to_id, idlist->size, idlist->alloc);
+  if (NV_UNLIKELY(id == NV_ID_LIST_INVALID_ID)) return NV_ID_LIST_INVALID_ID;
 
-  size_t id       = idlist->size;
   uchar* offseted = (uchar*)idlist->data + (idlist->size * idlist->type_size);
-  nv_memcpy(offseted, elem, idlist->type_size);
-
-  idlist->id_to_index[id]           = idlist->size;
-  idlist->index_to_id[idlist->size] = id;
+  nv_memcpy_small(offseted, elem, idlist->type_size);
   idlist->size++;
 
   return id;
 }
 
+size_t
+nv_id_list_push(const void* elem, nv_id_list_t* idlist)
+{
+  nv_assert_else_return(idlist && idlist->canary == 0xFEF6324, NV_ID_LIST_INVALID_ID);
+
+  if (NV_UNLIKELY(!grow_for(1, idlist))) return NV_ID_LIST_INVALID_ID;
+  return push_one(elem, idlist);
+}
+
+nv_error
+nv_id_list_push_n(const void* elems, size_t count, size_t* ids, nv_id_list_t* idlist)
+{
+  nv_assert_else_return(idlist && idlist->canary == 0xFEF6324, NV_ERROR_INVALID_ARG);
+  nv_assert_else_return(elems != NULL || count == 0, NV_ERROR_INVALID_ARG);
+
+  if (NV_UNLIKELY(!grow_for(count, idlist))) return NV_ERROR_MALLOC_FAILED;
+  if (NV_UNLIKELY(!table_reserve_for(&idlist->table, idlist->size + count, idlist->alloc))) return NV_ERROR_MALLOC_FAILED;
+
+  const uchar* src = (const uchar*)elems;
+  for (size_t i = 0; i < count; i++, src += idlist->type_size)
+  {
+    const size_t id = push_one(src, idlist);
+    if (NV_UNLIKELY(id == NV_ID_LIST_INVALID_ID)) return NV_ERROR_MALLOC_FAILED;
+    if (ids) { ids[i] = id; }
+  }
+  return NV_SUCCESS;
+}
+
 void
 nv_id_list_pop(nv_id_list_t* idlist)
 {
   nv_assert_else_return(idlist && idlist->canary == 0xFEF6324, );
 
-  if (idlist->size - 1 <= idlist->capacity / 2) { nv_id_list_resize(NV_MAX((idlist->capacity + 1) / 2, 1), idlist); }
-
   if (idlist->size == 0) return;
-  idlist->size--;
+  nv_id_list_delete(idlist->index_to_id[idlist->size - 1], idlist);
 }
 
 void
@@ -131,14 +365,13 @@ swap(void* a, void* b, size_t size)
   }
 }
 
-bool
-nv_id_list_delete(size_t id, nv_id_list_t* idlist)
+/* Delete without shrinking, false if the ID is stale. */
+static bool
+delete_one(size_t id, nv_id_list_t* idlist)
 {
-  nv_assert_else_return(idlist && idlist->canary == 0xFEF6324, false);
-
-  if (idlist->size == 0 || id >= idlist->size) return false;
+  size_t i = table_lookup(&idlist->table, idlist->index_to_id, idlist->size, id);
+  if (i == SIZE_MAX) return false;
 
-  size_t i    = idlist->id_to_index[id];
   size_t last = idlist->size - 1;
 
   if (i != last)
@@ -146,19 +379,214 @@ nv_id_list_delete(size_t id, nv_id_list_t* idlist)
     uchar* elem      = (uchar*)idlist->data + (i * idlist->type_size);
     uchar* last_elem = (uchar*)idlist->data + (last * idlist->type_size);
     swap(elem, last_elem, idlist->type_size);
+  }
+  table_remove(&idlist->table, idlist->index_to_id, i, last);
+
+  idlist->size--;
+  return true;
+}
+
+bool
+nv_id_list_delete(size_t id, nv_id_list_t* idlist)
+{
+  nv_assert_else_return(idlist && idlist->canary == 0xFEF6324, false);
+
+  if (!delete_one(id, idlist)) return false;
+  maybe_shrink(idlist);
+  return true;
+}
+
+size_t
+nv_id_list_delete_n(const size_t* ids, size_t count, nv_id_list_t* idlist)
+{
+  nv_assert_else_return(idlist && idlist->canary == 0xFEF6324, 0);
+  nv_assert_else_return(ids != NULL || count == 0, 0);
+
+  size_t deleted = 0;
+  for (size_t i = 0; i < count; i++) { deleted += delete_one(ids[i], idlist); }
+  maybe_shrink(idlist);
+  return deleted;
+}
+
+/*
+ * nv_id_columns_t
+ */
+
+#define COLUMNS_VALID(cols) ((cols) && (cols)->canary == 0xFEF6324)
 
-    size_t moved_id               = idlist->index_to_id[last];
-    idlist->id_to_index[moved_id] = i;
-    idlist->index_to_id[i]        = moved_id;
+nv_error
+nv_id_columns_init(const size_t* column_sizes, size_t column_count, size_t init_capacity, nv_allocator_t* allocator, nv_id_columns_t* cols)
+{
+  nv_assert_else_return(cols != NULL && column_sizes != NULL && column_count > 0, NV_ERROR_INVALID_ARG);
+  nv_bzero(cols, sizeof(*cols));
+
+  if (init_capacity == 0) { init_capacity = 2; }
+  if (!allocator) { allocator = nv_alloc_current; }
+
+  cols->alloc        = allocator;
+  cols->column_count = column_count;
+  cols->capacity     = init_capacity;
+  cols->column_sizes = (size_t*)nv_alloc_memdup(allocator, column_sizes, column_count * sizeof(size_t));
+  cols->columns      = (void**)nv_alloc_zmalloc(allocator, column_count * sizeof(void*));
+  cols->index_to_id  = (size_t*)nv_alloc_zmalloc(allocator, init_capacity * sizeof(size_t));
+
+  bool ok = cols->column_sizes && cols->columns && cols->index_to_id && table_init(&cols->table, init_capacity, allocator) == NV_SUCCESS;
+  for (size_t c = 0; ok && c < column_count; c++)
+  {
+    cols->columns[c] = nv_alloc_zmalloc(allocator, init_capacity * column_sizes[c]);
+    ok               = cols->columns[c] != NULL;
   }
 
-  idlist->id_to_index[id]   = SIZE_MAX;
-  idlist->index_to_id[last] = SIZE_MAX;
+  cols->canary = 0xFEF6324;
+  if (!ok)
+  {
+    nv_id_columns_destroy(cols);
+    return NV_ERROR_MALLOC_FAILED;
+  }
+  return NV_SUCCESS;
+}
 
-  idlist->size--;
+void
+nv_id_columns_destroy(nv_id_columns_t* cols)
+{
+  if (!COLUMNS_VALID(cols)) return;
+
+  nv_allocator_t* alloc = cols->alloc;
+  for (size_t c = 0; cols->columns && c < cols->column_count; c++) { nv_alloc_free(alloc, cols->columns[c]); }
+  nv_alloc_free(alloc, cols->columns);
+  nv_alloc_free(alloc, cols->column_sizes);
+  nv_alloc_free(alloc, cols->index_to_id);
+  nv_alloc_free(alloc, cols->table.slots);
+
+  nv_memset(cols, 0, sizeof(*cols));
+}
+
+static bool
+columns_resize(size_t new_capacity, nv_id_columns_t* cols)
+{
+  // same as resize_storage(), the capacity is lowered before a shrink and raised after a grow.
+  if (new_capacity < cols->capacity) { cols->capacity = new_capacity; }
+
+  for (size_t c = 0; c < cols->column_count; c++)
+  {
+    void* column = nv_alloc_realloc(cols->alloc, cols->columns[c], new_capacity * cols->column_sizes[c]);
+    if (NV_UNLIKELY(!column)) { return false; }
+    cols->columns[c] = column;
+  }
+
+  size_t* new_index_to_id = (size_t*)nv_alloc_realloc(cols->alloc, cols->index_to_id, new_capacity * sizeof(size_t));
+  if (NV_UNLIKELY(!new_index_to_id)) { return false; }
+  cols->index_to_id = new_index_to_id;
+
+  cols->capacity = new_capacity;
+  return true;
+}
+
+nv_error
+nv_id_columns_reserve(size_t capacity, nv_id_columns_t* cols)
+{
+  nv_assert_else_return(COLUMNS_VALID(cols), NV_ERROR_INVALID_ARG);
+  nv_assert_else_return(capacity < MAX_SLOTS, NV_ERROR_INVALID_ARG);
+
+  if (capacity > cols->capacity && !columns_resize(capacity, cols)) { return NV_ERROR_MALLOC_FAILED; }
+  if (!table_reserve(&cols->table, capacity, cols->alloc)) { return NV_ERROR_MALLOC_FAILED; }
+
+  cols->reserved = capacity;
+  return NV_SUCCESS;
+}
+
+void
+nv_id_columns_shrink_to_fit(nv_id_columns_t* cols)
+{
+  nv_assert_else_return(COLUMNS_VALID(cols), );
+
+  cols->reserved = 0;
+  if (cols->capacity > cols->size) { columns_resize(NV_MAX(cols->size, (size_t)1), cols); }
+}
+
+size_t
+nv_id_columns_push(const void* const* components, nv_id_columns_t* cols)
+{
+  nv_assert_else_return(COLUMNS_VALID(cols), NV_ID_LIST_INVALID_ID);
+
+  if (cols->size == cols->capacity && !columns_resize(grown_capacity(cols->capacity, cols->size + 1), cols)) return NV_ID_LIST_INVALID_ID;
+
+  const size_t id = table_push(&cols->table, cols->index_to_id, cols->size, cols->alloc);
+  if (NV_UNLIKELY(id == NV_ID_LIST_INVALID_ID)) return NV_ID_LIST_INVALID_ID;
+
+  for (size_t c = 0; c < cols->column_count; c++)
+  {
+    const size_t ts  = cols->column_sizes[c];
+    uchar*       dst = (uchar*)cols->columns[c] + (cols->size * ts);
+    if (components && components[c]) { nv_memcpy_small(dst, components[c], ts); }
+    else { nv_memset(dst, 0, ts); }
+  }
+  cols->size++;
+
+  return id;
+}
+
+bool
+nv_id_columns_delete(size_t id, nv_id_columns_t* cols)
+{
+  nv_assert_else_return(COLUMNS_VALID(cols), false);
 
-  // shrink if too big
-  if (idlist->size <= idlist->capacity / 2) { nv_id_list_resize(NV_MAX((idlist->capacity + 1) / 2, 1), idlist); }
+  const size_t i = table_lookup(&cols->table, cols->index_to_id, cols->size, id);
+  if (i == SIZE_MAX) return false;
 
+  const size_t last = cols->size - 1;
+  if (i != last)
+  {
+    for (size_t c = 0; c < cols->column_count; c++)
+    {
+      const size_t ts     = cols->column_sizes[c];
+      uchar*       column = (uchar*)cols->columns[c];
+      nv_memcpy_small(column + (i * ts), column + (last * ts), ts);
+    }
+  }
+  table_remove(&cols->table, cols->index_to_id, i, last);
+  cols->size--;
+
+  const size_t new_capacity = shrunk_capacity(cols->capacity, cols->size, cols->reserved);
+  if (new_capacity != cols->capacity) { columns_resize(new_capacity, cols); }
   return true;
 }
+
+void*
+nv_id_columns_get(size_t id, size_t column, const nv_id_columns_t* cols)
+{
+  nv_assert_else_return(COLUMNS_VALID(cols) && column < cols->column_count, NULL);
+
+  const size_t i = table_lookup(&cols->table, cols->index_to_id, cols->size, id);
+  if (i == SIZE_MAX) return NULL;
+  return (uchar*)cols->columns[column] + (i * cols->column_sizes[column]);
+}
+
+bool
+nv_id_columns_contains(size_t id, const nv_id_columns_t* cols)
+{
+  nv_assert_else_return(COLUMNS_VALID(cols), false);
+  return table_lookup(&cols->table, cols->index_to_id, cols->size, id) != SIZE_MAX;
+}
+
+void*
+nv_id_columns_column(size_t column, const nv_id_columns_t* cols)
+{
+  nv_assert_else_return(COLUMNS_VALID(cols) && column < cols->column_count, NULL);
+  return cols->columns[column];
+}
+
+size_t
+nv_id_columns_size(const nv_id_columns_t* cols)
+{
+  nv_assert_else_return(COLUMNS_VALID(cols), 0);
+  return cols->size;
+}
+
+size_t
+nv_id_columns_id_at(size_t index, const nv_id_columns_t* cols)
+{
+  nv_assert_else_return(COLUMNS_VALID(cols), NV_ID_LIST_INVALID_ID);
+  if (index >= cols->size) return NV_ID_LIST_INVALID_ID;
+  return cols->index_to_id[index];
+}
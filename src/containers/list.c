@@ -1,4 +1,10 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+/* mremap() */
+#  define _GNU_SOURCE
+#endif
+
 #include "../../include/containers/list.h"
+#include "../../include/containers/sort.h"
 
 #include "../../include/alloc.h"
 #include "../../include/error.h"
@@ -15,8 +21,215 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if !defined(_WIN32)
+#  include <errno.h>
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#else
+#  include <windows.h>
+#endif
+
+static inline size_t
+round_up(size_t value, size_t granule)
+{
+  return (value + granule - 1) & ~(granule - 1);
+}
+
+static size_t
+page_size(void)
+{
+  static size_t cached = 0;
+  if (NV_UNLIKELY(cached == 0))
+  {
+#if !defined(_WIN32)
+    long sz = sysconf(_SC_PAGESIZE);
+    cached  = sz > 0 ? (size_t)sz : 4096;
+#else
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    cached = info.dwPageSize;
+#endif
+  }
+  return cached;
+}
+
+/**
+ * Reserve 'size' bytes of address space without committing any memory to it.
+ */
+static void*
+vm_reserve(size_t size)
+{
+#if !defined(_WIN32)
+  int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#  ifdef MAP_NORESERVE
+  flags |= MAP_NORESERVE;
+#  endif
+  void* p = mmap(NULL, size, PROT_NONE, flags, -1, 0);
+  return p == MAP_FAILED ? NULL : p;
+#else
+  return VirtualAlloc(NULL, size, MEM_RESERVE, PAGE_NOACCESS);
+#endif
+}
+
+/**
+ * Make [offset, offset + size) of a reservation readable and writable. The pages are zero filled on first touch.
+ */
+static bool
+vm_commit(void* base, size_t offset, size_t size)
+{
+#if !defined(_WIN32)
+  return mprotect((uchar*)base + offset, size, PROT_READ | PROT_WRITE) == 0;
+#else
+  return VirtualAlloc((uchar*)base + offset, size, MEM_COMMIT, PAGE_READWRITE) != NULL;
+#endif
+}
+
+static void
+vm_release(void* base, size_t size)
+{
+#if !defined(_WIN32)
+  munmap(base, size);
+#else
+  (void)size;
+  VirtualFree(base, 0, MEM_RELEASE);
+#endif
+}
+
+/**
+ * File backed lists start with this header, the elements start at LIST_FILE_HEADER_SIZE so that they stay cache line aligned.
+ */
+#define LIST_FILE_MAGIC 0x464C564EU // "NVLF"
+#define LIST_FILE_VERSION 1
+#define LIST_FILE_HEADER_SIZE 64
+
+typedef struct list_file_header
+{
+  u32 magic;
+  u32 version;
+  u64 type_size;
+  u64 size; // as of the last nv_list_sync() or nv_list_destroy()
+} list_file_header;
+
+NV_STATIC_ASSERT(sizeof(list_file_header) <= LIST_FILE_HEADER_SIZE, list_file_header_must_fit);
+
+static inline list_file_header*
+file_header(const nv_list_t* list)
+{
+  return (list_file_header*)(void*)((uchar*)list->data - LIST_FILE_HEADER_SIZE);
+}
+
+/**
+ * Give the list's storage back to wherever it came from.
+ */
+static void
+release_data(nv_list_t* list)
+{
+  if (!list->data) { return; }
+
+  switch (list->storage)
+  {
+    case NV_LIST_STORAGE_ALLOCATOR: nv_alloc_free(list->alloc, list->data); break;
+    case NV_LIST_STORAGE_RESERVED: vm_release(list->data, list->mapped); break;
+    case NV_LIST_STORAGE_FILE:
+#if !defined(_WIN32)
+      file_header(list)->size = list->size;
+      munmap(file_header(list), list->mapped);
+      close(list->fd);
+#endif
+      break;
+  }
+
+  list->data     = NULL;
+  list->capacity = 0;
+  list->storage  = NV_LIST_STORAGE_ALLOCATOR;
+  list->mapped   = 0;
+}
+
+/**
+ * Reserved lists only commit the pages they need, the data pointer never moves.
+ */
+static void
+reserved_reserve(nv_list_t* list, size_t new_capacity)
+{
+  const size_t max_capacity = list->mapped / list->type_size;
+
+  // reserved lists never shrink, and growing by doubling clamps to the end of the reservation.
+  new_capacity = NV_MIN(new_capacity, max_capacity);
+  if (new_capacity <= list->capacity) { return; }
+
+  const size_t page      = page_size();
+  const size_t committed = round_up(list->capacity * list->type_size, page);
+  const size_t commit    = NV_MIN(round_up(round_up(new_capacity * list->type_size, NV_LIST_COMMIT_GRANULE), page), list->mapped);
+
+  if (!vm_commit(list->data, committed, commit - committed))
+  {
+    nv_log_error("failed to commit %zu bytes of a reserved list\n", commit - committed);
+    return;
+  }
+
+  // every committed byte is usable
+  list->capacity = commit / list->type_size;
+}
+
+/**
+ * File backed lists grow the file and then the mapping, which mremap() can usually do without moving it.
+ * The data pointer may still move, like it would for a realloc().
+ */
+static void
+file_reserve(nv_list_t* list, size_t new_capacity)
+{
+  if (new_capacity <= list->capacity) { return; }
+
+#if !defined(_WIN32)
+  const size_t new_mapped = round_up(LIST_FILE_HEADER_SIZE + round_up(new_capacity * list->type_size, NV_LIST_COMMIT_GRANULE), page_size());
+  void*        base       = file_header(list);
+
+  if (ftruncate(list->fd, (off_t)new_mapped) != 0)
+  {
+    nv_log_error("failed to grow a file backed list to %zu bytes\n", new_mapped);
+    return;
+  }
+
+#  if defined(__linux__)
+  void* new_base = mremap(base, list->mapped, new_mapped, MREMAP_MAYMOVE);
+#  else
+  // map the bigger file before dropping the old mapping, so that a failure leaves the list as it was.
+  void* new_base = mmap(NULL, new_mapped, PROT_READ | PROT_WRITE, MAP_SHARED, list->fd, 0);
+  if (new_base != MAP_FAILED) { munmap(base, list->mapped); }
+#  endif
+  if (new_base == MAP_FAILED)
+  {
+    nv_log_error("failed to map %zu bytes of a file backed list\n", new_mapped);
+    return;
+  }
+
+  list->data     = (uchar*)new_base + LIST_FILE_HEADER_SIZE;
+  list->mapped   = new_mapped;
+  list->capacity = (new_mapped - LIST_FILE_HEADER_SIZE) / list->type_size;
+#endif
+}
+
+/**
+ * Grow the list so that it holds atleast 'required' elements, asking for 'requested'.
+ * Reserved lists can not grow past their reservation, running out of it is fatal.
+ */
+static inline void
+grow_to(nv_list_t* list, size_t required, size_t requested)
+{
+  nv_list_reserve(list, requested);
+  nv_assert(list->capacity >= required);
+}
+
 nv_error
 nv_list_init(size_t type_size, size_t init_capacity, nv_list_t* list)
+{
+  return nv_list_init_with_allocator(type_size, init_capacity, NULL, list);
+}
+
+nv_error
+nv_list_init_with_allocator(size_t type_size, size_t init_capacity, nv_allocator_t* allocator, nv_list_t* list)
 {
   nv_assert_else_return(type_size > 0, NV_ERROR_INVALID_ARG);
 
@@ -25,10 +238,11 @@ nv_list_init(size_t type_size, size_t init_capacity, nv_list_t* list)
   list->size      = 0;
   list->type_size = type_size;
   list->canary    = NOVA_CONT_CANARY;
+  list->alloc     = allocator ? allocator : nv_alloc_current;
 
   if (init_capacity > 0)
   {
-    list->data     = nv_zmalloc(type_size * init_capacity);
+    list->data     = nv_alloc_zmalloc(list->alloc, type_size * init_capacity);
     list->capacity = init_capacity;
   }
   else
@@ -39,13 +253,129 @@ nv_list_init(size_t type_size, size_t init_capacity, nv_list_t* list)
   return NV_ERROR_SUCCESS;
 }
 
+nv_error
+nv_list_init_reserved(size_t type_size, size_t max_capacity, nv_list_t* list)
+{
+  nv_assert_else_return(type_size > 0, NV_ERROR_INVALID_ARG);
+  nv_assert_else_return(max_capacity > 0 && max_capacity <= SIZE_MAX / type_size, NV_ERROR_INVALID_ARG);
+
+  *list = nv_zinit(nv_list_t);
+
+  const size_t reserved = round_up(max_capacity * type_size, page_size());
+  void*        base     = vm_reserve(reserved);
+  if (!base) { return NV_ERROR_MALLOC_FAILED; }
+
+  list->type_size = type_size;
+  list->canary    = NOVA_CONT_CANARY;
+  list->alloc     = nv_alloc_current;
+  list->data      = base;
+  list->storage   = NV_LIST_STORAGE_RESERVED;
+  list->mapped    = reserved;
+
+  return NV_ERROR_SUCCESS;
+}
+
+nv_error
+nv_list_open_file(const char* path, size_t type_size, nv_list_t* list)
+{
+  nv_assert_else_return(path != NULL, NV_ERROR_INVALID_ARG);
+  nv_assert_else_return(type_size > 0, NV_ERROR_INVALID_ARG);
+
+  *list = nv_zinit(nv_list_t);
+
+#if !defined(_WIN32)
+  int fd = open(path, O_RDWR | O_CREAT, 0644);
+  if (fd < 0)
+  {
+    if (errno == ENOENT) { return NV_ERROR_NO_EXIST; }
+    if (errno == EACCES || errno == EPERM) { return NV_ERROR_INSUFFICIENT_PERMISSIONS; }
+    return NV_ERROR_IO_ERROR;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0)
+  {
+    close(fd);
+    return NV_ERROR_IO_ERROR;
+  }
+
+  size_t     file_size = (size_t)st.st_size;
+  const bool fresh     = file_size == 0;
+  if (fresh)
+  {
+    file_size = round_up(LIST_FILE_HEADER_SIZE, page_size());
+    if (ftruncate(fd, (off_t)file_size) != 0)
+    {
+      close(fd);
+      return NV_ERROR_IO_ERROR;
+    }
+  }
+  else if (file_size < LIST_FILE_HEADER_SIZE)
+  {
+    close(fd);
+    return NV_ERROR_INVALID_INPUT;
+  }
+
+  void* base = mmap(NULL, file_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (base == MAP_FAILED)
+  {
+    close(fd);
+    return NV_ERROR_IO_ERROR;
+  }
+
+  list_file_header* header   = (list_file_header*)base;
+  const size_t      capacity = (file_size - LIST_FILE_HEADER_SIZE) / type_size;
+  if (fresh)
+  {
+    header->magic     = LIST_FILE_MAGIC;
+    header->version   = LIST_FILE_VERSION;
+    header->type_size = type_size;
+    header->size      = 0;
+  }
+  else if (header->magic != LIST_FILE_MAGIC || header->version != LIST_FILE_VERSION || header->type_size != type_size || header->size > capacity)
+  {
+    munmap(base, file_size);
+    close(fd);
+    return NV_ERROR_INVALID_INPUT;
+  }
+
+  list->type_size = type_size;
+  list->canary    = NOVA_CONT_CANARY;
+  list->alloc     = nv_alloc_current;
+  list->data      = (uchar*)base + LIST_FILE_HEADER_SIZE;
+  list->size      = header->size;
+  list->capacity  = capacity;
+  list->storage   = NV_LIST_STORAGE_FILE;
+  list->mapped    = file_size;
+  list->fd        = fd;
+
+  return NV_ERROR_SUCCESS;
+#else
+  return NV_ERROR_INVALID_OPERATION;
+#endif
+}
+
+nv_error
+nv_list_sync(nv_list_t* list)
+{
+  nv_assert_else_return(NOVA_CONT_IS_VALID(list), NV_ERROR_INVALID_ARG);
+  if (list->storage != NV_LIST_STORAGE_FILE) { return NV_ERROR_SUCCESS; }
+
+#if !defined(_WIN32)
+  file_header(list)->size = list->size;
+  if (msync(file_header(list), LIST_FILE_HEADER_SIZE + (list->size * list->type_size), MS_SYNC) != 0) { return NV_ERROR_IO_ERROR; }
+#endif
+
+  return NV_ERROR_SUCCESS;
+}
+
 void
 nv_list_destroy(nv_list_t* list)
 {
   if (list)
   {
     nv_assert(NOVA_CONT_IS_VALID(list));
-    if (list->data) { nv_free(list->data); }
+    release_data(list);
   }
 }
 
@@ -55,7 +385,7 @@ nv_list_duplicate_data(const nv_list_t* list)
   nv_assert(NOVA_CONT_IS_VALID(list));
 
   size_t byte_size = list->size * list->type_size;
-  void*  dup       = nv_zmalloc(byte_size);
+  void*  dup       = nv_alloc_zmalloc(list->alloc, byte_size);
   nv_memcpy(dup, list->data, byte_size);
 
   return dup;
@@ -151,7 +481,7 @@ nv_list_copy_from(const nv_list_t* NV_RESTRICT src, nv_list_t* NV_RESTRICT dst)
   nv_assert(NOVA_CONT_IS_VALID(dst));
 
   nv_assert(src->type_size == dst->type_size);
-  if (src->size >= dst->capacity) { nv_list_reserve(dst, src->size); }
+  if (src->size >= dst->capacity) { grow_to(dst, src->size, src->size); }
   dst->size = src->size;
   nv_memcpy(dst->data, src->data, src->size * src->type_size);
 }
@@ -164,16 +494,26 @@ nv_list_move_from(nv_list_t* NV_RESTRICT src, nv_list_t* NV_RESTRICT dst)
 
   size_t src_capacity = src->capacity;
 
+  release_data(dst);
+
   dst->size     = src->size;
   dst->capacity = src->capacity;
   dst->data     = src->data;
+  dst->alloc    = src->alloc;
+  dst->storage  = src->storage;
+  dst->mapped   = src->mapped;
+  dst->fd       = src->fd;
+
+  // a reservation or file moves to dst along with the data, src goes back to the allocator.
+  src->storage  = NV_LIST_STORAGE_ALLOCATOR;
+  src->mapped   = 0;
 
   // clear the list
   src->size     = 0;
   src->capacity = src_capacity;
 
   // realloc src->data as it's owned by dst now.
-  src->data = nv_zmalloc(src_capacity * src->type_size);
+  src->data = src_capacity ? nv_alloc_zmalloc(src->alloc, src_capacity * src->type_size) : NULL;
   // we don't need to copy the data over, this is move()
 }
 
@@ -206,7 +546,7 @@ nv_list_resize(nv_list_t* list, size_t new_size)
     nv_list_clear(list);
     return;
   }
-  else if (new_size > list->capacity) { nv_list_reserve(list, NV_MAX(new_size, list->capacity * 2)); }
+  else if (new_size > list->capacity) { grow_to(list, new_size, NV_MAX(new_size, list->capacity * 2)); }
 
   list->size = new_size;
 }
@@ -221,10 +561,21 @@ nv_list_reserve(nv_list_t* list, size_t new_capacity)
     return;
   }
 
-  if (list->data) { list->data = nv_realloc(list->data, list->type_size * new_capacity); }
+  if (list->storage == NV_LIST_STORAGE_RESERVED)
+  {
+    reserved_reserve(list, new_capacity);
+    return;
+  }
+  if (list->storage == NV_LIST_STORAGE_FILE)
+  {
+    file_reserve(list, new_capacity);
+    return;
+  }
+
+  if (list->data) { list->data = nv_alloc_realloc(list->alloc, list->data, list->type_size * new_capacity); }
   else
   {
-    list->data = nv_zmalloc(list->type_size * new_capacity);
+    list->data = nv_alloc_zmalloc(list->alloc, list->type_size * new_capacity);
   }
   nv_assert(list->data != NULL);
 
@@ -236,7 +587,7 @@ nv_list_push_back(nv_list_t* NV_RESTRICT list, const void* NV_RESTRICT elem)
 {
   nv_assert_else_return(NOVA_CONT_IS_VALID(list), );
 
-  if (list->size + 1 >= list->capacity) { nv_list_reserve(list, NV_MAX(1, list->capacity * 2)); }
+  if (list->size + 1 >= list->capacity) { grow_to(list, list->size + 1, NV_MAX((size_t)1, list->capacity * 2)); }
 
   nv_assert(list->data != NULL);
   nv_assert(!(elem >= list->data && (unsigned char*)elem <= ((unsigned char*)list->data + list->size))); // breaks restriction rules
@@ -249,7 +600,7 @@ nv_list_push_empty(nv_list_t* __restrict list)
 {
   nv_assert(NOVA_CONT_IS_VALID(list));
 
-  if (list->size >= list->capacity) { nv_list_reserve(list, NV_MAX(1, list->capacity * 2)); }
+  if (list->size >= list->capacity) { grow_to(list, list->size + 1, NV_MAX((size_t)1, list->capacity * 2)); }
 
   nv_assert(list->data != NULL);
   void* p = (uchar*)list->data + (list->size * list->type_size);
@@ -265,7 +616,7 @@ nv_list_push_set(nv_list_t* NV_RESTRICT list, const void* NV_RESTRICT arr, size_
   nv_assert_else_return(NOVA_CONT_IS_VALID(list), );
 
   size_t required_capacity = list->size + count;
-  if (required_capacity >= list->capacity) { nv_list_reserve(list, required_capacity); }
+  if (required_capacity >= list->capacity) { grow_to(list, required_capacity, required_capacity); }
   nv_memcpy((uchar*)list->data + (list->size * list->type_size), arr, count * list->type_size);
   list->size += count;
 }
@@ -286,73 +637,128 @@ nv_list_pop_front(nv_list_t* list)
   if (list->size > 0)
   {
     list->size--;
-    nv_memcpy(list->data, (uchar*)list->data + list->type_size, list->size * list->type_size);
+    nv_memmove(list->data, (uchar*)list->data + list->type_size, list->size * list->type_size);
   }
 }
 
 void
 nv_list_insert(nv_list_t* NV_RESTRICT list, size_t index, const void* NV_RESTRICT elem)
 {
-  nv_assert(NOVA_CONT_IS_VALID(list));
+  nv_list_insert_range(list, index, elem, 1);
+}
 
-  // ensure capacity is enough for index
-  if (index >= list->capacity)
-  {
-    size_t new_capacity = index + 1;
-    nv_list_reserve(list, new_capacity);
-  }
+/**
+ * Open a gap of 'count' elements at 'index', shifting everything after it back.
+ * An index past the end grows the list, the elements in between are zeroed.
+ * Returns a pointer to the gap.
+ */
+static uchar*
+open_gap(nv_list_t* list, size_t index, size_t count)
+{
+  const size_t ts       = list->type_size;
+  const size_t old_size = list->size;
+  const size_t new_size = NV_MAX(old_size, index) + count;
+
+  if (new_size > list->capacity) { grow_to(list, new_size, NV_MAX(new_size, list->capacity * 2)); }
+
+  uchar* data = (uchar*)list->data;
+  if (index < old_size) { nv_memmove(data + ((index + count) * ts), data + (index * ts), (old_size - index) * ts); }
+  else if (index > old_size) { nv_memset(data + (old_size * ts), 0, (index - old_size) * ts); }
+
+  list->size = new_size;
+  return data + (index * ts);
+}
+
+void
+nv_list_insert_range(nv_list_t* NV_RESTRICT list, size_t index, const void* NV_RESTRICT elems, size_t count)
+{
+  nv_assert_else_return(NOVA_CONT_IS_VALID(list), );
+  nv_assert_else_return(elems != NULL || count == 0, );
+
+  if (count == 0) { return; }
+
+  uchar* gap = open_gap(list, index, count);
+  nv_memcpy(gap, elems, count * list->type_size);
+}
+
+void
+nv_list_erase_range(nv_list_t* list, size_t first, size_t count)
+{
+  nv_assert_else_return(NOVA_CONT_IS_VALID(list), );
+
+  if (first >= list->size || count == 0) { return; }
+
+  count             = NV_MIN(count, list->size - first);
+  const size_t ts   = list->type_size;
+  const size_t tail = list->size - first - count;
+  uchar*       data = (uchar*)list->data;
 
-  if (index >= list->size) { list->size = index + 1; }
+  if (tail > 0) { nv_memmove(data + (first * ts), data + ((first + count) * ts), tail * ts); }
 
-  // copy element
-  nv_memcpy((uchar*)list->data + (list->type_size * index), elem, list->type_size);
+  list->size -= count;
 }
 
 void
 nv_list_remove(nv_list_t* list, size_t index)
 {
-  nv_assert(NOVA_CONT_IS_VALID(list));
+  nv_list_erase_range(list, index, 1);
+}
+
+void
+nv_list_swap_remove(nv_list_t* list, size_t index)
+{
+  nv_assert_else_return(NOVA_CONT_IS_VALID(list), );
 
   if (index >= list->size) { return; }
 
-  size_t elements_to_move = list->size - index - 1;
-  if (elements_to_move > 0)
-  {
-    uchar* dest          = (uchar*)list->data + (index * list->type_size);
-    uchar* src           = (uchar*)list->data + ((index + 1) * list->type_size);
-    size_t bytes_to_move = elements_to_move * list->type_size;
+  const size_t ts   = list->type_size;
+  const size_t last = list->size - 1;
+  uchar*       data = (uchar*)list->data;
 
-    nv_memcpy(dest, src, bytes_to_move);
-  }
+  if (index != last) { nv_memcpy_small(data + (index * ts), data + (last * ts), ts); }
 
   list->size--;
 }
 
-size_t
-nv_list_find(const nv_list_t* NV_RESTRICT list, const void* NV_RESTRICT elem)
+/* Move 'count' kept elements from 'first' down to 'write', returns where the next run goes. */
+static inline size_t
+move_kept_run(uchar* data, size_t ts, size_t write, size_t first, size_t count)
 {
-  nv_assert(NOVA_CONT_IS_VALID(list));
+  if (count > 0 && write != first) { nv_memmove(data + (write * ts), data + (first * ts), count * ts); }
+  return write + count;
+}
 
-  if (list->size == 0) { return SIZE_MAX; }
-  if (list->size == 1)
+size_t
+nv_list_remove_if(nv_list_t* list, nv_list_predicate_fn predicate, void* user_data)
+{
+  nv_assert_else_return(NOVA_CONT_IS_VALID(list), 0);
+  nv_assert_else_return(predicate != NULL, 0);
+
+  const size_t ts   = list->type_size;
+  const size_t size = list->size;
+  uchar*       data = (uchar*)list->data;
+
+  // each element is tested once. Kept elements are collected into runs, which are moved down in one go when a
+  // removed element (or the end) closes them.
+  size_t write     = 0;
+  size_t run_start = 0;
+  for (size_t read = 0; read < size; read++)
   {
-    if (nv_memcmp(list->data, elem, list->type_size) == 0) { return 0; }
+    if (!predicate(data + (read * ts), user_data)) { continue; }
 
-    return SIZE_MAX;
+    write     = move_kept_run(data, ts, write, run_start, read - run_start);
+    run_start = read + 1;
   }
+  write = move_kept_run(data, ts, write, run_start, size - run_start);
 
-  /* start two probes, one from the front and one from behind */
-  for (size_t i = 0; i < list->size; i++)
-  {
-    const size_t fwd_index = i;
-    const size_t bck_index = (list->size - 1) - i;
-
-    const void* fwd = (unsigned char*)list->data + (fwd_index * list->type_size);
-    const void* bck = (unsigned char*)list->data + (bck_index * list->type_size);
+  list->size = write;
+  return size - write;
+}
 
-    if (nv_memcmp(fwd, elem, list->type_size) == 0) { return fwd_index; }
-    if (nv_memcmp(bck, elem, list->type_size) == 0) { return bck_index; }
-  }
+void
+nv_list_sort(nv_list_t* list, nv_compare_fn compare, void* user_data)
+{
+  nv_assert_else_return(NOVA_CONT_IS_VALID(list), );
 
-  return (size_t)-1;
+  nv_sort(list->data, list->size, list->type_size, compare, user_data);
 }
@@ -0,0 +1,305 @@
+#include "../../include/containers/list.h"
+
+#include "../../include/cpu.h"
+#include "../../include/error.h"
+#include "../../include/stdafx.h"
+#include "../../include/string.h"
+#include "../../include/types.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if NV_CPU_X86_SIMD
+#  include <immintrin.h>
+#endif
+
+/*
+ * Element search.
+ *
+ * Elements of 1, 2, 4, 8 or 16 bytes are compared a whole vector at a time: the vector is compared byte for byte
+ * against the element repeated to fill a vector, and an element matches when all of its bytes did. Other sizes
+ * compare an integer prefix of every element first and only memcmp the rest when that matches.
+ *
+ * Each implementation has a find (the first match at or after 'start', 'count' if none) and a count.
+ */
+
+typedef size_t (*find_fn)(const uchar* data, size_t count, const uchar* elem, size_t size, size_t start);
+typedef size_t (*count_fn)(const uchar* data, size_t count, const uchar* elem, size_t size);
+
+/*
+ * Scalar
+ */
+
+static inline bool
+elem_equal(const uchar* a, const uchar* b, size_t size)
+{
+  switch (size)
+  {
+    case 1: return *a == *b;
+    case 2:
+    {
+      u16 x, y;
+      nv_memcpy_small(&x, a, 2), nv_memcpy_small(&y, b, 2);
+      return x == y;
+    }
+    case 4:
+    {
+      u32 x, y;
+      nv_memcpy_small(&x, a, 4), nv_memcpy_small(&y, b, 4);
+      return x == y;
+    }
+    case 8:
+    {
+      u64 x, y;
+      nv_memcpy_small(&x, a, 8), nv_memcpy_small(&y, b, 8);
+      return x == y;
+    }
+    case 16:
+    {
+      u64 x[2], y[2];
+      nv_memcpy_small(x, a, 16), nv_memcpy_small(y, b, 16);
+      return ((x[0] ^ y[0]) | (x[1] ^ y[1])) == 0;
+    }
+    default: break;
+  }
+
+  // blocked compare: an 8 (or 4) byte prefix rules out nearly every element before memcmp is needed.
+  if (size >= 8)
+  {
+    u64 x, y;
+    nv_memcpy_small(&x, a, 8), nv_memcpy_small(&y, b, 8);
+    return x == y && nv_memcmp(a + 8, b + 8, size - 8) == 0;
+  }
+  if (size >= 4)
+  {
+    u32 x, y;
+    nv_memcpy_small(&x, a, 4), nv_memcpy_small(&y, b, 4);
+    return x == y && nv_memcmp(a + 4, b + 4, size - 4) == 0;
+  }
+  return nv_memcmp(a, b, size) == 0;
+}
+
+static size_t
+find_scalar(const uchar* data, size_t count, const uchar* elem, size_t size, size_t start)
+{
+  for (size_t i = start; i < count; i++)
+  {
+    if (elem_equal(data + (i * size), elem, size)) { return i; }
+  }
+  return count;
+}
+
+static size_t
+count_scalar(const uchar* data, size_t count, const uchar* elem, size_t size)
+{
+  size_t matches = 0;
+  for (size_t i = 0; i < count; i++) { matches += elem_equal(data + (i * size), elem, size); }
+  return matches;
+}
+
+#if NV_CPU_X86_SIMD
+
+/**
+ * Reduce a byte equality mask to one bit per element, at the element's first byte.
+ */
+static inline u32
+element_mask(u32 bytes, size_t size)
+{
+  if (size >= 2) { bytes &= bytes >> 1U; }
+  if (size >= 4) { bytes &= bytes >> 2U; }
+  if (size >= 8) { bytes &= bytes >> 4U; }
+  if (size >= 16) { bytes &= bytes >> 8U; }
+
+  switch (size)
+  {
+    case 2: return bytes & 0x55555555U;
+    case 4: return bytes & 0x11111111U;
+    case 8: return bytes & 0x01010101U;
+    case 16: return bytes & 0x00010001U;
+    default: return bytes;
+  }
+}
+
+static inline void
+fill_pattern(uchar* pattern, size_t pattern_size, const uchar* elem, size_t size)
+{
+  for (size_t i = 0; i < pattern_size; i += size) { nv_memcpy_small(pattern + i, elem, size); }
+}
+
+NV_CPU_TARGET("sse2") static size_t
+find_sse2(const uchar* data, size_t count, const uchar* elem, size_t size, size_t start)
+{
+  const size_t per_vector = 16 / size;
+
+  uchar pattern[16];
+  fill_pattern(pattern, sizeof(pattern), elem, size);
+  const __m128i needle = _mm_loadu_si128((const __m128i*)pattern);
+
+  size_t i = start;
+  for (; i + per_vector <= count; i += per_vector)
+  {
+    const __m128i v = _mm_loadu_si128((const __m128i*)(data + (i * size)));
+    const u32     m = element_mask((u32)_mm_movemask_epi8(_mm_cmpeq_epi8(v, needle)), size);
+    if (m) { return i + ((size_t)__builtin_ctz(m) / size); }
+  }
+  return find_scalar(data, count, elem, size, i);
+}
+
+NV_CPU_TARGET("sse2") static size_t
+count_sse2(const uchar* data, size_t count, const uchar* elem, size_t size)
+{
+  const size_t per_vector = 16 / size;
+
+  uchar pattern[16];
+  fill_pattern(pattern, sizeof(pattern), elem, size);
+  const __m128i needle = _mm_loadu_si128((const __m128i*)pattern);
+
+  size_t matches = 0;
+  size_t i       = 0;
+  for (; i + per_vector <= count; i += per_vector)
+  {
+    const __m128i v = _mm_loadu_si128((const __m128i*)(data + (i * size)));
+    matches += (size_t)__builtin_popcount(element_mask((u32)_mm_movemask_epi8(_mm_cmpeq_epi8(v, needle)), size));
+  }
+  return matches + count_scalar(data + (i * size), count - i, elem, size);
+}
+
+NV_CPU_TARGET("avx2") static size_t
+find_avx2(const uchar* data, size_t count, const uchar* elem, size_t size, size_t start)
+{
+  const size_t per_vector = 32 / size;
+
+  uchar pattern[32];
+  fill_pattern(pattern, sizeof(pattern), elem, size);
+  const __m256i needle = _mm256_loadu_si256((const __m256i*)pattern);
+
+  size_t i = start;
+
+  // two vectors per iteration, the loop is bound by the loads
+  for (; i + (2 * per_vector) <= count; i += 2 * per_vector)
+  {
+    const __m256i a  = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(data + (i * size))), needle);
+    const __m256i b  = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(data + ((i + per_vector) * size))), needle);
+    const u32     ma = element_mask((u32)_mm256_movemask_epi8(a), size);
+    const u32     mb = element_mask((u32)_mm256_movemask_epi8(b), size);
+    if (ma | mb) { return ma ? i + ((size_t)__builtin_ctz(ma) / size) : i + per_vector + ((size_t)__builtin_ctz(mb) / size); }
+  }
+  for (; i + per_vector <= count; i += per_vector)
+  {
+    const __m256i v = _mm256_loadu_si256((const __m256i*)(data + (i * size)));
+    const u32     m = element_mask((u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, needle)), size);
+    if (m) { return i + ((size_t)__builtin_ctz(m) / size); }
+  }
+  return find_scalar(data, count, elem, size, i);
+}
+
+NV_CPU_TARGET("avx2,popcnt") static size_t
+count_avx2(const uchar* data, size_t count, const uchar* elem, size_t size)
+{
+  const size_t per_vector = 32 / size;
+
+  uchar pattern[32];
+  fill_pattern(pattern, sizeof(pattern), elem, size);
+  const __m256i needle = _mm256_loadu_si256((const __m256i*)pattern);
+
+  size_t matches = 0;
+  size_t i       = 0;
+  for (; i + per_vector <= count; i += per_vector)
+  {
+    const __m256i v = _mm256_loadu_si256((const __m256i*)(data + (i * size)));
+    matches += (size_t)__builtin_popcount(element_mask((u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, needle)), size));
+  }
+  return matches + count_scalar(data + (i * size), count - i, elem, size);
+}
+
+#endif // NV_CPU_X86_SIMD
+
+static inline bool
+vectorizable(size_t size)
+{
+  return size == 1 || size == 2 || size == 4 || size == 8 || size == 16;
+}
+
+static find_fn
+pick_find(size_t size)
+{
+#if NV_CPU_X86_SIMD
+  if (vectorizable(size))
+  {
+    if (nv_cpu_has(NV_CPU_AVX2)) { return find_avx2; }
+    if (nv_cpu_has(NV_CPU_SSE2)) { return find_sse2; }
+  }
+#else
+  (void)size;
+#endif
+  return find_scalar;
+}
+
+static count_fn
+pick_count(size_t size)
+{
+#if NV_CPU_X86_SIMD
+  if (vectorizable(size))
+  {
+    if (nv_cpu_has(NV_CPU_AVX2 | NV_CPU_POPCNT)) { return count_avx2; }
+    if (nv_cpu_has(NV_CPU_SSE2)) { return count_sse2; }
+  }
+#else
+  (void)size;
+#endif
+  return count_scalar;
+}
+
+size_t
+nv_list_find(const nv_list_t* NV_RESTRICT list, const void* NV_RESTRICT elem)
+{
+  nv_assert_else_return(NOVA_CONT_IS_VALID(list), SIZE_MAX);
+  nv_assert_else_return(elem != NULL, SIZE_MAX);
+
+  if (list->size == 0) { return SIZE_MAX; }
+
+  const size_t index = pick_find(list->type_size)((const uchar*)list->data, list->size, (const uchar*)elem, list->type_size, 0);
+  return index < list->size ? index : SIZE_MAX;
+}
+
+size_t
+nv_list_count(const nv_list_t* NV_RESTRICT list, const void* NV_RESTRICT elem)
+{
+  nv_assert_else_return(NOVA_CONT_IS_VALID(list), 0);
+  nv_assert_else_return(elem != NULL, 0);
+
+  if (list->size == 0) { return 0; }
+
+  return pick_count(list->type_size)((const uchar*)list->data, list->size, (const uchar*)elem, list->type_size);
+}
+
+size_t
+nv_list_find_all(const nv_list_t* NV_RESTRICT list, const void* NV_RESTRICT elem, nv_list_t* NV_RESTRICT indices)
+{
+  nv_assert_else_return(NOVA_CONT_IS_VALID(list), 0);
+  nv_assert_else_return(NOVA_CONT_IS_VALID(indices) && indices->type_size == sizeof(size_t), 0);
+  nv_assert_else_return(elem != NULL, 0);
+
+  const find_fn find = pick_find(list->type_size);
+  const uchar*  data = (const uchar*)list->data;
+
+  // batch the indices, pushing them one at a time would cost more than finding them.
+  size_t batch[64];
+  size_t batched = 0;
+  size_t found   = 0;
+
+  for (size_t i = find(data, list->size, (const uchar*)elem, list->type_size, 0); i < list->size; i = find(data, list->size, (const uchar*)elem, list->type_size, i + 1))
+  {
+    batch[batched++] = i;
+    if (batched == nv_arrlen(batch))
+    {
+      nv_list_push_set(indices, batch, batched);
+      found += batched;
+      batched = 0;
+    }
+  }
+  if (batched > 0) { nv_list_push_set(indices, batch, batched); }
+
+  return found + batched;
+}
@@ -0,0 +1,388 @@
+#include "../../include/containers/list_parallel.h"
+
+#include "../../include/alloc.h"
+#include "../../include/containers/list.h"
+#include "../../include/containers/sort.h"
+#include "../../include/error.h"
+#include "../../include/hash.h"
+#include "../../include/stdafx.h"
+#include "../../include/string.h"
+#include "../../include/threadpool.h"
+#include "../../include/types.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+static inline nv_thread_pool_t*
+resolve_pool(nv_thread_pool_t* pool)
+{
+  return pool ? pool : nv_thread_pool_default();
+}
+
+static inline size_t
+chunk_elems(size_t type_size)
+{
+  return NV_MAX((size_t)1, (size_t)NV_LIST_PARALLEL_CHUNK_BYTES / type_size);
+}
+
+static inline size_t
+chunk_count(size_t size, size_t per_chunk)
+{
+  return (size + per_chunk - 1) / per_chunk;
+}
+
+/*
+ * for
+ */
+
+typedef struct for_job
+{
+  uchar*           data;
+  size_t           size;
+  size_t           type_size;
+  size_t           per_chunk;
+  nv_list_chunk_fn fn;
+  void*            user_data;
+} for_job;
+
+static void
+for_task(void* arg, size_t chunk)
+{
+  const for_job* job   = (const for_job*)arg;
+  const size_t   first = chunk * job->per_chunk;
+  const size_t   count = NV_MIN(job->per_chunk, job->size - first);
+  job->fn(job->data + (first * job->type_size), count, first, job->user_data);
+}
+
+void
+nv_list_parallel_for(nv_list_t* list, nv_list_chunk_fn fn, void* user_data, nv_thread_pool_t* pool)
+{
+  nv_assert_else_return(NOVA_CONT_IS_VALID(list), );
+  nv_assert_else_return(fn != NULL, );
+
+  for_job job = { (uchar*)list->data, list->size, list->type_size, chunk_elems(list->type_size), fn, user_data };
+  nv_thread_pool_run(resolve_pool(pool), chunk_count(job.size, job.per_chunk), for_task, &job);
+}
+
+/*
+ * reduce
+ */
+
+typedef struct reduce_job
+{
+  const uchar*      data;
+  size_t            size;
+  size_t            type_size;
+  size_t            per_chunk;
+  uchar*            accs;
+  size_t            acc_size;
+  nv_list_reduce_fn reduce;
+  void*             user_data;
+} reduce_job;
+
+static void
+reduce_task(void* arg, size_t chunk)
+{
+  const reduce_job* job   = (const reduce_job*)arg;
+  const size_t      first = chunk * job->per_chunk;
+  const size_t      count = NV_MIN(job->per_chunk, job->size - first);
+  job->reduce(job->accs + (chunk * job->acc_size), job->data + (first * job->type_size), count, job->user_data);
+}
+
+nv_error
+nv_list_parallel_reduce(const nv_list_t* list, size_t acc_size, const void* identity, nv_list_reduce_fn reduce, nv_list_combine_fn combine, void* user_data,
+                        void* result, nv_thread_pool_t* pool)
+{
+  nv_assert_else_return(NOVA_CONT_IS_VALID(list), NV_ERROR_INVALID_ARG);
+  nv_assert_else_return(acc_size > 0 && identity != NULL && result != NULL, NV_ERROR_INVALID_ARG);
+  nv_assert_else_return(reduce != NULL && combine != NULL, NV_ERROR_INVALID_ARG);
+
+  const size_t per_chunk = chunk_elems(list->type_size);
+  const size_t chunks    = chunk_count(list->size, per_chunk);
+
+  nv_memcpy(result, identity, acc_size);
+  if (chunks == 0) { return NV_SUCCESS; }
+
+  uchar* accs = (uchar*)nv_alloc_zmalloc(list->alloc, chunks * acc_size);
+  if (!accs) { return NV_ERROR_MALLOC_FAILED; }
+
+  for (size_t c = 0; c < chunks; c++) { nv_memcpy(accs + (c * acc_size), identity, acc_size); }
+
+  reduce_job job = { (const uchar*)list->data, list->size, list->type_size, per_chunk, accs, acc_size, reduce, user_data };
+  nv_thread_pool_run(resolve_pool(pool), chunks, reduce_task, &job);
+
+  // combine in list order, the operation need not be commutative.
+  for (size_t c = 0; c < chunks; c++) { combine(result, accs + (c * acc_size), user_data); }
+
+  nv_alloc_free(list->alloc, accs);
+  return NV_SUCCESS;
+}
+
+/*
+ * scan
+ */
+
+typedef struct scan_job
+{
+  uchar*             data;
+  size_t             size;
+  size_t             type_size;
+  size_t             per_chunk;
+  uchar*             carries; // the combined total of all chunks before chunk i
+  uchar*             tmps;    // a temporary element per chunk
+  nv_list_combine_fn combine;
+  void*              user_data;
+} scan_job;
+
+static void
+scan_local_task(void* arg, size_t chunk)
+{
+  const scan_job* job   = (const scan_job*)arg;
+  const size_t    ts    = job->type_size;
+  const size_t    first = chunk * job->per_chunk;
+  const size_t    count = NV_MIN(job->per_chunk, job->size - first);
+  uchar*          elems = job->data + (first * ts);
+  uchar*          tmp   = job->tmps + (chunk * ts);
+
+  for (size_t i = 1; i < count; i++)
+  {
+    nv_memcpy_small(tmp, elems + ((i - 1) * ts), ts);
+    job->combine(tmp, elems + (i * ts), job->user_data);
+    nv_memcpy_small(elems + (i * ts), tmp, ts);
+  }
+}
+
+static void
+scan_carry_task(void* arg, size_t index)
+{
+  const scan_job* job   = (const scan_job*)arg;
+  const size_t    chunk = index + 1; // the first chunk has nothing to carry in
+  const size_t    ts    = job->type_size;
+  const size_t    first = chunk * job->per_chunk;
+  const size_t    count = NV_MIN(job->per_chunk, job->size - first);
+  uchar*          elems = job->data + (first * ts);
+  const uchar*    carry = job->carries + (chunk * ts);
+  uchar*          tmp   = job->tmps + (chunk * ts);
+
+  for (size_t i = 0; i < count; i++)
+  {
+    nv_memcpy_small(tmp, carry, ts);
+    job->combine(tmp, elems + (i * ts), job->user_data);
+    nv_memcpy_small(elems + (i * ts), tmp, ts);
+  }
+}
+
+nv_error
+nv_list_parallel_scan(nv_list_t* list, nv_list_combine_fn combine, void* user_data, nv_thread_pool_t* pool)
+{
+  nv_assert_else_return(NOVA_CONT_IS_VALID(list), NV_ERROR_INVALID_ARG);
+  nv_assert_else_return(combine != NULL, NV_ERROR_INVALID_ARG);
+
+  const size_t ts        = list->type_size;
+  const size_t per_chunk = chunk_elems(ts);
+  const size_t chunks    = chunk_count(list->size, per_chunk);
+  if (chunks == 0) { return NV_SUCCESS; }
+
+  uchar* scratch = (uchar*)nv_alloc_zmalloc(list->alloc, 2 * chunks * ts);
+  if (!scratch) { return NV_ERROR_MALLOC_FAILED; }
+
+  nv_thread_pool_t* p   = resolve_pool(pool);
+  scan_job          job = { (uchar*)list->data, list->size, ts, per_chunk, scratch, scratch + (chunks * ts), combine, user_data };
+
+  nv_thread_pool_run(p, chunks, scan_local_task, &job);
+
+  // carries[c] = total of chunks [0, c), built from the last element of every scanned chunk.
+  for (size_t c = 1; c < chunks; c++)
+  {
+    uchar*       carry = job.carries + (c * ts);
+    const uchar* last  = job.data + (((c * per_chunk) - 1) * ts);
+    if (c == 1) { nv_memcpy_small(carry, last, ts); }
+    else
+    {
+      nv_memcpy_small(carry, carry - ts, ts);
+      combine(carry, last, user_data);
+    }
+  }
+
+  nv_thread_pool_run(p, chunks - 1, scan_carry_task, &job);
+
+  nv_alloc_free(list->alloc, scratch);
+  return NV_SUCCESS;
+}
+
+/*
+ * sort
+ */
+
+typedef struct sort_job
+{
+  uchar*        data;
+  size_t        type_size;
+  const size_t* bounds; // run r is [bounds[r], bounds[r + 1])
+  nv_compare_fn compare;
+  void*         user_data;
+} sort_job;
+
+static void
+sort_run_task(void* arg, size_t run)
+{
+  const sort_job* job = (const sort_job*)arg;
+  const size_t    lo  = job->bounds[run];
+  const size_t    hi  = job->bounds[run + 1];
+  nv_sort(job->data + (lo * job->type_size), hi - lo, job->type_size, job->compare, job->user_data);
+}
+
+/* A piece of a merge of two adjacent runs: outputs [k_begin, k_end) of merging src[a, b) with src[b, c). */
+typedef struct merge_piece
+{
+  size_t a, b, c;
+  size_t k_begin, k_end;
+} merge_piece;
+
+typedef struct merge_job
+{
+  const uchar*       src;
+  uchar*             dst;
+  size_t             type_size;
+  const merge_piece* pieces;
+  nv_compare_fn      compare;
+  void*              user_data;
+} merge_job;
+
+#define ELEM(base, i) ((base) + ((i) * ts))
+
+/**
+ * The number of elements taken from 'a' in the first 'k' outputs of a stable merge of 'a' and 'b' (ties go to 'a').
+ */
+static size_t
+merge_corank(const merge_job* job, const uchar* a, size_t na, const uchar* b, size_t nb, size_t k)
+{
+  const size_t ts = job->type_size;
+
+  size_t lo = k > nb ? k - nb : 0;
+  size_t hi = NV_MIN(k, na);
+  while (lo < hi)
+  {
+    const size_t i = lo + ((hi - lo) / 2);
+    const size_t j = k - i;
+    // b[j - 1] >= a[i] means a[i] comes out before b[j - 1], so more of 'a' is needed.
+    if (j > 0 && job->compare(ELEM(b, j - 1), ELEM(a, i), ts, job->user_data) >= 0) { lo = i + 1; }
+    else
+    {
+      hi = i;
+    }
+  }
+  return lo;
+}
+
+static void
+merge_task(void* arg, size_t index)
+{
+  const merge_job*   job   = (const merge_job*)arg;
+  const merge_piece* piece = &job->pieces[index];
+  const size_t       ts    = job->type_size;
+
+  const uchar* a  = ELEM(job->src, piece->a);
+  const uchar* b  = ELEM(job->src, piece->b);
+  const size_t na = piece->b - piece->a;
+  const size_t nb = piece->c - piece->b;
+
+  size_t       i   = merge_corank(job, a, na, b, nb, piece->k_begin);
+  size_t       j   = piece->k_begin - i;
+  const size_t ie  = merge_corank(job, a, na, b, nb, piece->k_end);
+  const size_t je  = piece->k_end - ie;
+  uchar*       out = ELEM(job->dst, piece->a + piece->k_begin);
+
+  while (i < ie && j < je)
+  {
+    if (job->compare(ELEM(b, j), ELEM(a, i), ts, job->user_data) < 0) { nv_memcpy_small(out, ELEM(b, j++), ts); }
+    else
+    {
+      nv_memcpy_small(out, ELEM(a, i++), ts);
+    }
+    out += ts;
+  }
+  if (i < ie) { nv_memcpy(out, ELEM(a, i), (ie - i) * ts); }
+  else if (j < je) { nv_memcpy(out, ELEM(b, j), (je - j) * ts); }
+}
+
+#undef ELEM
+
+nv_error
+nv_list_parallel_sort(nv_list_t* list, nv_compare_fn compare, void* user_data, nv_thread_pool_t* pool)
+{
+  nv_assert_else_return(NOVA_CONT_IS_VALID(list), NV_ERROR_INVALID_ARG);
+
+  if (!compare) { compare = (nv_compare_fn)nv_compare_default; }
+
+  nv_thread_pool_t* p         = resolve_pool(pool);
+  const size_t      size      = list->size;
+  const size_t      ts        = list->type_size;
+  const size_t      per_chunk = chunk_elems(ts);
+
+  // one run per thread, but no runs smaller than a chunk.
+  const size_t runs = NV_MIN(nv_thread_pool_size(p), chunk_count(size, per_chunk));
+  if (runs <= 1)
+  {
+    nv_sort(list->data, size, ts, compare, user_data);
+    return NV_SUCCESS;
+  }
+
+  // the pieces of a round are atmost one per chunk of output plus one per merge.
+  const size_t max_pieces = chunk_count(size, per_chunk) + runs;
+
+  uchar*       scratch = (uchar*)nv_alloc_zmalloc(list->alloc, size * ts);
+  size_t*      bounds  = (size_t*)nv_alloc_zmalloc(list->alloc, (runs + 1) * sizeof(size_t));
+  merge_piece* pieces  = (merge_piece*)nv_alloc_zmalloc(list->alloc, max_pieces * sizeof(merge_piece));
+  if (!scratch || !bounds || !pieces)
+  {
+    if (scratch) { nv_alloc_free(list->alloc, scratch); }
+    if (bounds) { nv_alloc_free(list->alloc, bounds); }
+    if (pieces) { nv_alloc_free(list->alloc, pieces); }
+    return NV_ERROR_MALLOC_FAILED;
+  }
+
+  for (size_t r = 0; r <= runs; r++) { bounds[r] = (size * r) / runs; }
+
+  sort_job sjob = { (uchar*)list->data, ts, bounds, compare, user_data };
+  nv_thread_pool_run(p, runs, sort_run_task, &sjob);
+
+  uchar* src       = (uchar*)list->data;
+  uchar* dst       = scratch;
+  size_t run_count = runs;
+  while (run_count > 1)
+  {
+    size_t piece_count = 0;
+    for (size_t r = 0; r < run_count; r += 2)
+    {
+      const size_t a = bounds[r];
+      const size_t b = bounds[NV_MIN(r + 1, run_count)];
+      const size_t c = bounds[NV_MIN(r + 2, run_count)];
+
+      // a lone run at the end is merged with nothing, which is a copy.
+      const size_t n     = c - a;
+      const size_t split = NV_MAX((size_t)1, chunk_count(n, per_chunk));
+      for (size_t s = 0; s < split; s++) { pieces[piece_count++] = (merge_piece){ a, b, c, (n * s) / split, (n * (s + 1)) / split }; }
+    }
+
+    merge_job mjob = { src, dst, ts, pieces, compare, user_data };
+    nv_thread_pool_run(p, piece_count, merge_task, &mjob);
+
+    // every other bound goes away
+    size_t merged = 0;
+    for (size_t r = 0; r < run_count; r += 2) { bounds[merged++] = bounds[r]; }
+    bounds[merged] = size;
+    run_count      = merged;
+
+    uchar* tmp = src;
+    src        = dst;
+    dst        = tmp;
+  }
+
+  if (src != list->data) { nv_memcpy(list->data, src, size * ts); }
+
+  nv_alloc_free(list->alloc, pieces);
+  nv_alloc_free(list->alloc, bounds);
+  nv_alloc_free(list->alloc, scratch);
+  return NV_SUCCESS;
+}
@@ -0,0 +1,297 @@
+#include "../../include/containers/list_set.h"
+
+#include "../../include/alloc.h"
+#include "../../include/containers/list.h"
+#include "../../include/error.h"
+#include "../../include/hash.h"
+#include "../../include/stdafx.h"
+#include "../../include/string.h"
+#include "../../include/types.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#if defined(__GNUC__) || defined(__clang__)
+#  define PREFETCH(p) __builtin_prefetch(p)
+#else
+#  define PREFETCH(p) ((void)(p))
+#endif
+
+/*
+ * A set of element indices, with linear probing.
+ * Slots are 8 bytes, the hash and index + 1 (0 is empty), so most mismatches are rejected without touching the element.
+ * Indices below 'split' are elements of 'first', the rest of 'second', so one set can hold elements of two lists.
+ * Nothing is ever removed, and there are at most 'max_elems' inserts, so the table is sized for that once.
+ */
+
+typedef struct set_slot
+{
+  u32 hash;
+  u32 index;
+} set_slot;
+
+typedef struct elem_set
+{
+  set_slot*       slots;
+  size_t          mask;
+  size_t          type_size;
+  const uchar*    first;
+  const uchar*    second;
+  size_t          split;
+  nv_allocator_t* alloc;
+} elem_set;
+
+static nv_error
+set_init(elem_set* set, size_t max_elems, const nv_list_t* first, const nv_list_t* second, nv_allocator_t* alloc)
+{
+  nv_assert_else_return(max_elems < UINT32_MAX, NV_ERROR_INVALID_ARG);
+
+  // at most half full
+  size_t capacity = 16;
+  while (capacity < max_elems * 2) { capacity <<= 1; }
+
+  set->slots     = (set_slot*)nv_alloc_zmalloc(alloc, capacity * sizeof(set_slot));
+  set->mask      = capacity - 1;
+  set->type_size = first->type_size;
+  set->first     = (const uchar*)first->data;
+  set->second    = second ? (const uchar*)second->data : NULL;
+  set->split     = first->size;
+  set->alloc     = alloc;
+  return set->slots ? NV_SUCCESS : NV_ERROR_MALLOC_FAILED;
+}
+
+static void
+set_destroy(elem_set* set)
+{
+  nv_alloc_free(set->alloc, set->slots);
+}
+
+static inline const uchar*
+set_elem(const elem_set* set, size_t index)
+{
+  return index < set->split ? set->first + (index * set->type_size) : set->second + ((index - set->split) * set->type_size);
+}
+
+static inline bool
+elem_equal(const uchar* a, const uchar* b, size_t size)
+{
+  switch (size)
+  {
+    case 4:
+    {
+      u32 x, y;
+      nv_memcpy_small(&x, a, 4);
+      nv_memcpy_small(&y, b, 4);
+      return x == y;
+    }
+    case 8:
+    {
+      u64 x, y;
+      nv_memcpy_small(&x, a, 8);
+      nv_memcpy_small(&y, b, 8);
+      return x == y;
+    }
+    default: return nv_memcmp(a, b, size) == 0;
+  }
+}
+
+/* The slot holding 'elem', or the empty slot where it would go. */
+static inline set_slot*
+set_lookup(const elem_set* set, const uchar* elem, u32 hash)
+{
+  for (size_t i = hash & set->mask;; i = (i + 1) & set->mask)
+  {
+    set_slot* slot = &set->slots[i];
+    if (!slot->index || (slot->hash == hash && elem_equal(set_elem(set, slot->index - 1), elem, set->type_size))) { return slot; }
+  }
+}
+
+static inline bool
+set_contains(const elem_set* set, const uchar* elem, u32 hash)
+{
+  return set_lookup(set, elem, hash)->index != 0;
+}
+
+/* Insert element 'index', false if an equal element is already in. */
+static inline bool
+set_insert(elem_set* set, size_t index, u32 hash)
+{
+  set_slot* slot = set_lookup(set, set_elem(set, index), hash);
+  if (slot->index) { return false; }
+  slot->hash  = hash;
+  slot->index = (u32)index + 1;
+  return true;
+}
+
+/*
+ * Once the table outgrows the cache, nearly every lookup is a cache miss. Hashes are computed PREFETCH_DISTANCE
+ * elements ahead of their lookup and their slot is prefetched, so that the misses overlap instead of stalling one by one.
+ */
+
+#define PREFETCH_DISTANCE 16
+
+typedef struct hash_ahead
+{
+  const uchar*    data;
+  size_t          count;
+  size_t          type_size;
+  const elem_set* set; // the set whose slots are prefetched
+  u32             ring[PREFETCH_DISTANCE];
+} hash_ahead;
+
+static inline void
+ahead_fill(hash_ahead* h, size_t i)
+{
+  const u32 hash                 = nv_hash_murmur3(h->data + (i * h->type_size), h->type_size, NULL);
+  h->ring[i % PREFETCH_DISTANCE] = hash;
+  PREFETCH(&h->set->slots[hash & h->set->mask]);
+}
+
+static inline void
+ahead_init(hash_ahead* h, const nv_list_t* list, const elem_set* set)
+{
+  h->data      = (const uchar*)list->data;
+  h->count     = list->size;
+  h->type_size = list->type_size;
+  h->set       = set;
+  for (size_t i = 0; i < NV_MIN((size_t)PREFETCH_DISTANCE, h->count); i++) { ahead_fill(h, i); }
+}
+
+/* The hash of element i, the elements must be visited in order. */
+static inline u32
+ahead_next(hash_ahead* h, size_t i)
+{
+  const u32 hash = h->ring[i % PREFETCH_DISTANCE];
+  if (i + PREFETCH_DISTANCE < h->count) { ahead_fill(h, i + PREFETCH_DISTANCE); }
+  return hash;
+}
+
+nv_error
+nv_list_unique(nv_list_t* list)
+{
+  nv_assert_else_return(NOVA_CONT_IS_VALID(list), NV_ERROR_INVALID_ARG);
+  if (list->size < 2) { return NV_SUCCESS; }
+
+  const size_t ts = list->type_size;
+  elem_set     seen;
+  nv_error     e = set_init(&seen, list->size, list, NULL, list->alloc);
+  if (e != NV_SUCCESS) { return e; }
+
+  hash_ahead ahead;
+  ahead_init(&ahead, list, &seen);
+
+  // kept elements are compacted to the front first, so the set indexes their final place
+  uchar* data = (uchar*)list->data;
+  size_t kept = 0;
+  for (size_t i = 0; i < list->size; i++)
+  {
+    const uchar* elem = data + (i * ts);
+    const u32    hash = ahead_next(&ahead, i);
+    set_slot*    slot = set_lookup(&seen, elem, hash);
+    if (slot->index) { continue; }
+
+    uchar* dst = data + (kept * ts);
+    if (dst != elem) { nv_memcpy_small(dst, elem, ts); }
+    slot->hash  = hash;
+    slot->index = (u32)kept + 1;
+    kept++;
+  }
+  list->size = kept;
+
+  set_destroy(&seen);
+  return NV_SUCCESS;
+}
+
+static nv_error
+check_args(const nv_list_t* a, const nv_list_t* b, const nv_list_t* out)
+{
+  nv_assert_else_return(NOVA_CONT_IS_VALID(a) && NOVA_CONT_IS_VALID(b) && NOVA_CONT_IS_VALID(out), NV_ERROR_INVALID_ARG);
+  nv_assert_else_return(a->type_size == b->type_size && a->type_size == out->type_size, NV_ERROR_INVALID_ARG);
+  nv_assert_else_return(out != a && out != b, NV_ERROR_INVALID_ARG);
+  return NV_SUCCESS;
+}
+
+/* Clear 'out' and make room for every element it can get, so that emit() needs no checks. */
+static nv_error
+prepare_out(nv_list_t* out, size_t max_size)
+{
+  nv_list_clear(out);
+  nv_list_reserve(out, max_size);
+  return out->capacity >= max_size ? NV_SUCCESS : NV_ERROR_MALLOC_FAILED;
+}
+
+static inline void
+emit(nv_list_t* out, const uchar* elem)
+{
+  nv_memcpy_small((uchar*)out->data + (out->size * out->type_size), elem, out->type_size);
+  out->size++;
+}
+
+nv_error
+nv_list_union(const nv_list_t* a, const nv_list_t* b, nv_list_t* out)
+{
+  nv_error e = check_args(a, b, out);
+  if (e != NV_SUCCESS || (e = prepare_out(out, a->size + b->size)) != NV_SUCCESS) { return e; }
+
+  elem_set seen;
+  if ((e = set_init(&seen, a->size + b->size, a, b, out->alloc)) != NV_SUCCESS) { return e; }
+
+  const nv_list_t* inputs[2] = { a, b };
+  for (size_t l = 0, first = 0; l < 2; first += inputs[l]->size, l++)
+  {
+    hash_ahead ahead;
+    ahead_init(&ahead, inputs[l], &seen);
+    for (size_t i = 0; i < inputs[l]->size; i++)
+    {
+      if (set_insert(&seen, first + i, ahead_next(&ahead, i))) { emit(out, set_elem(&seen, first + i)); }
+    }
+  }
+
+  set_destroy(&seen);
+  return NV_SUCCESS;
+}
+
+/* The distinct elements of 'a' that are (or aren't) in 'b'. */
+static nv_error
+filter_by(const nv_list_t* a, const nv_list_t* b, nv_list_t* out, bool keep_found)
+{
+  nv_error e = check_args(a, b, out);
+  if (e != NV_SUCCESS || (e = prepare_out(out, a->size)) != NV_SUCCESS) { return e; }
+
+  elem_set in_b;
+  elem_set seen;
+  if ((e = set_init(&in_b, b->size, b, NULL, out->alloc)) != NV_SUCCESS) { return e; }
+  if ((e = set_init(&seen, keep_found ? NV_MIN(a->size, b->size) : a->size, a, NULL, out->alloc)) != NV_SUCCESS)
+  {
+    set_destroy(&in_b);
+    return e;
+  }
+
+  hash_ahead ahead;
+  ahead_init(&ahead, b, &in_b);
+  for (size_t i = 0; i < b->size; i++) { set_insert(&in_b, i, ahead_next(&ahead, i)); }
+
+  ahead_init(&ahead, a, &in_b);
+  for (size_t i = 0; i < a->size; i++)
+  {
+    const uchar* elem = set_elem(&seen, i);
+    const u32    hash = ahead_next(&ahead, i);
+    if (set_contains(&in_b, elem, hash) == keep_found && set_insert(&seen, i, hash)) { emit(out, elem); }
+  }
+
+  set_destroy(&seen);
+  set_destroy(&in_b);
+  return NV_SUCCESS;
+}
+
+nv_error
+nv_list_difference(const nv_list_t* a, const nv_list_t* b, nv_list_t* out)
+{
+  return filter_by(a, b, out, false);
+}
+
+nv_error
+nv_list_intersection(const nv_list_t* a, const nv_list_t* b, nv_list_t* out)
+{
+  return filter_by(a, b, out, true);
+}
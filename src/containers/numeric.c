@@ -0,0 +1,718 @@
+#include "../../include/containers/numeric.h"
+
+#include "../../include/alloc.h"
+#include "../../include/containers/list.h"
+#include "../../include/containers/list_parallel.h"
+#include "../../include/cpu.h"
+#include "../../include/error.h"
+#include "../../include/stdafx.h"
+#include "../../include/string.h"
+#include "../../include/threadpool.h"
+#include "../../include/types.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if NV_CPU_X86_SIMD
+#  include <immintrin.h>
+#endif
+
+#define LESS(a, b) ((a) < (b))
+#define GREATER(a, b) ((a) > (b))
+
+/*
+ * Scalar
+ * Sums keep four accumulators, so that the additions don't all wait on each other.
+ * Integer sums and scans are done on an unsigned type (or a wider one) so that wrapping around is defined.
+ */
+
+#define SCALAR_KERNELS(S, T, SUM_ACC, SCAN_ACC, RET)                                                                                                                          \
+  static RET sum_##S##_scalar(const T* data, size_t count)                                                                                                                    \
+  {                                                                                                                                                                           \
+    SUM_ACC s0 = 0, s1 = 0, s2 = 0, s3 = 0;                                                                                                                                   \
+    size_t  i  = 0;                                                                                                                                                           \
+    for (; i + 4 <= count; i += 4)                                                                                                                                            \
+    {                                                                                                                                                                         \
+      s0 += (SUM_ACC)data[i];                                                                                                                                                 \
+      s1 += (SUM_ACC)data[i + 1];                                                                                                                                             \
+      s2 += (SUM_ACC)data[i + 2];                                                                                                                                             \
+      s3 += (SUM_ACC)data[i + 3];                                                                                                                                             \
+    }                                                                                                                                                                         \
+    for (; i < count; i++) { s0 += (SUM_ACC)data[i]; }                                                                                                                        \
+    return (RET)((s0 + s1) + (s2 + s3));                                                                                                                                      \
+  }                                                                                                                                                                           \
+  static T min_##S##_scalar(const T* data, size_t count, T init)                                                                                                              \
+  {                                                                                                                                                                           \
+    for (size_t i = 0; i < count; i++) { init = LESS(data[i], init) ? data[i] : init; }                                                                                       \
+    return init;                                                                                                                                                              \
+  }                                                                                                                                                                           \
+  static T max_##S##_scalar(const T* data, size_t count, T init)                                                                                                              \
+  {                                                                                                                                                                           \
+    for (size_t i = 0; i < count; i++) { init = GREATER(data[i], init) ? data[i] : init; }                                                                                    \
+    return init;                                                                                                                                                              \
+  }                                                                                                                                                                           \
+  static size_t find_##S##_scalar(const T* data, size_t count, T value)                                                                                                       \
+  {                                                                                                                                                                           \
+    for (size_t i = 0; i < count; i++)                                                                                                                                        \
+    {                                                                                                                                                                         \
+      if (data[i] == value) { return i; }                                                                                                                                     \
+    }                                                                                                                                                                         \
+    return count;                                                                                                                                                             \
+  }                                                                                                                                                                           \
+  static T scan_##S##_scalar(const T* src, T* dst, size_t count, T carry)                                                                                                     \
+  {                                                                                                                                                                           \
+    for (size_t i = 0; i < count; i++)                                                                                                                                        \
+    {                                                                                                                                                                         \
+      carry  = (T)((SCAN_ACC)carry + (SCAN_ACC)src[i]);                                                                                                                       \
+      dst[i] = carry;                                                                                                                                                         \
+    }                                                                                                                                                                         \
+    return carry;                                                                                                                                                             \
+  }
+
+SCALAR_KERNELS(i32, i32, i64, u32, i64)
+SCALAR_KERNELS(i64, i64, u64, u64, i64)
+SCALAR_KERNELS(f32, f32, f64, f32, f64)
+SCALAR_KERNELS(f64, f64, f64, f64, f64)
+
+#if NV_CPU_X86_SIMD
+
+#  define LOAD256I(p) _mm256_loadu_si256((const __m256i*)(const void*)(p))
+#  define STORE256I(p, v) _mm256_storeu_si256((__m256i*)(void*)(p), v)
+
+/*
+ * AVX2
+ */
+
+NV_CPU_TARGET("avx2") static i64
+sum_i32_avx2(const i32* data, size_t count)
+{
+  __m256i a0 = _mm256_setzero_si256();
+  __m256i a1 = _mm256_setzero_si256();
+  size_t  i  = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    const __m256i v = LOAD256I(data + i);
+    a0              = _mm256_add_epi64(a0, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v)));
+    a1              = _mm256_add_epi64(a1, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1)));
+  }
+  i64 lanes[4];
+  STORE256I(lanes, _mm256_add_epi64(a0, a1));
+  return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + sum_i32_scalar(data + i, count - i);
+}
+
+NV_CPU_TARGET("avx2") static i64
+sum_i64_avx2(const i64* data, size_t count)
+{
+  __m256i a0 = _mm256_setzero_si256();
+  __m256i a1 = _mm256_setzero_si256();
+  size_t  i  = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    a0 = _mm256_add_epi64(a0, LOAD256I(data + i));
+    a1 = _mm256_add_epi64(a1, LOAD256I(data + i + 4));
+  }
+  u64 lanes[4];
+  STORE256I(lanes, _mm256_add_epi64(a0, a1));
+  return (i64)(((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + (u64)sum_i64_scalar(data + i, count - i));
+}
+
+NV_CPU_TARGET("avx2") static f64
+sum_f32_avx2(const f32* data, size_t count)
+{
+  __m256d a0 = _mm256_setzero_pd();
+  __m256d a1 = _mm256_setzero_pd();
+  size_t  i  = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    const __m256 v = _mm256_loadu_ps(data + i);
+    a0             = _mm256_add_pd(a0, _mm256_cvtps_pd(_mm256_castps256_ps128(v)));
+    a1             = _mm256_add_pd(a1, _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)));
+  }
+  f64 lanes[4];
+  _mm256_storeu_pd(lanes, _mm256_add_pd(a0, a1));
+  return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + sum_f32_scalar(data + i, count - i);
+}
+
+NV_CPU_TARGET("avx2") static f64
+sum_f64_avx2(const f64* data, size_t count)
+{
+  __m256d a0 = _mm256_setzero_pd();
+  __m256d a1 = _mm256_setzero_pd();
+  __m256d a2 = _mm256_setzero_pd();
+  __m256d a3 = _mm256_setzero_pd();
+  size_t  i  = 0;
+  for (; i + 16 <= count; i += 16)
+  {
+    a0 = _mm256_add_pd(a0, _mm256_loadu_pd(data + i));
+    a1 = _mm256_add_pd(a1, _mm256_loadu_pd(data + i + 4));
+    a2 = _mm256_add_pd(a2, _mm256_loadu_pd(data + i + 8));
+    a3 = _mm256_add_pd(a3, _mm256_loadu_pd(data + i + 12));
+  }
+  f64 lanes[4];
+  _mm256_storeu_pd(lanes, _mm256_add_pd(_mm256_add_pd(a0, a1), _mm256_add_pd(a2, a3)));
+  return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + sum_f64_scalar(data + i, count - i);
+}
+
+/* AVX2 has no 64 bit integer min and max. */
+NV_CPU_TARGET("avx2") static inline __m256i
+min_epi64_avx2(__m256i a, __m256i b)
+{
+  return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(a, b));
+}
+
+NV_CPU_TARGET("avx2") static inline __m256i
+max_epi64_avx2(__m256i a, __m256i b)
+{
+  return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(b, a));
+}
+
+/* Fold whole vectors with OP, then the lanes and the tail with the scalar kernel. */
+#  define MINMAX_AVX2(NAME, T, VEC, PER, SET1, LOADU, STOREU, OP)                                                                                                             \
+    NV_CPU_TARGET("avx2") static T NAME##_avx2(const T* data, size_t count, T init)                                                                                           \
+    {                                                                                                                                                                         \
+      VEC    m = SET1(init);                                                                                                                                                  \
+      size_t i = 0;                                                                                                                                                           \
+      for (; i + PER <= count; i += PER) { m = OP(m, LOADU(data + i)); }                                                                                                      \
+      T lanes[PER];                                                                                                                                                           \
+      STOREU(lanes, m);                                                                                                                                                       \
+      return NAME##_scalar(data + i, count - i, NAME##_scalar(lanes, PER, init));                                                                                             \
+    }
+
+MINMAX_AVX2(min_i32, i32, __m256i, 8, _mm256_set1_epi32, LOAD256I, STORE256I, _mm256_min_epi32)
+MINMAX_AVX2(max_i32, i32, __m256i, 8, _mm256_set1_epi32, LOAD256I, STORE256I, _mm256_max_epi32)
+MINMAX_AVX2(min_i64, i64, __m256i, 4, _mm256_set1_epi64x, LOAD256I, STORE256I, min_epi64_avx2)
+MINMAX_AVX2(max_i64, i64, __m256i, 4, _mm256_set1_epi64x, LOAD256I, STORE256I, max_epi64_avx2)
+MINMAX_AVX2(min_f32, f32, __m256, 8, _mm256_set1_ps, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_min_ps)
+MINMAX_AVX2(max_f32, f32, __m256, 8, _mm256_set1_ps, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_max_ps)
+MINMAX_AVX2(min_f64, f64, __m256d, 4, _mm256_set1_pd, _mm256_loadu_pd, _mm256_storeu_pd, _mm256_min_pd)
+MINMAX_AVX2(max_f64, f64, __m256d, 4, _mm256_set1_pd, _mm256_loadu_pd, _mm256_storeu_pd, _mm256_max_pd)
+
+#  define EQ_MASK_I32_AVX2(a, b) _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b)))
+#  define EQ_MASK_I64_AVX2(a, b) _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(a, b)))
+#  define EQ_MASK_F32_AVX2(a, b) _mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_EQ_OQ))
+#  define EQ_MASK_F64_AVX2(a, b) _mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_EQ_OQ))
+
+#  define FIND_AVX2(S, T, VEC, PER, SET1, LOADU, EQ_MASK)                                                                                                                     \
+    NV_CPU_TARGET("avx2") static size_t find_##S##_avx2(const T* data, size_t count, T value)                                                                                 \
+    {                                                                                                                                                                         \
+      const VEC needle = SET1(value);                                                                                                                                         \
+      size_t    i      = 0;                                                                                                                                                   \
+      for (; i + PER <= count; i += PER)                                                                                                                                      \
+      {                                                                                                                                                                       \
+        const unsigned m = (unsigned)EQ_MASK(LOADU(data + i), needle);                                                                                                        \
+        if (m) { return i + (size_t)__builtin_ctz(m); }                                                                                                                       \
+      }                                                                                                                                                                       \
+      return i + find_##S##_scalar(data + i, count - i, value);                                                                                                               \
+    }
+
+FIND_AVX2(i32, i32, __m256i, 8, _mm256_set1_epi32, LOAD256I, EQ_MASK_I32_AVX2)
+FIND_AVX2(i64, i64, __m256i, 4, _mm256_set1_epi64x, LOAD256I, EQ_MASK_I64_AVX2)
+FIND_AVX2(f32, f32, __m256, 8, _mm256_set1_ps, _mm256_loadu_ps, EQ_MASK_F32_AVX2)
+FIND_AVX2(f64, f64, __m256d, 4, _mm256_set1_pd, _mm256_loadu_pd, EQ_MASK_F64_AVX2)
+
+/**
+ * Scans add every element to the ones after it in log2(lanes) shifted adds. The byte shifts stay within 128 bit lanes,
+ * so the low lane's total is then added to the high lane, and the carry from the previous vector to both.
+ */
+
+NV_CPU_TARGET("avx2") static i32
+scan_i32_avx2(const i32* src, i32* dst, size_t count, i32 carry)
+{
+  const __m256i zero  = _mm256_setzero_si256();
+  const __m256i third = _mm256_set1_epi32(3);
+  const __m256i last  = _mm256_set1_epi32(7);
+  __m256i       c     = _mm256_set1_epi32(carry);
+  size_t        i     = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    __m256i x = LOAD256I(src + i);
+    x         = _mm256_add_epi32(x, _mm256_slli_si256(x, 4));
+    x         = _mm256_add_epi32(x, _mm256_slli_si256(x, 8));
+    x         = _mm256_add_epi32(x, _mm256_blend_epi32(zero, _mm256_permutevar8x32_epi32(x, third), 0xF0));
+    x         = _mm256_add_epi32(x, c);
+    STORE256I(dst + i, x);
+    c = _mm256_permutevar8x32_epi32(x, last);
+  }
+  return scan_i32_scalar(src + i, dst + i, count - i, _mm256_extract_epi32(c, 0));
+}
+
+NV_CPU_TARGET("avx2") static i64
+scan_i64_avx2(const i64* src, i64* dst, size_t count, i64 carry)
+{
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i       c    = _mm256_set1_epi64x(carry);
+  size_t        i    = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    __m256i x = LOAD256I(src + i);
+    x         = _mm256_add_epi64(x, _mm256_slli_si256(x, 8));
+    x         = _mm256_add_epi64(x, _mm256_blend_epi32(zero, _mm256_permute4x64_epi64(x, _MM_SHUFFLE(1, 1, 1, 1)), 0xF0));
+    x         = _mm256_add_epi64(x, c);
+    STORE256I(dst + i, x);
+    c = _mm256_permute4x64_epi64(x, _MM_SHUFFLE(3, 3, 3, 3));
+  }
+  return scan_i64_scalar(src + i, dst + i, count - i, _mm256_extract_epi64(c, 0));
+}
+
+NV_CPU_TARGET("avx2") static f32
+scan_f32_avx2(const f32* src, f32* dst, size_t count, f32 carry)
+{
+  const __m256  zero  = _mm256_setzero_ps();
+  const __m256i third = _mm256_set1_epi32(3);
+  const __m256i last  = _mm256_set1_epi32(7);
+  __m256        c     = _mm256_set1_ps(carry);
+  size_t        i     = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    __m256 x = _mm256_loadu_ps(src + i);
+    x        = _mm256_add_ps(x, _mm256_castsi256_ps(_mm256_slli_si256(_mm256_castps_si256(x), 4)));
+    x        = _mm256_add_ps(x, _mm256_castsi256_ps(_mm256_slli_si256(_mm256_castps_si256(x), 8)));
+    x        = _mm256_add_ps(x, _mm256_blend_ps(zero, _mm256_permutevar8x32_ps(x, third), 0xF0));
+    x        = _mm256_add_ps(x, c);
+    _mm256_storeu_ps(dst + i, x);
+    c = _mm256_permutevar8x32_ps(x, last);
+  }
+  return scan_f32_scalar(src + i, dst + i, count - i, _mm256_cvtss_f32(c));
+}
+
+NV_CPU_TARGET("avx2") static f64
+scan_f64_avx2(const f64* src, f64* dst, size_t count, f64 carry)
+{
+  const __m256d zero = _mm256_setzero_pd();
+  __m256d       c    = _mm256_set1_pd(carry);
+  size_t        i    = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    __m256d x = _mm256_loadu_pd(src + i);
+    x         = _mm256_add_pd(x, _mm256_castsi256_pd(_mm256_slli_si256(_mm256_castpd_si256(x), 8)));
+    x         = _mm256_add_pd(x, _mm256_blend_pd(zero, _mm256_permute4x64_pd(x, _MM_SHUFFLE(1, 1, 1, 1)), 0xC));
+    x         = _mm256_add_pd(x, c);
+    _mm256_storeu_pd(dst + i, x);
+    c = _mm256_permute4x64_pd(x, _MM_SHUFFLE(3, 3, 3, 3));
+  }
+  return scan_f64_scalar(src + i, dst + i, count - i, _mm256_cvtsd_f64(c));
+}
+
+/*
+ * AVX-512
+ * Scans use the AVX2 code, they are bound by memory bandwidth long before the wider vectors would help.
+ */
+
+#  define LOAD512I(p) _mm512_loadu_si512((const void*)(p))
+
+NV_CPU_TARGET("avx512f") static i64
+sum_i32_avx512(const i32* data, size_t count)
+{
+  __m512i a0 = _mm512_setzero_si512();
+  __m512i a1 = _mm512_setzero_si512();
+  size_t  i  = 0;
+  for (; i + 16 <= count; i += 16)
+  {
+    const __m512i v = LOAD512I(data + i);
+    a0              = _mm512_add_epi64(a0, _mm512_cvtepi32_epi64(_mm512_castsi512_si256(v)));
+    a1              = _mm512_add_epi64(a1, _mm512_cvtepi32_epi64(_mm512_extracti64x4_epi64(v, 1)));
+  }
+  return _mm512_reduce_add_epi64(_mm512_add_epi64(a0, a1)) + sum_i32_scalar(data + i, count - i);
+}
+
+NV_CPU_TARGET("avx512f") static i64
+sum_i64_avx512(const i64* data, size_t count)
+{
+  __m512i a0 = _mm512_setzero_si512();
+  __m512i a1 = _mm512_setzero_si512();
+  size_t  i  = 0;
+  for (; i + 16 <= count; i += 16)
+  {
+    a0 = _mm512_add_epi64(a0, LOAD512I(data + i));
+    a1 = _mm512_add_epi64(a1, LOAD512I(data + i + 8));
+  }
+  // _mm512_reduce_add_epi64() adds as signed, which may overflow.
+  u64 lanes[8];
+  _mm512_storeu_si512((void*)lanes, _mm512_add_epi64(a0, a1));
+  u64 sum = (u64)sum_i64_scalar(data + i, count - i);
+  for (int l = 0; l < 8; l++) { sum += lanes[l]; }
+  return (i64)sum;
+}
+
+NV_CPU_TARGET("avx512f") static f64
+sum_f32_avx512(const f32* data, size_t count)
+{
+  __m512d a0 = _mm512_setzero_pd();
+  __m512d a1 = _mm512_setzero_pd();
+  size_t  i  = 0;
+  for (; i + 16 <= count; i += 16)
+  {
+    a0 = _mm512_add_pd(a0, _mm512_cvtps_pd(_mm256_loadu_ps(data + i)));
+    a1 = _mm512_add_pd(a1, _mm512_cvtps_pd(_mm256_loadu_ps(data + i + 8)));
+  }
+  return _mm512_reduce_add_pd(_mm512_add_pd(a0, a1)) + sum_f32_scalar(data + i, count - i);
+}
+
+NV_CPU_TARGET("avx512f") static f64
+sum_f64_avx512(const f64* data, size_t count)
+{
+  __m512d a0 = _mm512_setzero_pd();
+  __m512d a1 = _mm512_setzero_pd();
+  __m512d a2 = _mm512_setzero_pd();
+  __m512d a3 = _mm512_setzero_pd();
+  size_t  i  = 0;
+  for (; i + 32 <= count; i += 32)
+  {
+    a0 = _mm512_add_pd(a0, _mm512_loadu_pd(data + i));
+    a1 = _mm512_add_pd(a1, _mm512_loadu_pd(data + i + 8));
+    a2 = _mm512_add_pd(a2, _mm512_loadu_pd(data + i + 16));
+    a3 = _mm512_add_pd(a3, _mm512_loadu_pd(data + i + 24));
+  }
+  return _mm512_reduce_add_pd(_mm512_add_pd(_mm512_add_pd(a0, a1), _mm512_add_pd(a2, a3))) + sum_f64_scalar(data + i, count - i);
+}
+
+#  define MINMAX_AVX512(NAME, T, VEC, PER, SET1, LOADU, OP, REDUCE)                                                                                                           \
+    NV_CPU_TARGET("avx512f") static T NAME##_avx512(const T* data, size_t count, T init)                                                                                      \
+    {                                                                                                                                                                         \
+      VEC    m = SET1(init);                                                                                                                                                  \
+      size_t i = 0;                                                                                                                                                           \
+      for (; i + PER <= count; i += PER) { m = OP(m, LOADU(data + i)); }                                                                                                      \
+      return NAME##_scalar(data + i, count - i, REDUCE(m));                                                                                                                   \
+    }
+
+MINMAX_AVX512(min_i32, i32, __m512i, 16, _mm512_set1_epi32, LOAD512I, _mm512_min_epi32, _mm512_reduce_min_epi32)
+MINMAX_AVX512(max_i32, i32, __m512i, 16, _mm512_set1_epi32, LOAD512I, _mm512_max_epi32, _mm512_reduce_max_epi32)
+MINMAX_AVX512(min_i64, i64, __m512i, 8, _mm512_set1_epi64, LOAD512I, _mm512_min_epi64, _mm512_reduce_min_epi64)
+MINMAX_AVX512(max_i64, i64, __m512i, 8, _mm512_set1_epi64, LOAD512I, _mm512_max_epi64, _mm512_reduce_max_epi64)
+MINMAX_AVX512(min_f32, f32, __m512, 16, _mm512_set1_ps, _mm512_loadu_ps, _mm512_min_ps, _mm512_reduce_min_ps)
+MINMAX_AVX512(max_f32, f32, __m512, 16, _mm512_set1_ps, _mm512_loadu_ps, _mm512_max_ps, _mm512_reduce_max_ps)
+MINMAX_AVX512(min_f64, f64, __m512d, 8, _mm512_set1_pd, _mm512_loadu_pd, _mm512_min_pd, _mm512_reduce_min_pd)
+MINMAX_AVX512(max_f64, f64, __m512d, 8, _mm512_set1_pd, _mm512_loadu_pd, _mm512_max_pd, _mm512_reduce_max_pd)
+
+#  define EQ_MASK_F32_AVX512(a, b) _mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ)
+#  define EQ_MASK_F64_AVX512(a, b) _mm512_cmp_pd_mask(a, b, _CMP_EQ_OQ)
+
+#  define FIND_AVX512(S, T, VEC, PER, SET1, LOADU, EQ_MASK)                                                                                                                   \
+    NV_CPU_TARGET("avx512f") static size_t find_##S##_avx512(const T* data, size_t count, T value)                                                                            \
+    {                                                                                                                                                                         \
+      const VEC needle = SET1(value);                                                                                                                                         \
+      size_t    i      = 0;                                                                                                                                                   \
+      for (; i + PER <= count; i += PER)                                                                                                                                      \
+      {                                                                                                                                                                       \
+        const unsigned m = (unsigned)EQ_MASK(LOADU(data + i), needle);                                                                                                        \
+        if (m) { return i + (size_t)__builtin_ctz(m); }                                                                                                                       \
+      }                                                                                                                                                                       \
+      return i + find_##S##_scalar(data + i, count - i, value);                                                                                                               \
+    }
+
+FIND_AVX512(i32, i32, __m512i, 16, _mm512_set1_epi32, LOAD512I, _mm512_cmpeq_epi32_mask)
+FIND_AVX512(i64, i64, __m512i, 8, _mm512_set1_epi64, LOAD512I, _mm512_cmpeq_epi64_mask)
+FIND_AVX512(f32, f32, __m512, 16, _mm512_set1_ps, _mm512_loadu_ps, EQ_MASK_F32_AVX512)
+FIND_AVX512(f64, f64, __m512d, 8, _mm512_set1_pd, _mm512_loadu_pd, EQ_MASK_F64_AVX512)
+
+#  define DISPATCH(KERNEL, ...)                                                                                                                                               \
+    do                                                                                                                                                                        \
+    {                                                                                                                                                                         \
+      if (nv_cpu_has(NV_CPU_AVX512F)) { return KERNEL##_avx512(__VA_ARGS__); }                                                                                                \
+      if (nv_cpu_has(NV_CPU_AVX2)) { return KERNEL##_avx2(__VA_ARGS__); }                                                                                                     \
+      return KERNEL##_scalar(__VA_ARGS__);                                                                                                                                    \
+    } while (0)
+
+#  define DISPATCH_SCAN(KERNEL, ...)                                                                                                                                          \
+    do                                                                                                                                                                        \
+    {                                                                                                                                                                         \
+      if (nv_cpu_has(NV_CPU_AVX2)) { return KERNEL##_avx2(__VA_ARGS__); }                                                                                                     \
+      return KERNEL##_scalar(__VA_ARGS__);                                                                                                                                    \
+    } while (0)
+
+#else
+
+#  define DISPATCH(KERNEL, ...) return KERNEL##_scalar(__VA_ARGS__)
+#  define DISPATCH_SCAN(KERNEL, ...) return KERNEL##_scalar(__VA_ARGS__)
+
+#endif
+
+/*
+ * Array kernels
+ */
+
+#define KERNELS(S, T, RET, LOWEST, HIGHEST)                                                                                                                                   \
+  static RET sum_##S(const T* data, size_t count)                                                                                                                             \
+  {                                                                                                                                                                           \
+    DISPATCH(sum_##S, data, count);                                                                                                                                           \
+  }                                                                                                                                                                           \
+  static T min_##S(const T* data, size_t count, T init)                                                                                                                       \
+  {                                                                                                                                                                           \
+    DISPATCH(min_##S, data, count, init);                                                                                                                                     \
+  }                                                                                                                                                                           \
+  static T max_##S(const T* data, size_t count, T init)                                                                                                                       \
+  {                                                                                                                                                                           \
+    DISPATCH(max_##S, data, count, init);                                                                                                                                     \
+  }                                                                                                                                                                           \
+  static size_t find_##S(const T* data, size_t count, T value)                                                                                                                \
+  {                                                                                                                                                                           \
+    DISPATCH(find_##S, data, count, value);                                                                                                                                   \
+  }                                                                                                                                                                           \
+  static T scan_##S(const T* src, T* dst, size_t count, T carry)                                                                                                              \
+  {                                                                                                                                                                           \
+    DISPATCH_SCAN(scan_##S, src, dst, count, carry);                                                                                                                          \
+  }                                                                                                                                                                           \
+  RET nv_sum_##S(const T* data, size_t count)                                                                                                                                 \
+  {                                                                                                                                                                           \
+    return sum_##S(data, count);                                                                                                                                              \
+  }                                                                                                                                                                           \
+  T nv_min_##S(const T* data, size_t count)                                                                                                                                   \
+  {                                                                                                                                                                           \
+    return min_##S(data, count, HIGHEST);                                                                                                                                     \
+  }                                                                                                                                                                           \
+  T nv_max_##S(const T* data, size_t count)                                                                                                                                   \
+  {                                                                                                                                                                           \
+    return max_##S(data, count, LOWEST);                                                                                                                                      \
+  }                                                                                                                                                                           \
+  size_t nv_argmin_##S(const T* data, size_t count)                                                                                                                           \
+  {                                                                                                                                                                           \
+    if (count == 0) { return count; }                                                                                                                                         \
+    return find_##S(data, count, min_##S(data, count, HIGHEST));                                                                                                              \
+  }                                                                                                                                                                           \
+  size_t nv_argmax_##S(const T* data, size_t count)                                                                                                                           \
+  {                                                                                                                                                                           \
+    if (count == 0) { return count; }                                                                                                                                         \
+    return find_##S(data, count, max_##S(data, count, LOWEST));                                                                                                               \
+  }                                                                                                                                                                           \
+  void nv_scan_##S(const T* src, T* dst, size_t count)                                                                                                                        \
+  {                                                                                                                                                                           \
+    nv_assert_else_return(src != NULL || count == 0, );                                                                                                                       \
+    nv_assert_else_return(dst != NULL || count == 0, );                                                                                                                       \
+    (void)scan_##S(src, dst, count, 0);                                                                                                                                       \
+  }
+
+KERNELS(i32, i32, i64, INT32_MIN, INT32_MAX)
+KERNELS(i64, i64, i64, INT64_MIN, INT64_MAX)
+KERNELS(f32, f32, f64, -INFINITY, INFINITY)
+KERNELS(f64, f64, f64, -INFINITY, INFINITY)
+
+/*
+ * Lists
+ */
+
+static inline nv_thread_pool_t*
+resolve_pool(nv_thread_pool_t* pool)
+{
+  return pool ? pool : nv_thread_pool_default();
+}
+
+static inline size_t
+numeric_width(nv_sort_key type)
+{
+  switch (type)
+  {
+    case NV_SORT_KEY_I32: return sizeof(i32);
+    case NV_SORT_KEY_I64: return sizeof(i64);
+    case NV_SORT_KEY_F32: return sizeof(f32);
+    case NV_SORT_KEY_F64: return sizeof(f64);
+    default: return 0;
+  }
+}
+
+/* Run task over every chunk, on the pool if the list is large enough for it to pay off. */
+static void
+run_chunks(const nv_list_t* list, nv_thread_pool_t* pool, size_t chunks, nv_task_fn task, void* job)
+{
+  if (list->size * list->type_size >= (size_t)NV_NUMERIC_PARALLEL_BYTES) { nv_thread_pool_run(resolve_pool(pool), chunks, task, job); }
+  else
+  {
+    for (size_t c = 0; c < chunks; c++) { task(job, c); }
+  }
+}
+
+typedef struct summary_job
+{
+  const uchar*          data;
+  size_t                size;
+  nv_sort_key           type;
+  size_t                per_chunk;
+  nv_numeric_summary_t* partials;
+} summary_job;
+
+#define SUMMARIZE_CASE(KEY, S, T, MEMBER, LOWEST, HIGHEST)                                                                                                                    \
+  case KEY:                                                                                                                                                                   \
+  {                                                                                                                                                                           \
+    const T* d  = (const T*)elems;                                                                                                                                            \
+    const T  lo = min_##S(d, count, HIGHEST);                                                                                                                                 \
+    const T  hi = max_##S(d, count, LOWEST);                                                                                                                                  \
+    s->sum.MEMBER = sum_##S(d, count);                                                                                                                                        \
+    s->min.MEMBER = lo;                                                                                                                                                       \
+    s->max.MEMBER = hi;                                                                                                                                                       \
+    s->argmin     = count ? find_##S(d, count, lo) : count;                                                                                                                   \
+    s->argmax     = count ? find_##S(d, count, hi) : count;                                                                                                                   \
+    break;                                                                                                                                                                    \
+  }
+
+static void
+summarize_elems(const void* elems, size_t count, nv_sort_key type, nv_numeric_summary_t* s)
+{
+  s->count = count;
+  switch (type)
+  {
+    SUMMARIZE_CASE(NV_SORT_KEY_I32, i32, i32, i, INT32_MIN, INT32_MAX)
+    SUMMARIZE_CASE(NV_SORT_KEY_I64, i64, i64, i, INT64_MIN, INT64_MAX)
+    SUMMARIZE_CASE(NV_SORT_KEY_F32, f32, f32, f, -INFINITY, INFINITY)
+    SUMMARIZE_CASE(NV_SORT_KEY_F64, f64, f64, f, -INFINITY, INFINITY)
+    default: break;
+  }
+}
+
+static void
+summary_task(void* arg, size_t chunk)
+{
+  const summary_job* job   = (const summary_job*)arg;
+  const size_t       first = chunk * job->per_chunk;
+  const size_t       count = NV_MIN(job->per_chunk, job->size - first);
+  summarize_elems(job->data + (first * numeric_width(job->type)), count, job->type, job->partials + chunk);
+}
+
+/* Fold chunk 'part', which starts at element 'first', into 'acc'. Ties keep the earlier index. */
+static void
+summary_combine(nv_numeric_summary_t* acc, const nv_numeric_summary_t* part, size_t first, bool is_float)
+{
+  if (is_float)
+  {
+    acc->sum.f += part->sum.f;
+    if (part->min.f < acc->min.f) { acc->min = part->min, acc->argmin = first + part->argmin; }
+    if (part->max.f > acc->max.f) { acc->max = part->max, acc->argmax = first + part->argmax; }
+  }
+  else
+  {
+    acc->sum.i = (i64)((u64)acc->sum.i + (u64)part->sum.i);
+    if (part->min.i < acc->min.i) { acc->min = part->min, acc->argmin = first + part->argmin; }
+    if (part->max.i > acc->max.i) { acc->max = part->max, acc->argmax = first + part->argmax; }
+  }
+}
+
+nv_error
+nv_list_summarize(const nv_list_t* list, nv_sort_key type, nv_thread_pool_t* pool, nv_numeric_summary_t* summary)
+{
+  nv_assert_else_return(NOVA_CONT_IS_VALID(list), NV_ERROR_INVALID_ARG);
+  nv_assert_else_return(summary != NULL, NV_ERROR_INVALID_ARG);
+  nv_assert_else_return(numeric_width(type) == list->type_size, NV_ERROR_INVALID_ARG);
+
+  const size_t per_chunk = NV_MAX((size_t)1, (size_t)NV_LIST_PARALLEL_CHUNK_BYTES / list->type_size);
+  const size_t chunks    = (list->size + per_chunk - 1) / per_chunk;
+  if (chunks <= 1)
+  {
+    summarize_elems(list->data, list->size, type, summary);
+    return NV_SUCCESS;
+  }
+
+  nv_numeric_summary_t* partials = (nv_numeric_summary_t*)nv_alloc_zmalloc(list->alloc, chunks * sizeof(nv_numeric_summary_t));
+  if (!partials) { return NV_ERROR_MALLOC_FAILED; }
+
+  summary_job job = { (const uchar*)list->data, list->size, type, per_chunk, partials };
+  run_chunks(list, pool, chunks, summary_task, &job);
+
+  const bool is_float = type == NV_SORT_KEY_F32 || type == NV_SORT_KEY_F64;
+  *summary            = partials[0];
+  for (size_t c = 1; c < chunks; c++) { summary_combine(summary, partials + c, c * per_chunk, is_float); }
+  summary->count = list->size;
+
+  nv_alloc_free(list->alloc, partials);
+  return NV_SUCCESS;
+}
+
+/**
+ * Like nv_list_parallel_scan(): every chunk is scanned on its own, then the running total of the chunks before it
+ * is added to it. The second pass is a plain add that the compiler vectorizes.
+ */
+
+typedef struct scan_job
+{
+  uchar*        data;
+  size_t        size;
+  nv_sort_key   type;
+  size_t        per_chunk;
+  nv_agg_value* carries; // the total of all chunks before chunk i
+} scan_job;
+
+#define SCAN_CASES(KEY, S, T, ACC, MEMBER)                                                                                                                                    \
+  case KEY:                                                                                                                                                                   \
+  {                                                                                                                                                                           \
+    T* d = (T*)job->data + first;                                                                                                                                             \
+    if (local) { (void)scan_##S(d, d, count, 0); }                                                                                                                            \
+    else                                                                                                                                                                      \
+    {                                                                                                                                                                         \
+      const T carry = (T)job->carries[chunk].MEMBER;                                                                                                                          \
+      for (size_t i = 0; i < count; i++) { d[i] = (T)((ACC)d[i] + (ACC)carry); }                                                                                              \
+    }                                                                                                                                                                         \
+    break;                                                                                                                                                                    \
+  }
+
+static void
+scan_chunk(const scan_job* job, size_t chunk, bool local)
+{
+  const size_t first = chunk * job->per_chunk;
+  const size_t count = NV_MIN(job->per_chunk, job->size - first);
+  switch (job->type)
+  {
+    SCAN_CASES(NV_SORT_KEY_I32, i32, i32, u32, i)
+    SCAN_CASES(NV_SORT_KEY_I64, i64, i64, u64, i)
+    SCAN_CASES(NV_SORT_KEY_F32, f32, f32, f32, f)
+    SCAN_CASES(NV_SORT_KEY_F64, f64, f64, f64, f)
+    default: break;
+  }
+}
+
+static void
+scan_local_task(void* arg, size_t chunk)
+{
+  scan_chunk((const scan_job*)arg, chunk, true);
+}
+
+static void
+scan_carry_task(void* arg, size_t chunk)
+{
+  // chunk 0 has nothing before it
+  scan_chunk((const scan_job*)arg, chunk + 1, false);
+}
+
+/* The last element of a scanned chunk, as the running total type. */
+static nv_agg_value
+scan_last(const scan_job* job, size_t index)
+{
+  nv_agg_value v = { 0 };
+  switch (job->type)
+  {
+    case NV_SORT_KEY_I32: v.i = ((const i32*)job->data)[index]; break;
+    case NV_SORT_KEY_I64: v.i = ((const i64*)job->data)[index]; break;
+    case NV_SORT_KEY_F32: v.f = ((const f32*)job->data)[index]; break;
+    case NV_SORT_KEY_F64: v.f = ((const f64*)job->data)[index]; break;
+    default: break;
+  }
+  return v;
+}
+
+nv_error
+nv_list_inclusive_scan(nv_list_t* list, nv_sort_key type, nv_thread_pool_t* pool)
+{
+  nv_assert_else_return(NOVA_CONT_IS_VALID(list), NV_ERROR_INVALID_ARG);
+  nv_assert_else_return(numeric_width(type) == list->type_size, NV_ERROR_INVALID_ARG);
+
+  const size_t per_chunk = NV_MAX((size_t)1, (size_t)NV_LIST_PARALLEL_CHUNK_BYTES / list->type_size);
+  const size_t chunks    = (list->size + per_chunk - 1) / per_chunk;
+  if (chunks == 0) { return NV_SUCCESS; }
+
+  nv_agg_value* carries = (nv_agg_value*)nv_alloc_zmalloc(list->alloc, chunks * sizeof(nv_agg_value));
+  if (!carries) { return NV_ERROR_MALLOC_FAILED; }
+
+  scan_job job = { (uchar*)list->data, list->size, type, per_chunk, carries };
+  run_chunks(list, pool, chunks, scan_local_task, &job);
+
+  const bool is_float = type == NV_SORT_KEY_F32 || type == NV_SORT_KEY_F64;
+  for (size_t c = 1; c < chunks; c++)
+  {
+    const nv_agg_value last = scan_last(&job, (c * per_chunk) - 1);
+    if (is_float) { carries[c].f = carries[c - 1].f + last.f; }
+    else { carries[c].i = (i64)((u64)carries[c - 1].i + (u64)last.i); }
+  }
+
+  if (chunks > 1) { run_chunks(list, pool, chunks - 1, scan_carry_task, &job); }
+
+  nv_alloc_free(list->alloc, carries);
+  return NV_SUCCESS;
+}
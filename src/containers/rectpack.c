@@ -15,6 +15,12 @@
 
 nv_error
 nv_skyline_bin_init(size_t width, size_t height, nv_skyline_bin_t* dst)
+{
+  return nv_skyline_bin_init_with_allocator(width, height, NULL, dst);
+}
+
+nv_error
+nv_skyline_bin_init_with_allocator(size_t width, size_t height, nv_allocator_t* allocator, nv_skyline_bin_t* dst)
 {
   nv_assert_else_return(dst != NULL, NV_ERROR_INVALID_ARG);
   nv_assert_else_return(width != 0, NV_ERROR_INVALID_ARG);
@@ -25,12 +31,13 @@ nv_skyline_bin_init(size_t width, size_t height, nv_skyline_bin_t* dst)
   dst->canary = NOVA_CONT_CANARY;
   dst->width  = width;
   dst->height = height;
+  dst->alloc  = allocator ? allocator : nv_alloc_current;
 
   dst->rects                = NULL;
   dst->num_rects            = 0;
   dst->allocated_rect_count = 0;
 
-  dst->skyline = (size_t*)nv_zmalloc(width * sizeof(size_t));
+  dst->skyline = (size_t*)nv_alloc_zmalloc(dst->alloc, width * sizeof(size_t));
   nv_assert_else_return(dst->skyline != NULL, NV_ERROR_MALLOC_FAILED);
 
   nv_assert_else_return(NOVA_CONT_IS_VALID(dst), NV_ERROR_BROKEN_STATE);
@@ -43,8 +50,8 @@ nv_skyline_bin_destroy(nv_skyline_bin_t* bin)
 {
   if (!bin) { return; }
   nv_assert(NOVA_CONT_IS_VALID(bin));
-  if (bin->rects) { nv_free(bin->rects); }
-  if (bin->skyline) { nv_free(bin->skyline); }
+  if (bin->rects) { nv_alloc_free(bin->alloc, bin->rects); }
+  if (bin->skyline) { nv_alloc_free(bin->alloc, bin->skyline); }
 }
 
 size_t
@@ -113,10 +120,10 @@ nv_skyline_bin_place_rect(nv_skyline_bin_t* bin, const nv_skyline_rect_t* rect,
   {
     size_t new_alloc = (bin->allocated_rect_count == 0) ? 2 : bin->allocated_rect_count * 2;
 
-    if (bin->rects) { bin->rects = (nv_skyline_rect_t*)nv_realloc(bin->rects, new_alloc * sizeof(nv_skyline_rect_t)); }
+    if (bin->rects) { bin->rects = (nv_skyline_rect_t*)nv_alloc_realloc(bin->alloc, bin->rects, new_alloc * sizeof(nv_skyline_rect_t)); }
     else
     {
-      bin->rects = nv_zmalloc(new_alloc * sizeof(nv_skyline_rect_t));
+      bin->rects = nv_alloc_zmalloc(bin->alloc, new_alloc * sizeof(nv_skyline_rect_t));
     }
     bin->allocated_rect_count = new_alloc;
   }
@@ -168,12 +175,12 @@ nv_skyline_bin_resize(nv_skyline_bin_t* bin, size_t new_w, size_t new_h)
 
   size_t total = bin->num_rects;
 
-  nv_skyline_rect_t* valid   = (nv_skyline_rect_t*)nv_zmalloc(total * sizeof(nv_skyline_rect_t));
-  nv_skyline_rect_t* invalid = (nv_skyline_rect_t*)nv_zmalloc(total * sizeof(nv_skyline_rect_t));
+  nv_skyline_rect_t* valid   = (nv_skyline_rect_t*)nv_alloc_zmalloc(bin->alloc, total * sizeof(nv_skyline_rect_t));
+  nv_skyline_rect_t* invalid = (nv_skyline_rect_t*)nv_alloc_zmalloc(bin->alloc, total * sizeof(nv_skyline_rect_t));
   if (!valid || !invalid)
   {
-    nv_free(valid);
-    nv_free(invalid);
+    nv_alloc_free(bin->alloc, valid);
+    nv_alloc_free(bin->alloc, invalid);
     return;
   }
 
@@ -193,12 +200,12 @@ nv_skyline_bin_resize(nv_skyline_bin_t* bin, size_t new_w, size_t new_h)
   // rasize
   if (new_w != bin->width)
   {
-    size_t* skyline = (size_t*)nv_realloc(bin->skyline, new_w * sizeof(*skyline));
+    size_t* skyline = (size_t*)nv_alloc_realloc(bin->alloc, bin->skyline, new_w * sizeof(*skyline));
     if (!skyline)
     {
       nv_log_error("Memory allocation failed for skyline resize\n");
-      nv_free(valid);
-      nv_free(invalid);
+      nv_alloc_free(bin->alloc, valid);
+      nv_alloc_free(bin->alloc, invalid);
       return;
     }
 
@@ -225,7 +232,7 @@ nv_skyline_bin_resize(nv_skyline_bin_t* bin, size_t new_w, size_t new_h)
     }
   }
 
-  nv_free(bin->rects);
+  nv_alloc_free(bin->alloc, bin->rects);
   bin->rects                = valid;
   bin->num_rects            = num_valid;
   bin->allocated_rect_count = num_valid;
@@ -242,7 +249,7 @@ nv_skyline_bin_resize(nv_skyline_bin_t* bin, size_t new_w, size_t new_h)
     nv_skyline_bin_place_rect(bin, &invalid[i], x, y);
   }
 
-  nv_free(invalid);
+  nv_alloc_free(bin->alloc, invalid);
 
   bin->width  = new_w;
   bin->height = new_h;
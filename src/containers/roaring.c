@@ -0,0 +1,1135 @@
+#include "../../include/containers/roaring.h"
+
+#include "../../include/containers/bitset.h"
+#include "../../include/containers/list.h"
+#include "../../include/error.h"
+#include "../../include/stdafx.h"
+#include "../../include/stream.h"
+#include "../../include/string.h"
+#include "../../include/types.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef nv_roaring_container_t container;
+typedef nv_roaring_run_t       run_t;
+
+#define ARRAY_MAX    NV_ROARING_ARRAY_MAX
+#define BITMAP_WORDS NV_ROARING_BITMAP_WORDS
+#define BITMAP_BYTES (BITMAP_WORDS * sizeof(u64))
+#define RUN_MAX      NV_ROARING_RUN_MAX
+#define CHUNK_SIZE   65536U
+
+static const char ROARING_MAGIC[4] = { 'N', 'V', 'R', 'B' };
+
+/* Bitmap containers are operated on through a bitset that borrows their words. */
+static inline nv_bitset_t
+bitmap_view(const void* words)
+{
+  nv_bitset_t view = { .data = (u64*)words, .size = CHUNK_SIZE, .words = BITMAP_WORDS, .alloc = NULL };
+  return view;
+}
+
+static inline u32
+run_end(run_t run)
+{
+  return (u32)run.start + run.length;
+}
+
+static inline size_t
+elem_size(u8 kind)
+{
+  switch (kind)
+  {
+    case NV_ROARING_ARRAY: return sizeof(u16);
+    case NV_ROARING_RUN: return sizeof(run_t);
+    default: return sizeof(u64);
+  }
+}
+
+/* The first index in 'values' whose value is not below 'value'. */
+static inline u32
+array_lower_bound(const u16* values, u32 size, u32 value)
+{
+  u32 lo = 0, hi = size;
+  while (lo < hi)
+  {
+    const u32 mid = (lo + hi) / 2;
+    if (values[mid] < value) { lo = mid + 1; }
+    else { hi = mid; }
+  }
+  return lo;
+}
+
+/* The number of runs starting at or before 'value', the run that may hold 'value' is the one before that. */
+static inline u32
+runs_upper_bound(const run_t* runs, u32 size, u32 value)
+{
+  u32 lo = 0, hi = size;
+  while (lo < hi)
+  {
+    const u32 mid = (lo + hi) / 2;
+    if (runs[mid].start <= value) { lo = mid + 1; }
+    else { hi = mid; }
+  }
+  return lo;
+}
+
+/*
+ * Containers
+ */
+
+static void
+container_free(nv_roaring_t* r, container* c)
+{
+  nv_alloc_free(r->alloc, c->data);
+  c->data        = NULL;
+  c->size        = 0;
+  c->capacity    = 0;
+  c->cardinality = 0;
+}
+
+/* Make room for 'capacity' array values or runs. */
+static nv_error
+container_reserve(nv_roaring_t* r, container* c, u32 capacity)
+{
+  if (capacity <= c->capacity) { return NV_SUCCESS; }
+
+  u32 new_capacity = c->capacity ? c->capacity : 4;
+  while (new_capacity < capacity) { new_capacity *= 2; }
+
+  const size_t bytes = new_capacity * elem_size(c->kind);
+  void*        data  = c->data ? nv_alloc_realloc(r->alloc, c->data, bytes) : nv_alloc_zmalloc(r->alloc, bytes);
+  if (!data) { return NV_ERROR_MALLOC_FAILED; }
+
+  c->data     = data;
+  c->capacity = new_capacity;
+  return NV_SUCCESS;
+}
+
+/* An empty container, bitmaps come zeroed. */
+static nv_error
+container_make(nv_roaring_t* r, u16 key, u8 kind, u32 capacity, container* c)
+{
+  *c      = nv_zinit(container);
+  c->key  = key;
+  c->kind = kind;
+
+  if (kind == NV_ROARING_BITMAP)
+  {
+    c->data     = nv_alloc_zmalloc(r->alloc, BITMAP_BYTES);
+    c->capacity = BITMAP_WORDS;
+    return c->data ? NV_SUCCESS : NV_ERROR_MALLOC_FAILED;
+  }
+  return container_reserve(r, c, capacity ? capacity : 1);
+}
+
+static nv_error
+container_copy(nv_roaring_t* r, const container* src, container* dst)
+{
+  nv_error e = container_make(r, src->key, src->kind, src->size, dst);
+  if (e != NV_SUCCESS) { return e; }
+
+  nv_memcpy(dst->data, src->data, src->kind == NV_ROARING_BITMAP ? BITMAP_BYTES : src->size * elem_size(src->kind));
+  dst->size        = src->size;
+  dst->cardinality = src->cardinality;
+  return NV_SUCCESS;
+}
+
+static bool
+container_contains(const container* c, u32 low)
+{
+  switch (c->kind)
+  {
+    case NV_ROARING_ARRAY:
+    {
+      const u16* values = (const u16*)c->data;
+      const u32  i      = array_lower_bound(values, c->size, low);
+      return i < c->size && values[i] == low;
+    }
+    case NV_ROARING_BITMAP: return (((const u64*)c->data)[low / 64] >> (low % 64)) & 1U;
+    default:
+    {
+      const run_t* runs = (const run_t*)c->data;
+      const u32    i    = runs_upper_bound(runs, c->size, low);
+      return i && low <= run_end(runs[i - 1]);
+    }
+  }
+}
+
+/* Write the values of a container to 'out', which has room for all of them. */
+static u32
+container_values(const container* c, u16* out)
+{
+  u32 n = 0;
+  switch (c->kind)
+  {
+    case NV_ROARING_ARRAY: nv_memcpy(out, c->data, c->size * sizeof(u16)); return c->size;
+    case NV_ROARING_BITMAP:
+    {
+      const nv_bitset_t bits = bitmap_view(c->data);
+      nv_bitset_iter_t  it;
+      size_t            bit;
+      nv_bitset_iter_init(&bits, &it);
+      while (nv_bitset_iter_next(&it, &bit)) { out[n++] = (u16)bit; }
+      return n;
+    }
+    default:
+    {
+      const run_t* runs = (const run_t*)c->data;
+      for (u32 i = 0; i < c->size; i++)
+      {
+        for (u32 v = runs[i].start; v <= run_end(runs[i]); v++) { out[n++] = (u16)v; }
+      }
+      return n;
+    }
+  }
+}
+
+static void
+or_into_bitmap(u64* words, const container* c)
+{
+  nv_bitset_t view = bitmap_view(words);
+  switch (c->kind)
+  {
+    case NV_ROARING_ARRAY:
+    {
+      const u16* values = (const u16*)c->data;
+      for (u32 i = 0; i < c->size; i++) { words[values[i] / 64] |= (u64)1 << (values[i] % 64); }
+      break;
+    }
+    case NV_ROARING_BITMAP:
+    {
+      const nv_bitset_t src = bitmap_view(c->data);
+      nv_bitset_or(&view, &src);
+      break;
+    }
+    default:
+    {
+      const run_t* runs = (const run_t*)c->data;
+      for (u32 i = 0; i < c->size; i++) { nv_bitset_set_range(&view, runs[i].start, (size_t)runs[i].length + 1); }
+      break;
+    }
+  }
+}
+
+/* The number of runs the values of a container make. */
+static u32
+count_runs(const container* c)
+{
+  switch (c->kind)
+  {
+    case NV_ROARING_ARRAY:
+    {
+      const u16* values = (const u16*)c->data;
+      u32        runs   = c->size ? 1 : 0;
+      for (u32 i = 1; i < c->size; i++) { runs += values[i] != values[i - 1] + 1; }
+      return runs;
+    }
+    case NV_ROARING_BITMAP:
+    {
+      // a run starts at every set bit whose lower neighbour is clear.
+      const u64* words = (const u64*)c->data;
+      u64        carry = 0;
+      u32        runs  = 0;
+      for (u32 i = 0; i < BITMAP_WORDS; i++)
+      {
+        runs += (u32)nv_popcount64(words[i] & ~((words[i] << 1U) | carry));
+        carry = words[i] >> 63U;
+      }
+      return runs;
+    }
+    default: return c->size;
+  }
+}
+
+/* Replace the data of 'c' with 'with', which holds the same values in another form. */
+static void
+container_replace(nv_roaring_t* r, container* c, container* with)
+{
+  with->cardinality = c->cardinality;
+  container_free(r, c);
+  *c = *with;
+}
+
+static nv_error
+to_bitmap(nv_roaring_t* r, container* c)
+{
+  container bitmap;
+  nv_error  e = container_make(r, c->key, NV_ROARING_BITMAP, 0, &bitmap);
+  if (e != NV_SUCCESS) { return e; }
+
+  or_into_bitmap((u64*)bitmap.data, c);
+  container_replace(r, c, &bitmap);
+  return NV_SUCCESS;
+}
+
+static nv_error
+to_array(nv_roaring_t* r, container* c)
+{
+  container array;
+  nv_error  e = container_make(r, c->key, NV_ROARING_ARRAY, c->cardinality, &array);
+  if (e != NV_SUCCESS) { return e; }
+
+  array.size = container_values(c, (u16*)array.data);
+  container_replace(r, c, &array);
+  return NV_SUCCESS;
+}
+
+static inline void
+append_run(container* c, u32 start, u32 end)
+{
+  run_t* runs = (run_t*)c->data;
+  if (c->size && start <= run_end(runs[c->size - 1]) + 1)
+  {
+    run_t* last = &runs[c->size - 1];
+    if (end > run_end(*last)) { last->length = (u16)(end - last->start); }
+    return;
+  }
+  runs[c->size++] = (run_t){ .start = (u16)start, .length = (u16)(end - start) };
+}
+
+static nv_error
+to_runs(nv_roaring_t* r, container* c, u32 run_count)
+{
+  container run;
+  nv_error  e = container_make(r, c->key, NV_ROARING_RUN, run_count, &run);
+  if (e != NV_SUCCESS) { return e; }
+
+  if (c->kind == NV_ROARING_ARRAY)
+  {
+    const u16* values = (const u16*)c->data;
+    for (u32 i = 0; i < c->size; i++) { append_run(&run, values[i], values[i]); }
+  }
+  else
+  {
+    const nv_bitset_t bits = bitmap_view(c->data);
+    nv_bitset_iter_t  it;
+    size_t            bit;
+    nv_bitset_iter_init(&bits, &it);
+    while (nv_bitset_iter_next(&it, &bit)) { append_run(&run, (u32)bit, (u32)bit); }
+  }
+
+  container_replace(r, c, &run);
+  return NV_SUCCESS;
+}
+
+/**
+ * Move a container to the form its cardinality calls for after it changed:
+ * run containers with too many runs and bitmaps that fell to ARRAY_MAX values become arrays (or bitmaps),
+ * and full chunks become a single run.
+ */
+static nv_error
+normalize(nv_roaring_t* r, container* c)
+{
+  if (c->cardinality == CHUNK_SIZE && (c->kind != NV_ROARING_RUN || c->size != 1))
+  {
+    container full;
+    nv_error  e = container_make(r, c->key, NV_ROARING_RUN, 1, &full);
+    if (e != NV_SUCCESS) { return e; }
+
+    append_run(&full, 0, CHUNK_SIZE - 1);
+    container_replace(r, c, &full);
+    return NV_SUCCESS;
+  }
+  if (c->kind == NV_ROARING_RUN && c->size > RUN_MAX) { return c->cardinality <= ARRAY_MAX ? to_array(r, c) : to_bitmap(r, c); }
+  if (c->kind == NV_ROARING_BITMAP && c->cardinality <= ARRAY_MAX) { return to_array(r, c); }
+  return NV_SUCCESS;
+}
+
+/* Add the values first .. last (inclusive) to a run container, merging every run they touch. */
+static nv_error
+run_add_range(nv_roaring_t* r, container* c, u32 first, u32 last)
+{
+  run_t* runs = (run_t*)c->data;
+
+  // runs [i, j) touch the range: they end at or after first - 1 and start at or before last + 1.
+  u32 lo = 0, hi = c->size;
+  while (lo < hi)
+  {
+    const u32 mid = (lo + hi) / 2;
+    if (run_end(runs[mid]) + 1 < first) { lo = mid + 1; }
+    else { hi = mid; }
+  }
+  const u32 i = lo;
+  const u32 j = runs_upper_bound(runs, c->size, last + 1);
+
+  if (i >= j)
+  {
+    nv_error e = container_reserve(r, c, c->size + 1);
+    if (e != NV_SUCCESS) { return e; }
+
+    runs = (run_t*)c->data;
+    nv_memmove(runs + i + 1, runs + i, (c->size - i) * sizeof(run_t));
+    runs[i] = (run_t){ .start = (u16)first, .length = (u16)(last - first) };
+    c->size++;
+    c->cardinality += last - first + 1;
+    return NV_SUCCESS;
+  }
+
+  const u32 start   = NV_MIN(first, (u32)runs[i].start);
+  const u32 end     = NV_MAX(last, run_end(runs[j - 1]));
+  u32       covered = 0;
+  for (u32 k = i; k < j; k++) { covered += (u32)runs[k].length + 1; }
+
+  runs[i] = (run_t){ .start = (u16)start, .length = (u16)(end - start) };
+  nv_memmove(runs + i + 1, runs + j, (c->size - j) * sizeof(run_t));
+  c->size -= j - i - 1;
+  c->cardinality += (end - start + 1) - covered;
+  return NV_SUCCESS;
+}
+
+static nv_error
+container_add(nv_roaring_t* r, container* c, u32 low)
+{
+  switch (c->kind)
+  {
+    case NV_ROARING_ARRAY:
+    {
+      u16*      values = (u16*)c->data;
+      const u32 i      = array_lower_bound(values, c->size, low);
+      if (i < c->size && values[i] == low) { return NV_SUCCESS; }
+
+      nv_error e;
+      if (c->size == ARRAY_MAX)
+      {
+        if ((e = to_bitmap(r, c)) != NV_SUCCESS) { return e; }
+        return container_add(r, c, low);
+      }
+      if ((e = container_reserve(r, c, c->size + 1)) != NV_SUCCESS) { return e; }
+
+      values = (u16*)c->data;
+      nv_memmove(values + i + 1, values + i, (c->size - i) * sizeof(u16));
+      values[i] = (u16)low;
+      c->size++;
+      c->cardinality++;
+      return NV_SUCCESS;
+    }
+    case NV_ROARING_BITMAP:
+    {
+      u64*      word = &((u64*)c->data)[low / 64];
+      const u64 bit  = (u64)1 << (low % 64);
+      c->cardinality += (*word & bit) == 0;
+      *word |= bit;
+      return c->cardinality == CHUNK_SIZE ? normalize(r, c) : NV_SUCCESS;
+    }
+    default:
+    {
+      nv_error e = run_add_range(r, c, low, low);
+      return e != NV_SUCCESS ? e : normalize(r, c);
+    }
+  }
+}
+
+static nv_error
+container_add_range(nv_roaring_t* r, container* c, u32 first, u32 last)
+{
+  const u32 count = last - first + 1;
+  nv_error  e     = NV_SUCCESS;
+
+  if (c->kind == NV_ROARING_ARRAY && c->size + count > ARRAY_MAX && (e = to_bitmap(r, c)) != NV_SUCCESS) { return e; }
+
+  switch (c->kind)
+  {
+    case NV_ROARING_ARRAY:
+    {
+      // the values in the range are replaced by all of them, everything after moves up.
+      u16*      values = (u16*)c->data;
+      const u32 i      = array_lower_bound(values, c->size, first);
+      const u32 j      = array_lower_bound(values, c->size, last + 1);
+      const u32 size   = i + count + (c->size - j);
+      if ((e = container_reserve(r, c, size)) != NV_SUCCESS) { return e; }
+
+      values = (u16*)c->data;
+      nv_memmove(values + i + count, values + j, (c->size - j) * sizeof(u16));
+      for (u32 k = 0; k < count; k++) { values[i + k] = (u16)(first + k); }
+      c->size        = size;
+      c->cardinality = size;
+      break;
+    }
+    case NV_ROARING_BITMAP:
+    {
+      nv_bitset_t view = bitmap_view(c->data);
+      nv_bitset_set_range(&view, first, count);
+      c->cardinality = (u32)nv_bitset_popcount(&view);
+      break;
+    }
+    default: e = run_add_range(r, c, first, last); break;
+  }
+
+  return e != NV_SUCCESS ? e : normalize(r, c);
+}
+
+static nv_error
+container_remove(nv_roaring_t* r, container* c, u32 low)
+{
+  switch (c->kind)
+  {
+    case NV_ROARING_ARRAY:
+    {
+      u16*      values = (u16*)c->data;
+      const u32 i      = array_lower_bound(values, c->size, low);
+      if (i == c->size || values[i] != low) { return NV_SUCCESS; }
+
+      nv_memmove(values + i, values + i + 1, (c->size - i - 1) * sizeof(u16));
+      c->size--;
+      c->cardinality--;
+      return NV_SUCCESS;
+    }
+    case NV_ROARING_BITMAP:
+    {
+      u64*      word = &((u64*)c->data)[low / 64];
+      const u64 bit  = (u64)1 << (low % 64);
+      if (!(*word & bit)) { return NV_SUCCESS; }
+
+      *word &= ~bit;
+      c->cardinality--;
+      return normalize(r, c);
+    }
+    default:
+    {
+      run_t*    runs = (run_t*)c->data;
+      const u32 i    = runs_upper_bound(runs, c->size, low);
+      if (!i || low > run_end(runs[i - 1])) { return NV_SUCCESS; }
+
+      const run_t run = runs[i - 1];
+      if (run.length == 0)
+      {
+        nv_memmove(runs + i - 1, runs + i, (c->size - i) * sizeof(run_t));
+        c->size--;
+      }
+      else if (low == run.start) { runs[i - 1] = (run_t){ .start = (u16)(run.start + 1), .length = (u16)(run.length - 1) }; }
+      else if (low == run_end(run)) { runs[i - 1].length--; }
+      else
+      {
+        // split in two around 'low'.
+        nv_error e = container_reserve(r, c, c->size + 1);
+        if (e != NV_SUCCESS) { return e; }
+
+        runs = (run_t*)c->data;
+        nv_memmove(runs + i + 1, runs + i, (c->size - i) * sizeof(run_t));
+        runs[i - 1].length = (u16)(low - run.start - 1);
+        runs[i]            = (run_t){ .start = (u16)(low + 1), .length = (u16)(run_end(run) - low - 1) };
+        c->size++;
+      }
+      c->cardinality--;
+      return normalize(r, c);
+    }
+  }
+}
+
+/*
+ * Container set operations. 'out' is always a new container, an empty result has a cardinality of 0.
+ */
+
+static nv_error
+union_runs(nv_roaring_t* r, const container* x, const container* y, container* out)
+{
+  nv_error e = container_make(r, x->key, NV_ROARING_RUN, x->size + y->size, out);
+  if (e != NV_SUCCESS) { return e; }
+
+  const run_t* xr = (const run_t*)x->data;
+  const run_t* yr = (const run_t*)y->data;
+  u32          i = 0, j = 0;
+  while (i < x->size || j < y->size)
+  {
+    const run_t next = (j == y->size || (i < x->size && xr[i].start <= yr[j].start)) ? xr[i++] : yr[j++];
+    append_run(out, next.start, run_end(next));
+  }
+
+  const run_t* runs = (const run_t*)out->data;
+  for (u32 k = 0; k < out->size; k++) { out->cardinality += (u32)runs[k].length + 1; }
+  return normalize(r, out);
+}
+
+static nv_error
+container_union(nv_roaring_t* r, const container* x, const container* y, container* out)
+{
+  if (x->kind == NV_ROARING_RUN && y->kind == NV_ROARING_RUN) { return union_runs(r, x, y, out); }
+  if (x->cardinality == CHUNK_SIZE) { return container_copy(r, x, out); }
+  if (y->cardinality == CHUNK_SIZE) { return container_copy(r, y, out); }
+
+  nv_error e;
+  if (x->kind == NV_ROARING_BITMAP || y->kind == NV_ROARING_BITMAP || x->cardinality + y->cardinality > ARRAY_MAX)
+  {
+    if ((e = container_make(r, x->key, NV_ROARING_BITMAP, 0, out)) != NV_SUCCESS) { return e; }
+
+    or_into_bitmap((u64*)out->data, x);
+    or_into_bitmap((u64*)out->data, y);
+    const nv_bitset_t view = bitmap_view(out->data);
+    out->cardinality       = (u32)nv_bitset_popcount(&view);
+    return normalize(r, out);
+  }
+
+  // both fit in an array together, merge them as sorted arrays.
+  u16        xs[ARRAY_MAX], ys[ARRAY_MAX];
+  const u16* xv = x->kind == NV_ROARING_ARRAY ? (const u16*)x->data : xs;
+  const u16* yv = y->kind == NV_ROARING_ARRAY ? (const u16*)y->data : ys;
+  if (x->kind != NV_ROARING_ARRAY) { container_values(x, xs); }
+  if (y->kind != NV_ROARING_ARRAY) { container_values(y, ys); }
+
+  if ((e = container_make(r, x->key, NV_ROARING_ARRAY, x->cardinality + y->cardinality, out)) != NV_SUCCESS) { return e; }
+
+  u16* values = (u16*)out->data;
+  u32  i = 0, j = 0, n = 0;
+  while (i < x->cardinality && j < y->cardinality)
+  {
+    const u16 a = xv[i], b = yv[j];
+    values[n++] = a < b ? a : b;
+    i += a <= b;
+    j += b <= a;
+  }
+  while (i < x->cardinality) { values[n++] = xv[i++]; }
+  while (j < y->cardinality) { values[n++] = yv[j++]; }
+
+  out->size        = n;
+  out->cardinality = n;
+  return NV_SUCCESS;
+}
+
+static nv_error
+intersect_runs(nv_roaring_t* r, const container* x, const container* y, container* out)
+{
+  nv_error e = container_make(r, x->key, NV_ROARING_RUN, x->size + y->size, out);
+  if (e != NV_SUCCESS) { return e; }
+
+  const run_t* xr = (const run_t*)x->data;
+  const run_t* yr = (const run_t*)y->data;
+  u32          i = 0, j = 0;
+  while (i < x->size && j < y->size)
+  {
+    const u32 start = NV_MAX((u32)xr[i].start, (u32)yr[j].start);
+    const u32 end   = NV_MIN(run_end(xr[i]), run_end(yr[j]));
+    if (start <= end)
+    {
+      append_run(out, start, end);
+      out->cardinality += end - start + 1;
+    }
+    if (run_end(xr[i]) < run_end(yr[j])) { i++; }
+    else { j++; }
+  }
+  return normalize(r, out);
+}
+
+static nv_error
+container_intersection(nv_roaring_t* r, const container* x, const container* y, container* out)
+{
+  if (x->kind == NV_ROARING_RUN && y->kind == NV_ROARING_RUN) { return intersect_runs(r, x, y, out); }
+
+  nv_error e;
+  if (x->kind == NV_ROARING_ARRAY && y->kind == NV_ROARING_ARRAY && x->size < 32 * y->size && y->size < 32 * x->size)
+  {
+    // similar sizes: one merging pass is cheaper than a binary search per value.
+    if ((e = container_make(r, x->key, NV_ROARING_ARRAY, NV_MIN(x->size, y->size), out)) != NV_SUCCESS) { return e; }
+
+    const u16* xv   = (const u16*)x->data;
+    const u16* yv   = (const u16*)y->data;
+    u16*       kept = (u16*)out->data;
+    u32        i = 0, j = 0;
+    while (i < x->size && j < y->size)
+    {
+      const u16 a = xv[i], b = yv[j];
+      kept[out->size] = a;
+      out->size += a == b;
+      i += a <= b;
+      j += b <= a;
+    }
+    out->cardinality = out->size;
+    return NV_SUCCESS;
+  }
+  if (x->kind == NV_ROARING_ARRAY || y->kind == NV_ROARING_ARRAY)
+  {
+    // probe the other container with every value of the (smaller) array.
+    const bool       x_probes = x->kind == NV_ROARING_ARRAY && (y->kind != NV_ROARING_ARRAY || x->size <= y->size);
+    const container* probe    = x_probes ? x : y;
+    const container* other    = x_probes ? y : x;
+    if ((e = container_make(r, x->key, NV_ROARING_ARRAY, probe->size, out)) != NV_SUCCESS) { return e; }
+
+    const u16* values = (const u16*)probe->data;
+    u16*       kept   = (u16*)out->data;
+    for (u32 i = 0; i < probe->size; i++)
+    {
+      kept[out->size] = values[i];
+      out->size += container_contains(other, values[i]);
+    }
+    out->cardinality = out->size;
+    return NV_SUCCESS;
+  }
+
+  // bitmap and bitmap, or bitmap and run.
+  if ((e = container_make(r, x->key, NV_ROARING_BITMAP, 0, out)) != NV_SUCCESS) { return e; }
+  or_into_bitmap((u64*)out->data, x);
+
+  nv_bitset_t view = bitmap_view(out->data);
+  if (y->kind == NV_ROARING_BITMAP)
+  {
+    const nv_bitset_t other = bitmap_view(y->data);
+    nv_bitset_and(&view, &other);
+  }
+  else
+  {
+    u64 mask[BITMAP_WORDS] = { 0 };
+    or_into_bitmap(mask, y);
+    const nv_bitset_t other = bitmap_view(mask);
+    nv_bitset_and(&view, &other);
+  }
+
+  out->cardinality = (u32)nv_bitset_popcount(&view);
+  return normalize(r, out);
+}
+
+/*
+ * The container array
+ */
+
+/* The index of the container for 'key', or where it would go. */
+static size_t
+find_container(const nv_roaring_t* r, u16 key)
+{
+  size_t lo = 0, hi = r->size;
+  while (lo < hi)
+  {
+    const size_t mid = (lo + hi) / 2;
+    if (r->containers[mid].key < key) { lo = mid + 1; }
+    else { hi = mid; }
+  }
+  return lo;
+}
+
+static nv_error
+reserve_containers(nv_roaring_t* r, size_t capacity)
+{
+  if (capacity <= r->capacity) { return NV_SUCCESS; }
+
+  size_t new_capacity = r->capacity ? r->capacity : 4;
+  while (new_capacity < capacity) { new_capacity *= 2; }
+
+  const size_t bytes      = new_capacity * sizeof(container);
+  container*   containers = r->containers ? nv_alloc_realloc(r->alloc, r->containers, bytes) : nv_alloc_zmalloc(r->alloc, bytes);
+  if (!containers) { return NV_ERROR_MALLOC_FAILED; }
+
+  r->containers = containers;
+  r->capacity   = new_capacity;
+  return NV_SUCCESS;
+}
+
+/* Takes ownership of 'c' on success. */
+static nv_error
+insert_container(nv_roaring_t* r, size_t index, const container* c)
+{
+  nv_error e = reserve_containers(r, r->size + 1);
+  if (e != NV_SUCCESS) { return e; }
+
+  nv_memmove(r->containers + index + 1, r->containers + index, (r->size - index) * sizeof(container));
+  r->containers[index] = *c;
+  r->size++;
+  return NV_SUCCESS;
+}
+
+static void
+erase_container(nv_roaring_t* r, size_t index)
+{
+  container_free(r, &r->containers[index]);
+  nv_memmove(r->containers + index, r->containers + index + 1, (r->size - index - 1) * sizeof(container));
+  r->size--;
+}
+
+/* Append a result container to 'out', dropping it if it is empty. */
+static nv_error
+emit(nv_roaring_t* out, nv_error e, container* c)
+{
+  if (e != NV_SUCCESS) { return e; }
+  if (c->cardinality == 0)
+  {
+    container_free(out, c);
+    return NV_SUCCESS;
+  }
+  if ((e = insert_container(out, out->size, c)) != NV_SUCCESS) { container_free(out, c); }
+  return e;
+}
+
+/*
+ * Public
+ */
+
+nv_error
+nv_roaring_init(nv_roaring_t* r)
+{
+  return nv_roaring_init_with_allocator(NULL, r);
+}
+
+nv_error
+nv_roaring_init_with_allocator(nv_allocator_t* allocator, nv_roaring_t* r)
+{
+  nv_assert_else_return(r != NULL, NV_ERROR_INVALID_ARG);
+
+  *r       = nv_zinit(nv_roaring_t);
+  r->alloc = allocator ? allocator : nv_alloc_current;
+  return NV_SUCCESS;
+}
+
+void
+nv_roaring_clear(nv_roaring_t* r)
+{
+  if (!r) { return; }
+  for (size_t i = 0; i < r->size; i++) { container_free(r, &r->containers[i]); }
+  r->size = 0;
+}
+
+void
+nv_roaring_destroy(nv_roaring_t* r)
+{
+  if (!r) { return; }
+
+  nv_roaring_clear(r);
+  nv_alloc_free(r->alloc, r->containers);
+
+  nv_bzero(r, sizeof(nv_roaring_t));
+}
+
+nv_error
+nv_roaring_add(nv_roaring_t* r, u32 value)
+{
+  nv_assert_else_return(r != NULL, NV_ERROR_INVALID_ARG);
+
+  const u16 key = (u16)(value >> 16U);
+  size_t    i   = find_container(r, key);
+  if (i == r->size || r->containers[i].key != key)
+  {
+    container c;
+    nv_error  e = container_make(r, key, NV_ROARING_ARRAY, 4, &c);
+    if (e == NV_SUCCESS && (e = insert_container(r, i, &c)) != NV_SUCCESS) { container_free(r, &c); }
+    if (e != NV_SUCCESS) { return e; }
+  }
+
+  return container_add(r, &r->containers[i], value & 0xFFFFU);
+}
+
+nv_error
+nv_roaring_add_range(nv_roaring_t* r, u32 first, u64 count)
+{
+  nv_assert_else_return(r != NULL, NV_ERROR_INVALID_ARG);
+  if (count == 0) { return NV_SUCCESS; }
+
+  const u64 last = NV_MIN((u64)first + count - 1, (u64)UINT32_MAX);
+  for (u64 value = first; value <= last;)
+  {
+    const u16 key  = (u16)(value >> 16U);
+    const u64 stop = NV_MIN(last, ((u64)key << 16U) | 0xFFFFU);
+    const u32 lo   = (u32)(value & 0xFFFFU);
+    const u32 hi   = (u32)(stop & 0xFFFFU);
+
+    nv_error     e = NV_SUCCESS;
+    const size_t i = find_container(r, key);
+    if (i == r->size || r->containers[i].key != key)
+    {
+      container c;
+      if ((e = container_make(r, key, NV_ROARING_RUN, 1, &c)) == NV_SUCCESS)
+      {
+        append_run(&c, lo, hi);
+        c.cardinality = hi - lo + 1;
+        if ((e = insert_container(r, i, &c)) != NV_SUCCESS) { container_free(r, &c); }
+      }
+    }
+    else { e = container_add_range(r, &r->containers[i], lo, hi); }
+
+    if (e != NV_SUCCESS) { return e; }
+    value = stop + 1;
+  }
+  return NV_SUCCESS;
+}
+
+nv_error
+nv_roaring_remove(nv_roaring_t* r, u32 value)
+{
+  nv_assert_else_return(r != NULL, NV_ERROR_INVALID_ARG);
+
+  const u16    key = (u16)(value >> 16U);
+  const size_t i   = find_container(r, key);
+  if (i == r->size || r->containers[i].key != key) { return NV_SUCCESS; }
+
+  nv_error e = container_remove(r, &r->containers[i], value & 0xFFFFU);
+  if (r->containers[i].cardinality == 0) { erase_container(r, i); }
+  return e;
+}
+
+bool
+nv_roaring_contains(const nv_roaring_t* r, u32 value)
+{
+  nv_assert_else_return(r != NULL, false);
+
+  const u16    key = (u16)(value >> 16U);
+  const size_t i   = find_container(r, key);
+  return i < r->size && r->containers[i].key == key && container_contains(&r->containers[i], value & 0xFFFFU);
+}
+
+u64
+nv_roaring_cardinality(const nv_roaring_t* r)
+{
+  nv_assert_else_return(r != NULL, 0);
+
+  u64 cardinality = 0;
+  for (size_t i = 0; i < r->size; i++) { cardinality += r->containers[i].cardinality; }
+  return cardinality;
+}
+
+static nv_error
+check_args(const nv_roaring_t* a, const nv_roaring_t* b, const nv_roaring_t* out)
+{
+  nv_assert_else_return(a != NULL && b != NULL && out != NULL && out->alloc != NULL, NV_ERROR_INVALID_ARG);
+  nv_assert_else_return(out != a && out != b, NV_ERROR_INVALID_ARG);
+  return NV_SUCCESS;
+}
+
+nv_error
+nv_roaring_union(const nv_roaring_t* a, const nv_roaring_t* b, nv_roaring_t* out)
+{
+  nv_error e = check_args(a, b, out);
+  if (e != NV_SUCCESS) { return e; }
+
+  nv_roaring_clear(out);
+  if ((e = reserve_containers(out, a->size + b->size)) != NV_SUCCESS) { return e; }
+
+  size_t i = 0, j = 0;
+  while (e == NV_SUCCESS && (i < a->size || j < b->size))
+  {
+    const container* x = i < a->size ? &a->containers[i] : NULL;
+    const container* y = j < b->size ? &b->containers[j] : NULL;
+    container        c;
+
+    if (x && (!y || x->key < y->key)) { e = container_copy(out, x, &c), i++; }
+    else if (!x || y->key < x->key) { e = container_copy(out, y, &c), j++; }
+    else { e = container_union(out, x, y, &c), i++, j++; }
+
+    e = emit(out, e, &c);
+  }
+
+  if (e != NV_SUCCESS) { nv_roaring_clear(out); }
+  return e;
+}
+
+nv_error
+nv_roaring_intersection(const nv_roaring_t* a, const nv_roaring_t* b, nv_roaring_t* out)
+{
+  nv_error e = check_args(a, b, out);
+  if (e != NV_SUCCESS) { return e; }
+
+  nv_roaring_clear(out);
+
+  size_t i = 0, j = 0;
+  while (e == NV_SUCCESS && i < a->size && j < b->size)
+  {
+    const container* x = &a->containers[i];
+    const container* y = &b->containers[j];
+    container        c;
+
+    if (x->key < y->key) { i++; }
+    else if (y->key < x->key) { j++; }
+    else
+    {
+      e = emit(out, container_intersection(out, x, y, &c), &c);
+      i++, j++;
+    }
+  }
+
+  if (e != NV_SUCCESS) { nv_roaring_clear(out); }
+  return e;
+}
+
+nv_error
+nv_roaring_run_optimize(nv_roaring_t* r)
+{
+  nv_assert_else_return(r != NULL, NV_ERROR_INVALID_ARG);
+
+  for (size_t i = 0; i < r->size; i++)
+  {
+    container*   c          = &r->containers[i];
+    const u32    runs       = count_runs(c);
+    const size_t run_bytes  = runs * sizeof(run_t);
+    const size_t else_bytes = c->cardinality <= ARRAY_MAX ? c->cardinality * sizeof(u16) : BITMAP_BYTES;
+
+    nv_error e = NV_SUCCESS;
+    if (c->kind != NV_ROARING_RUN && run_bytes < else_bytes) { e = to_runs(r, c, runs); }
+    else if (c->kind == NV_ROARING_RUN && run_bytes >= else_bytes) { e = c->cardinality <= ARRAY_MAX ? to_array(r, c) : to_bitmap(r, c); }
+    if (e != NV_SUCCESS) { return e; }
+  }
+  return NV_SUCCESS;
+}
+
+nv_error
+nv_roaring_to_list(const nv_roaring_t* r, nv_list_t* out)
+{
+  nv_assert_else_return(r != NULL, NV_ERROR_INVALID_ARG);
+  nv_assert_else_return(NOVA_CONT_IS_VALID(out) && out->type_size == sizeof(u32), NV_ERROR_INVALID_ARG);
+
+  const u64 cardinality = nv_roaring_cardinality(r);
+  nv_assert_else_return(cardinality <= SIZE_MAX / sizeof(u32), NV_ERROR_TOO_BIG);
+
+  nv_list_clear(out);
+  nv_list_reserve(out, (size_t)cardinality);
+  if (out->capacity < cardinality) { return NV_ERROR_MALLOC_FAILED; }
+
+  u32* values = (u32*)out->data;
+  for (size_t i = 0; i < r->size; i++)
+  {
+    const container* c    = &r->containers[i];
+    const u32        high = (u32)c->key << 16U;
+    switch (c->kind)
+    {
+      case NV_ROARING_ARRAY:
+      {
+        const u16* low = (const u16*)c->data;
+        for (u32 k = 0; k < c->size; k++) { values[out->size++] = high | low[k]; }
+        break;
+      }
+      case NV_ROARING_BITMAP:
+      {
+        const nv_bitset_t bits = bitmap_view(c->data);
+        nv_bitset_iter_t  it;
+        size_t            bit;
+        nv_bitset_iter_init(&bits, &it);
+        while (nv_bitset_iter_next(&it, &bit)) { values[out->size++] = high | (u32)bit; }
+        break;
+      }
+      default:
+      {
+        const run_t* runs = (const run_t*)c->data;
+        for (u32 k = 0; k < c->size; k++)
+        {
+          for (u32 v = runs[k].start; v <= run_end(runs[k]); v++) { values[out->size++] = high | v; }
+        }
+        break;
+      }
+    }
+  }
+  return NV_SUCCESS;
+}
+
+/*
+ * Serialization
+ */
+
+static inline bool
+write_all(nv_stream_t* stream, const void* data, size_t size)
+{
+  return nv_stream_write(data, size, stream) == size;
+}
+
+static inline bool
+read_all(nv_stream_t* stream, void* buffer, size_t size)
+{
+  return nv_stream_read(buffer, size, stream) == size;
+}
+
+static inline size_t
+data_bytes(const container* c)
+{
+  return c->kind == NV_ROARING_BITMAP ? BITMAP_BYTES : c->size * elem_size(c->kind);
+}
+
+nv_error
+nv_roaring_serialize(const nv_roaring_t* r, nv_stream_t* stream)
+{
+  nv_assert_else_return(r != NULL && stream != NULL, NV_ERROR_INVALID_ARG);
+
+  const u8  version = NV_ROARING_FORMAT_VERSION;
+  const u32 count   = (u32)r->size;
+
+  bool ok = write_all(stream, ROARING_MAGIC, sizeof(ROARING_MAGIC)) && write_all(stream, &version, 1) && write_all(stream, &count, sizeof(count));
+  for (size_t i = 0; ok && i < r->size; i++)
+  {
+    const container* c = &r->containers[i];
+    ok = write_all(stream, &c->key, sizeof(c->key)) && write_all(stream, &c->kind, sizeof(c->kind)) && write_all(stream, &c->size, sizeof(c->size))
+         && write_all(stream, c->data, data_bytes(c));
+  }
+  return ok ? NV_SUCCESS : NV_ERROR_IO_ERROR;
+}
+
+/* Check a container read from a stream and work out its cardinality. */
+static bool
+validate(container* c)
+{
+  switch (c->kind)
+  {
+    case NV_ROARING_ARRAY:
+    {
+      const u16* values = (const u16*)c->data;
+      for (u32 i = 1; i < c->size; i++)
+      {
+        if (values[i] <= values[i - 1]) { return false; }
+      }
+      c->cardinality = c->size;
+      return true;
+    }
+    case NV_ROARING_BITMAP:
+    {
+      const nv_bitset_t view = bitmap_view(c->data);
+      c->cardinality         = (u32)nv_bitset_popcount(&view);
+      return c->cardinality != 0;
+    }
+    default:
+    {
+      // sorted, and neither overlapping nor touching (they would have been merged).
+      const run_t* runs = (const run_t*)c->data;
+      for (u32 i = 0; i < c->size; i++)
+      {
+        if (run_end(runs[i]) >= CHUNK_SIZE || (i && runs[i].start <= run_end(runs[i - 1]) + 1)) { return false; }
+        c->cardinality += (u32)runs[i].length + 1;
+      }
+      return true;
+    }
+  }
+}
+
+static nv_error
+read_container(nv_roaring_t* r, nv_stream_t* stream, int previous_key, container* c)
+{
+  u16 key;
+  u8  kind;
+  u32 size;
+  if (!read_all(stream, &key, sizeof(key)) || !read_all(stream, &kind, sizeof(kind)) || !read_all(stream, &size, sizeof(size))) { return NV_ERROR_INVALID_INPUT; }
+
+  if ((int)key <= previous_key || kind > NV_ROARING_RUN) { return NV_ERROR_INVALID_INPUT; }
+  if (kind == NV_ROARING_ARRAY && (size == 0 || size > ARRAY_MAX)) { return NV_ERROR_INVALID_INPUT; }
+  if (kind == NV_ROARING_RUN && (size == 0 || size > CHUNK_SIZE / 2)) { return NV_ERROR_INVALID_INPUT; }
+
+  nv_error e = container_make(r, key, kind, size, c);
+  if (e != NV_SUCCESS) { return e; }
+
+  c->size = kind == NV_ROARING_BITMAP ? 0 : size;
+  if (!read_all(stream, c->data, data_bytes(c)) || !validate(c))
+  {
+    container_free(r, c);
+    return NV_ERROR_INVALID_INPUT;
+  }
+  if ((e = normalize(r, c)) != NV_SUCCESS) { container_free(r, c); }
+  return e;
+}
+
+nv_error
+nv_roaring_deserialize(nv_stream_t* stream, nv_allocator_t* allocator, nv_roaring_t* r)
+{
+  nv_assert_else_return(stream != NULL, NV_ERROR_INVALID_ARG);
+
+  nv_error e = nv_roaring_init_with_allocator(allocator, r);
+  if (e != NV_SUCCESS) { return e; }
+
+  char magic[sizeof(ROARING_MAGIC)];
+  u8   version;
+  u32  count;
+  if (!read_all(stream, magic, sizeof(magic)) || nv_memcmp(magic, ROARING_MAGIC, sizeof(magic)) != 0) { return NV_ERROR_INVALID_INPUT; }
+  if (!read_all(stream, &version, 1) || version != NV_ROARING_FORMAT_VERSION) { return NV_ERROR_INVALID_INPUT; }
+  if (!read_all(stream, &count, sizeof(count)) || count > CHUNK_SIZE) { return NV_ERROR_INVALID_INPUT; }
+  if ((e = reserve_containers(r, count)) != NV_SUCCESS) { return e; }
+
+  for (u32 i = 0; e == NV_SUCCESS && i < count; i++)
+  {
+    container c;
+    e = read_container(r, stream, i ? (int)r->containers[r->size - 1].key : -1, &c);
+    if (e == NV_SUCCESS) { e = insert_container(r, r->size, &c); }
+  }
+
+  if (e != NV_SUCCESS) { nv_roaring_clear(r); }
+  return e;
+}
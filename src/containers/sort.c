@@ -0,0 +1,736 @@
+#include "../../include/containers/sort.h"
+
+#include "../../include/alloc.h"
+#include "../../include/containers/list.h"
+#include "../../include/cpu.h"
+#include "../../include/error.h"
+#include "../../include/hash.h"
+#include "../../include/stdafx.h"
+#include "../../include/string.h"
+#include "../../include/types.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if NV_CPU_X86_SIMD
+#  include <immintrin.h>
+#endif
+
+/*
+ * Generic introsort, used by nv_sort() and nv_list_sort().
+ * The element size is only known at runtime, so the pivot is kept in place at data[0] instead of being copied out.
+ */
+
+static inline void
+swap_bytes(uchar* NV_RESTRICT a, uchar* NV_RESTRICT b, size_t size)
+{
+  while (size >= sizeof(u64))
+  {
+    u64 ta, tb;
+    nv_memcpy_small(&ta, a, sizeof(u64));
+    nv_memcpy_small(&tb, b, sizeof(u64));
+    nv_memcpy_small(a, &tb, sizeof(u64));
+    nv_memcpy_small(b, &ta, sizeof(u64));
+    a += sizeof(u64), b += sizeof(u64), size -= sizeof(u64);
+  }
+  while (size--)
+  {
+    uchar t = *a;
+    *a++    = *b;
+    *b++    = t;
+  }
+}
+
+typedef struct generic_sort
+{
+  size_t        size;
+  nv_compare_fn compare;
+  void*         user_data;
+} generic_sort;
+
+#define AT(i) (data + ((i) * s->size))
+#define LESS(a, b) (s->compare((a), (b), s->size, s->user_data) < 0)
+
+static void
+generic_insertion(const generic_sort* s, uchar* data, size_t count)
+{
+  for (size_t i = 1; i < count; i++)
+  {
+    for (size_t j = i; j > 0 && LESS(AT(j), AT(j - 1)); j--) { swap_bytes(AT(j), AT(j - 1), s->size); }
+  }
+}
+
+static void
+generic_sift_down(const generic_sort* s, uchar* data, size_t root, size_t count)
+{
+  for (;;)
+  {
+    size_t child = (2 * root) + 1;
+    if (child >= count) { break; }
+    if (child + 1 < count && LESS(AT(child), AT(child + 1))) { child++; }
+    if (!LESS(AT(root), AT(child))) { break; }
+    swap_bytes(AT(root), AT(child), s->size);
+    root = child;
+  }
+}
+
+static void
+generic_heapsort(const generic_sort* s, uchar* data, size_t count)
+{
+  for (size_t i = count / 2; i-- > 0;) { generic_sift_down(s, data, i, count); }
+  for (size_t i = count; i-- > 1;)
+  {
+    swap_bytes(AT(0), AT(i), s->size);
+    generic_sift_down(s, data, 0, i);
+  }
+}
+
+/* Partition around a median of three. Returns the pivot's final index j: [0, j) <= pivot, (j, count) >= pivot. */
+static size_t
+generic_partition(const generic_sort* s, uchar* data, size_t count)
+{
+  // median of three, the last element ends up >= the pivot and stops the forward scan.
+  const size_t mid = count / 2;
+  if (LESS(AT(mid), AT(0))) { swap_bytes(AT(mid), AT(0), s->size); }
+  if (LESS(AT(count - 1), AT(mid))) { swap_bytes(AT(count - 1), AT(mid), s->size); }
+  if (LESS(AT(mid), AT(0))) { swap_bytes(AT(mid), AT(0), s->size); }
+  swap_bytes(AT(0), AT(mid), s->size);
+
+  size_t i = 0;
+  size_t j = count;
+  for (;;)
+  {
+    do { i++; } while (LESS(AT(i), AT(0)));
+    do { j--; } while (LESS(AT(0), AT(j)));
+    if (i >= j) { break; }
+    swap_bytes(AT(i), AT(j), s->size);
+  }
+  swap_bytes(AT(0), AT(j), s->size);
+  return j;
+}
+
+static void
+generic_introsort(const generic_sort* s, uchar* data, size_t count, size_t depth)
+{
+  while (count > NV_SORT_INSERTION_THRESHOLD)
+  {
+    if (depth-- == 0)
+    {
+      generic_heapsort(s, data, count);
+      return;
+    }
+
+    const size_t j     = generic_partition(s, data, count);
+    const size_t right = count - j - 1;
+    if (j < right)
+    {
+      generic_introsort(s, data, j, depth);
+      data += (j + 1) * s->size;
+      count = right;
+    }
+    else
+    {
+      generic_introsort(s, AT(j + 1), right, depth);
+      count = j;
+    }
+  }
+  generic_insertion(s, data, count);
+}
+
+static void
+generic_select(const generic_sort* s, uchar* data, size_t count, size_t nth, size_t depth)
+{
+  while (count > NV_SORT_INSERTION_THRESHOLD)
+  {
+    if (depth-- == 0)
+    {
+      generic_heapsort(s, data, count);
+      return;
+    }
+
+    const size_t j = generic_partition(s, data, count);
+    if (nth == j) { return; }
+    if (nth < j) { count = j; }
+    else
+    {
+      data += (j + 1) * s->size;
+      count -= j + 1;
+      nth -= j + 1;
+    }
+  }
+  generic_insertion(s, data, count);
+}
+
+/*
+ * Bounded heap for top k.
+ * A min heap (by 'compare') of the best k elements seen so far, so its root is the one to beat.
+ */
+
+static void
+generic_sift_down_min(const generic_sort* s, uchar* data, size_t root, size_t count)
+{
+  for (;;)
+  {
+    size_t child = (2 * root) + 1;
+    if (child >= count) { break; }
+    if (child + 1 < count && LESS(AT(child + 1), AT(child))) { child++; }
+    if (!LESS(AT(child), AT(root))) { break; }
+    swap_bytes(AT(root), AT(child), s->size);
+    root = child;
+  }
+}
+
+static void
+generic_top_k(const generic_sort* s, const uchar* src, size_t count, uchar* data, size_t k)
+{
+  nv_memcpy(data, src, k * s->size);
+  for (size_t i = k / 2; i-- > 0;) { generic_sift_down_min(s, data, i, k); }
+
+  for (size_t i = k; i < count; i++)
+  {
+    const uchar* elem = src + (i * s->size);
+    if (LESS(AT(0), elem))
+    {
+      nv_memcpy_small(AT(0), elem, s->size);
+      generic_sift_down_min(s, data, 0, k);
+    }
+  }
+
+  // popping the min to the back leaves the heap sorted best first
+  for (size_t i = k; i-- > 1;)
+  {
+    swap_bytes(AT(0), AT(i), s->size);
+    generic_sift_down_min(s, data, 0, i);
+  }
+}
+
+#undef AT
+#undef LESS
+
+void
+nv_sort(void* data, size_t count, size_t size, nv_compare_fn compare, void* user_data)
+{
+  nv_assert_else_return(data != NULL || count == 0, );
+  nv_assert_else_return(size > 0, );
+
+  generic_sort s = { size, compare ? compare : (nv_compare_fn)nv_compare_default, user_data };
+
+  size_t depth = 0;
+  for (size_t n = count; n > 1; n >>= 1U) { depth += 2; }
+  generic_introsort(&s, (uchar*)data, count, depth);
+}
+
+void
+nv_nth_element(void* data, size_t count, size_t size, size_t nth, nv_compare_fn compare, void* user_data)
+{
+  nv_assert_else_return(data != NULL || count == 0, );
+  nv_assert_else_return(size > 0, );
+  if (nth >= count) { return; }
+
+  generic_sort s = { size, compare ? compare : (nv_compare_fn)nv_compare_default, user_data };
+
+  size_t depth = 0;
+  for (size_t n = count; n > 1; n >>= 1U) { depth += 2; }
+  generic_select(&s, (uchar*)data, count, nth, depth);
+}
+
+nv_error
+nv_list_nth_element(nv_list_t* list, size_t nth, nv_compare_fn compare, void* user_data)
+{
+  nv_assert_else_return(NOVA_CONT_IS_VALID(list), NV_ERROR_INVALID_ARG);
+  nv_assert_else_return(nth < list->size, NV_ERROR_INVALID_ARG);
+
+  nv_nth_element(list->data, list->size, list->type_size, nth, compare, user_data);
+  return NV_SUCCESS;
+}
+
+nv_error
+nv_list_top_k(const nv_list_t* list, size_t k, nv_compare_fn compare, void* user_data, nv_list_t* out)
+{
+  nv_assert_else_return(NOVA_CONT_IS_VALID(list), NV_ERROR_INVALID_ARG);
+  nv_assert_else_return(NOVA_CONT_IS_VALID(out), NV_ERROR_INVALID_ARG);
+  nv_assert_else_return(list != out && list->type_size == out->type_size, NV_ERROR_INVALID_ARG);
+
+  k = NV_MIN(k, list->size);
+  nv_list_clear(out);
+  if (k == 0) { return NV_SUCCESS; }
+
+  nv_list_reserve(out, k);
+  if (out->capacity < k) { return NV_ERROR_MALLOC_FAILED; }
+
+  generic_sort s = { list->type_size, compare ? compare : (nv_compare_fn)nv_compare_default, user_data };
+  generic_top_k(&s, (const uchar*)list->data, list->size, (uchar*)out->data, k);
+  out->size = k;
+  return NV_SUCCESS;
+}
+
+/*
+ * LSD radix sort.
+ * Keys are mapped to unsigned integers that sort in the same order, sorted a byte at a time, then mapped back.
+ */
+
+static inline size_t
+key_width(nv_sort_key key)
+{
+  switch (key)
+  {
+    case NV_SORT_KEY_U32:
+    case NV_SORT_KEY_I32:
+    case NV_SORT_KEY_F32: return 4;
+    case NV_SORT_KEY_U64:
+    case NV_SORT_KEY_I64:
+    case NV_SORT_KEY_F64: return 8;
+  }
+  return 0;
+}
+
+static inline u64
+key_to_radix(u64 bits, nv_sort_key key)
+{
+  switch (key)
+  {
+    case NV_SORT_KEY_U32:
+    case NV_SORT_KEY_U64: return bits;
+    case NV_SORT_KEY_I32: return bits ^ 0x80000000ULL;
+    case NV_SORT_KEY_I64: return bits ^ 0x8000000000000000ULL;
+    // negative floats have every bit flipped so that they sort backwards, positive ones only the sign bit.
+    case NV_SORT_KEY_F32: return bits ^ ((bits & 0x80000000ULL) ? 0xFFFFFFFFULL : 0x80000000ULL);
+    case NV_SORT_KEY_F64: return bits ^ ((bits & 0x8000000000000000ULL) ? 0xFFFFFFFFFFFFFFFFULL : 0x8000000000000000ULL);
+  }
+  return bits;
+}
+
+static inline u64
+radix_to_key(u64 bits, nv_sort_key key)
+{
+  switch (key)
+  {
+    case NV_SORT_KEY_U32:
+    case NV_SORT_KEY_U64: return bits;
+    case NV_SORT_KEY_I32: return bits ^ 0x80000000ULL;
+    case NV_SORT_KEY_I64: return bits ^ 0x8000000000000000ULL;
+    case NV_SORT_KEY_F32: return bits ^ ((bits & 0x80000000ULL) ? 0x80000000ULL : 0xFFFFFFFFULL);
+    case NV_SORT_KEY_F64: return bits ^ ((bits & 0x8000000000000000ULL) ? 0x8000000000000000ULL : 0xFFFFFFFFFFFFFFFFULL);
+  }
+  return bits;
+}
+
+static inline u64
+load_key(const uchar* p, size_t width)
+{
+  if (width == 4)
+  {
+    u32 v;
+    nv_memcpy_small(&v, p, sizeof(v));
+    return v;
+  }
+  u64 v;
+  nv_memcpy_small(&v, p, sizeof(v));
+  return v;
+}
+
+static inline void
+store_key(uchar* p, u64 v, size_t width)
+{
+  if (width == 4)
+  {
+    u32 v32 = (u32)v;
+    nv_memcpy_small(p, &v32, sizeof(v32));
+    return;
+  }
+  nv_memcpy_small(p, &v, sizeof(v));
+}
+
+static void
+map_keys(uchar* data, size_t count, size_t stride, size_t key_offset, nv_sort_key key, bool to_radix)
+{
+  if (key == NV_SORT_KEY_U32 || key == NV_SORT_KEY_U64) { return; }
+
+  const size_t width = key_width(key);
+  for (size_t i = 0; i < count; i++)
+  {
+    uchar*    p = data + (i * stride) + key_offset;
+    const u64 v = load_key(p, width);
+    store_key(p, to_radix ? key_to_radix(v, key) : radix_to_key(v, key), width);
+  }
+}
+
+/* Keys that are the whole element get their own loops, the scatter is a plain store instead of a memcpy. */
+#define RADIX_SORT_KEYS(TYPE, WIDTH)                                                                                                                                          \
+  static void radix_sort_keys_##TYPE(TYPE* data, TYPE* scratch, size_t count, size_t (*counts)[256])                                                                          \
+  {                                                                                                                                                                           \
+    TYPE* src = data;                                                                                                                                                         \
+    TYPE* dst = scratch;                                                                                                                                                      \
+    for (size_t pass = 0; pass < (WIDTH); pass++)                                                                                                                             \
+    {                                                                                                                                                                         \
+      size_t*        bucket = counts[pass];                                                                                                                                   \
+      const unsigned shift  = (unsigned)pass * 8U;                                                                                                                            \
+      if (bucket[(src[0] >> shift) & 0xFFU] == count) { continue; }                                                                                                           \
+      size_t offset = 0;                                                                                                                                                      \
+      for (size_t b = 0; b < 256; b++)                                                                                                                                        \
+      {                                                                                                                                                                       \
+        size_t c  = bucket[b];                                                                                                                                                \
+        bucket[b] = offset;                                                                                                                                                   \
+        offset += c;                                                                                                                                                          \
+      }                                                                                                                                                                       \
+      for (size_t i = 0; i < count; i++) { dst[bucket[(src[i] >> shift) & 0xFFU]++] = src[i]; }                                                                              \
+      TYPE* tmp = src;                                                                                                                                                        \
+      src       = dst;                                                                                                                                                        \
+      dst       = tmp;                                                                                                                                                        \
+    }                                                                                                                                                                         \
+    if (src != data) { nv_memcpy(data, src, count * sizeof(TYPE)); }                                                                                                          \
+  }
+
+RADIX_SORT_KEYS(u32, 4)
+RADIX_SORT_KEYS(u64, 8)
+
+#undef RADIX_SORT_KEYS
+
+static void
+radix_sort_records(uchar* data, uchar* scratch, size_t count, size_t stride, size_t key_offset, size_t width, size_t (*counts)[256])
+{
+  uchar* src = data;
+  uchar* dst = scratch;
+  for (size_t pass = 0; pass < width; pass++)
+  {
+    size_t* bucket = counts[pass];
+    if (bucket[src[key_offset + pass]] == count) { continue; }
+
+    size_t offset = 0;
+    for (size_t b = 0; b < 256; b++)
+    {
+      size_t c  = bucket[b];
+      bucket[b] = offset;
+      offset += c;
+    }
+
+    // keys are little endian in memory on every platform we care about, byte 'pass' is digit 'pass'.
+    for (size_t i = 0; i < count; i++)
+    {
+      const uchar* elem = src + (i * stride);
+      nv_memcpy_small(dst + (bucket[elem[key_offset + pass]]++ * stride), elem, stride);
+    }
+
+    uchar* tmp = src;
+    src        = dst;
+    dst        = tmp;
+  }
+  if (src != data) { nv_memcpy(data, src, count * stride); }
+}
+
+nv_error
+nv_radix_sort(void* data, size_t count, size_t stride, size_t key_offset, nv_sort_key key, nv_allocator_t* allocator)
+{
+  const size_t width = key_width(key);
+
+  nv_assert_else_return(width != 0, NV_ERROR_INVALID_ARG);
+  nv_assert_else_return(data != NULL || count == 0, NV_ERROR_INVALID_ARG);
+  nv_assert_else_return(key_offset + width <= stride, NV_ERROR_INVALID_ARG);
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+  // the record path reads digits straight out of memory.
+  if (stride != width) { return NV_ERROR_INVALID_ARG; }
+#endif
+
+  if (count < 2) { return NV_SUCCESS; }
+
+  if (!allocator) { allocator = nv_alloc_current; }
+
+  uchar* scratch = (uchar*)nv_alloc_zmalloc(allocator, count * stride);
+  if (!scratch) { return NV_ERROR_MALLOC_FAILED; }
+
+  uchar* bytes = (uchar*)data;
+  map_keys(bytes, count, stride, key_offset, key, true);
+
+  // one pass to build the histograms of every digit
+  size_t counts[8][256];
+  nv_bzero(counts, sizeof(counts));
+  for (size_t i = 0; i < count; i++)
+  {
+    const u64 v = load_key(bytes + (i * stride) + key_offset, width);
+    for (size_t d = 0; d < width; d++) { counts[d][(v >> (d * 8U)) & 0xFFU]++; }
+  }
+
+  if (stride == 4 && width == 4) { radix_sort_keys_u32((u32*)data, (u32*)(void*)scratch, count, counts); }
+  else if (stride == 8 && width == 8) { radix_sort_keys_u64((u64*)data, (u64*)(void*)scratch, count, counts); }
+  else
+  {
+    radix_sort_records(bytes, scratch, count, stride, key_offset, width, counts);
+  }
+
+  map_keys(bytes, count, stride, key_offset, key, false);
+
+  nv_alloc_free(allocator, scratch);
+  return NV_SUCCESS;
+}
+
+nv_error
+nv_list_radix_sort(nv_list_t* list, nv_sort_key key)
+{
+  nv_assert_else_return(NOVA_CONT_IS_VALID(list), NV_ERROR_INVALID_ARG);
+  nv_assert_else_return(list->type_size == key_width(key), NV_ERROR_INVALID_ARG);
+
+  return nv_radix_sort(list->data, list->size, list->type_size, 0, key, list->alloc);
+}
+
+nv_error
+nv_list_radix_sort_by(nv_list_t* list, size_t key_offset, nv_sort_key key)
+{
+  nv_assert_else_return(NOVA_CONT_IS_VALID(list), NV_ERROR_INVALID_ARG);
+
+  return nv_radix_sort(list->data, list->size, list->type_size, key_offset, key, list->alloc);
+}
+
+/*
+ * Top k of numeric keys.
+ * Once the heap is full, almost every element of a large input loses to its root. The AVX2 filter compares a whole
+ * vector against the root at once and only looks at the lanes that beat it.
+ */
+
+#define TOPK_KERNELS(S, T)                                                                                                                                                    \
+  static inline void topk_##S##_sift(T* heap, size_t root, size_t k)                                                                                                          \
+  {                                                                                                                                                                           \
+    T value = heap[root];                                                                                                                                                     \
+    for (;;)                                                                                                                                                                  \
+    {                                                                                                                                                                         \
+      size_t child = (2 * root) + 1;                                                                                                                                          \
+      if (child >= k) { break; }                                                                                                                                              \
+      if (child + 1 < k && heap[child + 1] < heap[child]) { child++; }                                                                                                        \
+      if (!(heap[child] < value)) { break; }                                                                                                                                  \
+      heap[root] = heap[child];                                                                                                                                               \
+      root       = child;                                                                                                                                                     \
+    }                                                                                                                                                                         \
+    heap[root] = value;                                                                                                                                                       \
+  }                                                                                                                                                                           \
+  static inline void topk_##S##_offer(T* heap, size_t k, T value)                                                                                                             \
+  {                                                                                                                                                                           \
+    if (heap[0] < value)                                                                                                                                                      \
+    {                                                                                                                                                                         \
+      heap[0] = value;                                                                                                                                                        \
+      topk_##S##_sift(heap, 0, k);                                                                                                                                            \
+    }                                                                                                                                                                         \
+  }
+
+TOPK_KERNELS(u32, u32)
+TOPK_KERNELS(u64, u64)
+TOPK_KERNELS(i32, i32)
+TOPK_KERNELS(i64, i64)
+TOPK_KERNELS(f32, f32)
+TOPK_KERNELS(f64, f64)
+
+#if NV_CPU_X86_SIMD
+
+/* AVX2 only has signed compares, flipping the sign bits orders unsigned values the same way. */
+NV_CPU_TARGET("avx2") static inline int
+gt_mask_u32_avx2(__m256i a, __m256i b)
+{
+  const __m256i sign = _mm256_set1_epi32(INT32_MIN);
+  return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_xor_si256(a, sign), _mm256_xor_si256(b, sign))));
+}
+
+NV_CPU_TARGET("avx2") static inline int
+gt_mask_u64_avx2(__m256i a, __m256i b)
+{
+  const __m256i sign = _mm256_set1_epi64x(INT64_MIN);
+  return _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(_mm256_xor_si256(a, sign), _mm256_xor_si256(b, sign))));
+}
+
+#  define GT_MASK_I32_AVX2(a, b) _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(a, b)))
+#  define GT_MASK_I64_AVX2(a, b) _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(a, b)))
+#  define GT_MASK_F32_AVX2(a, b) _mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_GT_OQ))
+#  define GT_MASK_F64_AVX2(a, b) _mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_GT_OQ))
+#  define LOADU_SI256(p) _mm256_loadu_si256((const __m256i*)(const void*)(p))
+
+/* Offer the elements of whole vectors to the heap, returns how many elements were looked at. */
+#  define TOPK_AVX2(S, T, VEC, PER, SET1, LOADU, GT_MASK)                                                                                                                     \
+    NV_CPU_TARGET("avx2") static size_t topk_##S##_avx2(const T* data, size_t count, T* heap, size_t k)                                                                       \
+    {                                                                                                                                                                         \
+      size_t i = 0;                                                                                                                                                           \
+      for (; i + PER <= count; i += PER)                                                                                                                                      \
+      {                                                                                                                                                                       \
+        unsigned m = (unsigned)GT_MASK(LOADU(data + i), SET1(heap[0]));                                                                                                       \
+        for (; m; m &= m - 1) { topk_##S##_offer(heap, k, data[i + (size_t)__builtin_ctz(m)]); }                                                                              \
+      }                                                                                                                                                                       \
+      return i;                                                                                                                                                               \
+    }
+
+TOPK_AVX2(u32, u32, __m256i, 8, _mm256_set1_epi32, LOADU_SI256, gt_mask_u32_avx2)
+TOPK_AVX2(u64, u64, __m256i, 4, _mm256_set1_epi64x, LOADU_SI256, gt_mask_u64_avx2)
+TOPK_AVX2(i32, i32, __m256i, 8, _mm256_set1_epi32, LOADU_SI256, GT_MASK_I32_AVX2)
+TOPK_AVX2(i64, i64, __m256i, 4, _mm256_set1_epi64x, LOADU_SI256, GT_MASK_I64_AVX2)
+TOPK_AVX2(f32, f32, __m256, 8, _mm256_set1_ps, _mm256_loadu_ps, GT_MASK_F32_AVX2)
+TOPK_AVX2(f64, f64, __m256d, 4, _mm256_set1_pd, _mm256_loadu_pd, GT_MASK_F64_AVX2)
+
+#  define TOPK_FILTER(S, data, count, heap, k) (nv_cpu_has(NV_CPU_AVX2) ? topk_##S##_avx2(data, count, heap, k) : 0)
+#else
+#  define TOPK_FILTER(S, data, count, heap, k) 0
+#endif
+
+#define TOPK_CASE(KEY, S, T)                                                                                                                                                  \
+  case KEY:                                                                                                                                                                   \
+  {                                                                                                                                                                           \
+    const T* src  = (const T*)list->data;                                                                                                                                     \
+    T*       heap = (T*)out->data;                                                                                                                                            \
+    nv_memcpy(heap, src, k * sizeof(T));                                                                                                                                      \
+    for (size_t i = k / 2; i-- > 0;) { topk_##S##_sift(heap, i, k); }                                                                                                         \
+    size_t i = k;                                                                                                                                                             \
+    i += TOPK_FILTER(S, src + i, list->size - i, heap, k);                                                                                                                    \
+    for (; i < list->size; i++) { topk_##S##_offer(heap, k, src[i]); }                                                                                                        \
+    for (size_t n = k; n-- > 1;)                                                                                                                                              \
+    {                                                                                                                                                                         \
+      const T tmp = heap[0];                                                                                                                                                  \
+      heap[0]     = heap[n];                                                                                                                                                  \
+      heap[n]     = tmp;                                                                                                                                                      \
+      topk_##S##_sift(heap, 0, n);                                                                                                                                            \
+    }                                                                                                                                                                         \
+    break;                                                                                                                                                                    \
+  }
+
+nv_error
+nv_list_top_k_key(const nv_list_t* list, size_t k, nv_sort_key key, nv_list_t* out)
+{
+  nv_assert_else_return(NOVA_CONT_IS_VALID(list), NV_ERROR_INVALID_ARG);
+  nv_assert_else_return(NOVA_CONT_IS_VALID(out), NV_ERROR_INVALID_ARG);
+  nv_assert_else_return(list != out && list->type_size == key_width(key) && out->type_size == key_width(key), NV_ERROR_INVALID_ARG);
+
+  k = NV_MIN(k, list->size);
+  nv_list_clear(out);
+  if (k == 0) { return NV_SUCCESS; }
+
+  nv_list_reserve(out, k);
+  if (out->capacity < k) { return NV_ERROR_MALLOC_FAILED; }
+
+  switch (key)
+  {
+    TOPK_CASE(NV_SORT_KEY_U32, u32, u32)
+    TOPK_CASE(NV_SORT_KEY_U64, u64, u64)
+    TOPK_CASE(NV_SORT_KEY_I32, i32, i32)
+    TOPK_CASE(NV_SORT_KEY_I64, i64, i64)
+    TOPK_CASE(NV_SORT_KEY_F32, f32, f32)
+    TOPK_CASE(NV_SORT_KEY_F64, f64, f64)
+  }
+
+  out->size = k;
+  return NV_SUCCESS;
+}
+
+/*
+ * MSD radix sort for strings.
+ * Segments of strings sharing the first 'depth' characters are split on their next character until they are small
+ * enough for an insertion sort. A work stack is used instead of recursion, the depth can be as long as the longest
+ * common prefix.
+ */
+
+typedef struct string_segment
+{
+  size_t begin;
+  size_t count;
+  size_t depth;
+} string_segment;
+
+static inline int
+compare_from(const char* a, const char* b, size_t depth)
+{
+  return nv_strcmp(a + depth, b + depth);
+}
+
+static void
+string_insertion(const char** strings, size_t count, size_t depth)
+{
+  for (size_t i = 1; i < count; i++)
+  {
+    const char* value = strings[i];
+    size_t      j     = i;
+    for (; j > 0 && compare_from(value, strings[j - 1], depth) < 0; j--) { strings[j] = strings[j - 1]; }
+    strings[j] = value;
+  }
+}
+
+nv_error
+nv_list_sort_strings(nv_list_t* list)
+{
+  nv_assert_else_return(NOVA_CONT_IS_VALID(list), NV_ERROR_INVALID_ARG);
+  nv_assert_else_return(list->type_size == sizeof(const char*), NV_ERROR_INVALID_ARG);
+
+  const size_t count = list->size;
+  if (count < 2) { return NV_SUCCESS; }
+
+  const char** strings = (const char**)list->data;
+
+  if (count <= NV_SORT_STRING_INSERTION_THRESHOLD)
+  {
+    string_insertion(strings, count, 0);
+    return NV_SUCCESS;
+  }
+
+  const char** scratch = (const char**)nv_alloc_zmalloc(list->alloc, count * sizeof(const char*));
+  if (!scratch) { return NV_ERROR_MALLOC_FAILED; }
+
+  size_t          stack_capacity = 64;
+  size_t          stack_size     = 0;
+  string_segment* stack          = (string_segment*)nv_alloc_zmalloc(list->alloc, stack_capacity * sizeof(string_segment));
+  if (!stack)
+  {
+    nv_alloc_free(list->alloc, scratch);
+    return NV_ERROR_MALLOC_FAILED;
+  }
+
+  nv_error e          = NV_SUCCESS;
+  stack[stack_size++] = (string_segment){ 0, count, 0 };
+
+  while (stack_size > 0)
+  {
+    const string_segment seg = stack[--stack_size];
+    const char**         s   = strings + seg.begin;
+
+    if (seg.count <= NV_SORT_STRING_INSERTION_THRESHOLD)
+    {
+      string_insertion(s, seg.count, seg.depth);
+      continue;
+    }
+
+    size_t bucket[256] = { 0 };
+    for (size_t i = 0; i < seg.count; i++) { bucket[(uchar)s[i][seg.depth]]++; }
+
+    // strings that ended at this depth are equal, they go first and are done.
+    size_t offsets[256];
+    size_t offset = 0;
+    for (size_t b = 0; b < 256; b++)
+    {
+      offsets[b] = offset;
+      offset += bucket[b];
+    }
+
+    if (bucket[0] != seg.count)
+    {
+      size_t next[256];
+      nv_memcpy(next, offsets, sizeof(next));
+      for (size_t i = 0; i < seg.count; i++) { scratch[next[(uchar)s[i][seg.depth]]++] = s[i]; }
+      nv_memcpy(s, scratch, seg.count * sizeof(const char*));
+    }
+
+    for (size_t b = 1; b < 256; b++)
+    {
+      if (bucket[b] < 2) { continue; }
+
+      if (stack_size == stack_capacity)
+      {
+        string_segment* grown = (string_segment*)nv_alloc_realloc(list->alloc, stack, stack_capacity * 2 * sizeof(string_segment));
+        if (!grown)
+        {
+          e = NV_ERROR_MALLOC_FAILED;
+          goto cleanup;
+        }
+        stack = grown;
+        stack_capacity *= 2;
+      }
+      stack[stack_size++] = (string_segment){ seg.begin + offsets[b], bucket[b], seg.depth + 1 };
+    }
+  }
+
+cleanup:
+  nv_alloc_free(list->alloc, stack);
+  nv_alloc_free(list->alloc, scratch);
+  return e;
+}
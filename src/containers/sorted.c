@@ -0,0 +1,472 @@
+#include "../../include/containers/sorted.h"
+
+#include "../../include/alloc.h"
+#include "../../include/containers/list.h"
+#include "../../include/cpu.h"
+#include "../../include/error.h"
+#include "../../include/stdafx.h"
+#include "../../include/string.h"
+#include "../../include/types.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if NV_CPU_X86_SIMD
+#  include <immintrin.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#  define PREFETCH(p) __builtin_prefetch(p)
+#else
+#  define PREFETCH(p) ((void)(p))
+#endif
+
+#define AT(data, i, size) ((const uchar*)(data) + ((i) * (size)))
+
+static inline nv_compare_fn
+compare_or_default(nv_compare_fn compare)
+{
+  return compare ? compare : (nv_compare_fn)nv_compare_default;
+}
+
+/*
+ * Binary search
+ */
+
+size_t
+nv_list_lower_bound(const nv_list_t* list, const void* key, nv_compare_fn compare, void* user_data)
+{
+  nv_assert_else_return(NOVA_CONT_IS_VALID(list), 0);
+  nv_assert_else_return(key != NULL, 0);
+  compare = compare_or_default(compare);
+
+  const size_t size  = list->type_size;
+  size_t       count = list->size;
+  size_t       base  = 0;
+  if (count == 0) { return 0; }
+
+  while (count > 1)
+  {
+    const size_t half = count / 2;
+    base              = compare(AT(list->data, base + half, size), key, size, user_data) < 0 ? base + half : base;
+    count -= half;
+  }
+  return base + (compare(AT(list->data, base, size), key, size, user_data) < 0 ? 1 : 0);
+}
+
+size_t
+nv_list_upper_bound(const nv_list_t* list, const void* key, nv_compare_fn compare, void* user_data)
+{
+  nv_assert_else_return(NOVA_CONT_IS_VALID(list), 0);
+  nv_assert_else_return(key != NULL, 0);
+  compare = compare_or_default(compare);
+
+  const size_t size  = list->type_size;
+  size_t       count = list->size;
+  size_t       base  = 0;
+  if (count == 0) { return 0; }
+
+  while (count > 1)
+  {
+    const size_t half = count / 2;
+    base              = compare(AT(list->data, base + half, size), key, size, user_data) > 0 ? base : base + half;
+    count -= half;
+  }
+  return base + (compare(AT(list->data, base, size), key, size, user_data) > 0 ? 0 : 1);
+}
+
+/*
+ * Eytzinger layout
+ * Node k (from 1) has its children at 2k and 2k + 1. Filling the nodes in order (left subtree, node, right subtree)
+ * from the sorted elements gives the layout.
+ */
+
+static size_t
+eytzinger_fill(const uchar* sorted, uchar* layout, size_t size, size_t count, size_t i, size_t k)
+{
+  if (k <= count)
+  {
+    i = eytzinger_fill(sorted, layout, size, count, i, 2 * k);
+    nv_memcpy_small(layout + (k * size), sorted + (i * size), size);
+    i = eytzinger_fill(sorted, layout, size, count, i + 1, (2 * k) + 1);
+  }
+  return i;
+}
+
+nv_error
+nv_list_eytzinger(const nv_list_t* NV_RESTRICT sorted, nv_list_t* NV_RESTRICT layout)
+{
+  nv_assert_else_return(NOVA_CONT_IS_VALID(sorted), NV_ERROR_INVALID_ARG);
+  nv_assert_else_return(NOVA_CONT_IS_VALID(layout), NV_ERROR_INVALID_ARG);
+  nv_assert_else_return(sorted->type_size == layout->type_size, NV_ERROR_INVALID_ARG);
+
+  const size_t size = sorted->type_size;
+
+  nv_list_resize(layout, sorted->size + 1);
+
+  nv_memset(layout->data, 0, size);
+  eytzinger_fill((const uchar*)sorted->data, (uchar*)layout->data, size, sorted->size, 0, 1);
+
+  return NV_ERROR_SUCCESS;
+}
+
+size_t
+nv_eytzinger_lower_bound(const nv_list_t* layout, const void* key, nv_compare_fn compare, void* user_data)
+{
+  nv_assert_else_return(NOVA_CONT_IS_VALID(layout), 0);
+  nv_assert_else_return(key != NULL, 0);
+  if (layout->size < 2) { return 0; }
+  compare = compare_or_default(compare);
+
+  const size_t size  = layout->type_size;
+  const size_t count = layout->size - 1;
+  const uchar* data  = (const uchar*)layout->data;
+
+  // a cache line holds the node 'ahead' levels down, prefetch that far ahead.
+  size_t ahead = 1;
+  while (ahead * 2 * size <= 64) { ahead *= 2; }
+
+  size_t k = 1;
+  while (k <= count)
+  {
+    if (k * ahead <= count) { PREFETCH(data + (k * ahead * size)); }
+    k = (2 * k) + (compare(data + (k * size), key, size, user_data) < 0 ? 1 : 0);
+  }
+
+  // every right turn (less than key) after the last left turn is undone, the left turn's node is the answer.
+  while (k & 1) { k >>= 1; }
+  return k >> 1;
+}
+
+/*
+ * K-way merge
+ */
+
+typedef struct merge_head
+{
+  const uchar* elem;
+  const uchar* end;
+  size_t       list; // breaks ties, so that the merge is stable
+} merge_head;
+
+typedef struct merge_ctx
+{
+  nv_compare_fn compare;
+  void*         user_data;
+  size_t        size;
+} merge_ctx;
+
+static inline bool
+head_less(const merge_ctx* ctx, const merge_head* a, const merge_head* b)
+{
+  const int c = ctx->compare(a->elem, b->elem, ctx->size, ctx->user_data);
+  return c < 0 || (c == 0 && a->list < b->list);
+}
+
+static void
+heap_sift_down(const merge_ctx* ctx, merge_head* heap, size_t count, size_t root)
+{
+  merge_head value = heap[root];
+  for (;;)
+  {
+    size_t child = (2 * root) + 1;
+    if (child >= count) { break; }
+    if (child + 1 < count && head_less(ctx, &heap[child + 1], &heap[child])) { child++; }
+    if (!head_less(ctx, &heap[child], &value)) { break; }
+    heap[root] = heap[child];
+    root       = child;
+  }
+  heap[root] = value;
+}
+
+nv_error
+nv_list_merge(const nv_list_t* const* lists, size_t count, nv_compare_fn compare, void* user_data, nv_list_t* out)
+{
+  nv_assert_else_return(lists != NULL || count == 0, NV_ERROR_INVALID_ARG);
+  nv_assert_else_return(NOVA_CONT_IS_VALID(out), NV_ERROR_INVALID_ARG);
+
+  const size_t size  = out->type_size;
+  size_t       total = 0;
+  for (size_t i = 0; i < count; i++)
+  {
+    nv_assert_else_return(NOVA_CONT_IS_VALID(lists[i]) && lists[i]->type_size == size, NV_ERROR_INVALID_ARG);
+    nv_assert_else_return(lists[i] != out, NV_ERROR_INVALID_ARG);
+    total += lists[i]->size;
+  }
+
+  nv_list_clear(out);
+  if (total == 0) { return NV_ERROR_SUCCESS; }
+
+  nv_list_reserve(out, total);
+
+  merge_head  stack_heap[32];
+  merge_head* heap = stack_heap;
+  if (count > nv_arrlen(stack_heap))
+  {
+    heap = nv_alloc_zmalloc(out->alloc, count * sizeof(merge_head));
+    if (!heap) { return NV_ERROR_MALLOC_FAILED; }
+  }
+
+  size_t heap_size = 0;
+  for (size_t i = 0; i < count; i++)
+  {
+    if (lists[i]->size == 0) { continue; }
+    const uchar* data = (const uchar*)lists[i]->data;
+    heap[heap_size++] = (merge_head){ data, data + (lists[i]->size * size), i };
+  }
+
+  const merge_ctx ctx = { compare_or_default(compare), user_data, size };
+  for (size_t i = heap_size / 2; i-- > 0;) { heap_sift_down(&ctx, heap, heap_size, i); }
+
+  uchar* dst = (uchar*)out->data;
+  while (heap_size > 1)
+  {
+    merge_head* top = &heap[0];
+    nv_memcpy_small(dst, top->elem, size);
+    dst += size;
+
+    top->elem += size;
+    if (top->elem == top->end) { heap[0] = heap[--heap_size]; }
+    heap_sift_down(&ctx, heap, heap_size, 0);
+  }
+
+  // the last list left is copied over whole
+  nv_memcpy(dst, heap[0].elem, (size_t)(heap[0].end - heap[0].elem));
+
+  out->size = total;
+
+  if (heap != stack_heap) { nv_alloc_free(out->alloc, heap); }
+  return NV_ERROR_SUCCESS;
+}
+
+/*
+ * Intersection
+ */
+
+/**
+ * The first index in [from, count) whose element is not less than 'key', found by doubling the step from 'from'
+ * and then binary searching the last step.
+ */
+static size_t
+gallop(const uchar* data, size_t from, size_t count, const void* key, size_t size, nv_compare_fn compare, void* user_data)
+{
+  size_t lo   = from;
+  size_t step = 1;
+  while (from + step < count && compare(AT(data, from + step, size), key, size, user_data) < 0)
+  {
+    lo = from + step;
+    step *= 2;
+  }
+
+  size_t hi = NV_MIN(from + step + 1, count);
+  while (lo < hi)
+  {
+    const size_t mid = lo + ((hi - lo) / 2);
+    if (compare(AT(data, mid, size), key, size, user_data) < 0) { lo = mid + 1; }
+    else
+    {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+static inline nv_error
+intersect_begin(const nv_list_t* a, const nv_list_t* b, nv_list_t* out)
+{
+  nv_assert_else_return(NOVA_CONT_IS_VALID(a) && NOVA_CONT_IS_VALID(b) && NOVA_CONT_IS_VALID(out), NV_ERROR_INVALID_ARG);
+  nv_assert_else_return(a->type_size == b->type_size && a->type_size == out->type_size, NV_ERROR_INVALID_ARG);
+  nv_assert_else_return(a != out && b != out, NV_ERROR_INVALID_ARG);
+
+  const size_t most = NV_MIN(a->size, b->size);
+
+  nv_list_clear(out);
+  if (most == 0) { return NV_ERROR_SUCCESS; }
+
+  nv_list_reserve(out, most);
+
+  return NV_ERROR_SUCCESS;
+}
+
+nv_error
+nv_list_intersect(const nv_list_t* a, const nv_list_t* b, nv_compare_fn compare, void* user_data, nv_list_t* out)
+{
+  nv_error e = intersect_begin(a, b, out);
+  if (e != NV_ERROR_SUCCESS || a->size == 0 || b->size == 0) { return e; }
+
+  compare = compare_or_default(compare);
+
+  if (a->size > b->size)
+  {
+    const nv_list_t* tmp = a;
+    a                    = b;
+    b                    = tmp;
+  }
+
+  const size_t size = a->type_size;
+  const uchar* da   = (const uchar*)a->data;
+  const uchar* db   = (const uchar*)b->data;
+  uchar*       dst  = (uchar*)out->data;
+  size_t       n    = 0;
+  size_t       i    = 0;
+  size_t       j    = 0;
+
+  if (b->size / a->size >= NV_INTERSECT_GALLOP_RATIO)
+  {
+    for (; i < a->size && j < b->size; i++)
+    {
+      j = gallop(db, j, b->size, AT(da, i, size), size, compare, user_data);
+      if (j < b->size && compare(AT(db, j, size), AT(da, i, size), size, user_data) == 0)
+      {
+        nv_memcpy_small(dst + (n++ * size), AT(da, i, size), size);
+        j++;
+      }
+    }
+  }
+  else
+  {
+    while (i < a->size && j < b->size)
+    {
+      const int c = compare(AT(da, i, size), AT(db, j, size), size, user_data);
+      if (c == 0) { nv_memcpy_small(dst + (n++ * size), AT(da, i, size), size); }
+      i += c <= 0;
+      j += c >= 0;
+    }
+  }
+
+  out->size = n;
+  return NV_ERROR_SUCCESS;
+}
+
+/*
+ * u32 set intersection
+ * Each step compares a block of 'a' against every rotation of a block of 'b', which finds every element of the 'a'
+ * block that is anywhere in the 'b' block. Whichever block ends with the smaller element can not match anything
+ * further on, and is stepped over (both are if they end with the same element).
+ */
+
+static size_t
+intersect_u32_scalar(const u32* a, size_t na, const u32* b, size_t nb, size_t i, size_t j, u32* out, size_t n)
+{
+  while (i < na && j < nb)
+  {
+    const u32 x = a[i];
+    const u32 y = b[j];
+    if (x == y) { out[n++] = x; }
+    i += x <= y;
+    j += x >= y;
+  }
+  return n;
+}
+
+#if NV_CPU_X86_SIMD
+
+static size_t
+intersect_u32_sse2(const u32* a, size_t na, const u32* b, size_t nb, u32* out)
+{
+  size_t i = 0;
+  size_t j = 0;
+  size_t n = 0;
+
+  while (i + 4 <= na && j + 4 <= nb)
+  {
+    const __m128i va = _mm_loadu_si128((const __m128i*)(const void*)(a + i));
+    const __m128i vb = _mm_loadu_si128((const __m128i*)(const void*)(b + j));
+
+    __m128i eq = _mm_cmpeq_epi32(va, vb);
+    eq         = _mm_or_si128(eq, _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1))));
+    eq         = _mm_or_si128(eq, _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(1, 0, 3, 2))));
+    eq         = _mm_or_si128(eq, _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(2, 1, 0, 3))));
+
+    for (int m = _mm_movemask_ps(_mm_castsi128_ps(eq)); m; m &= m - 1) { out[n++] = a[i + (size_t)__builtin_ctz((unsigned)m)]; }
+
+    const u32 amax = a[i + 3];
+    const u32 bmax = b[j + 3];
+    i += amax <= bmax ? 4 : 0;
+    j += bmax <= amax ? 4 : 0;
+  }
+
+  return intersect_u32_scalar(a, na, b, nb, i, j, out, n);
+}
+
+NV_CPU_TARGET("avx2") static size_t
+intersect_u32_avx2(const u32* a, size_t na, const u32* b, size_t nb, u32* out)
+{
+  size_t i = 0;
+  size_t j = 0;
+  size_t n = 0;
+
+  const __m256i rotate = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);
+
+  while (i + 8 <= na && j + 8 <= nb)
+  {
+    const __m256i va = _mm256_loadu_si256((const __m256i*)(const void*)(a + i));
+    __m256i       vb = _mm256_loadu_si256((const __m256i*)(const void*)(b + j));
+
+    __m256i eq = _mm256_cmpeq_epi32(va, vb);
+    for (int r = 1; r < 8; r++)
+    {
+      vb = _mm256_permutevar8x32_epi32(vb, rotate);
+      eq = _mm256_or_si256(eq, _mm256_cmpeq_epi32(va, vb));
+    }
+
+    for (int m = _mm256_movemask_ps(_mm256_castsi256_ps(eq)); m; m &= m - 1) { out[n++] = a[i + (size_t)__builtin_ctz((unsigned)m)]; }
+
+    const u32 amax = a[i + 7];
+    const u32 bmax = b[j + 7];
+    i += amax <= bmax ? 8 : 0;
+    j += bmax <= amax ? 8 : 0;
+  }
+
+  return intersect_u32_scalar(a, na, b, nb, i, j, out, n);
+}
+
+#endif
+
+nv_error
+nv_list_intersect_u32(const nv_list_t* a, const nv_list_t* b, nv_list_t* out)
+{
+  nv_assert_else_return(NOVA_CONT_IS_VALID(a) && a->type_size == sizeof(u32), NV_ERROR_INVALID_ARG);
+
+  nv_error e = intersect_begin(a, b, out);
+  if (e != NV_ERROR_SUCCESS || a->size == 0 || b->size == 0) { return e; }
+
+  if (a->size > b->size)
+  {
+    const nv_list_t* tmp = a;
+    a                    = b;
+    b                    = tmp;
+  }
+
+  const u32* da  = (const u32*)a->data;
+  const u32* db  = (const u32*)b->data;
+  u32*       dst = (u32*)out->data;
+  size_t     n   = 0;
+
+  if (b->size / a->size >= NV_INTERSECT_GALLOP_RATIO)
+  {
+    size_t j = 0;
+    for (size_t i = 0; i < a->size && j < b->size; i++)
+    {
+      // gallop to the block holding a[i], then binary search it
+      size_t step = 1;
+      while (j + step < b->size && db[j + step] < da[i]) { step *= 2; }
+      const size_t lo = j + (step / 2);
+      const size_t hi = NV_MIN(j + step + 1, b->size);
+      j               = lo + nv_search_u32_lower_bound(db + lo, hi - lo, da[i]);
+      if (j < b->size && db[j] == da[i]) { dst[n++] = db[j++]; }
+    }
+  }
+#if NV_CPU_X86_SIMD
+  else if (nv_cpu_has(NV_CPU_AVX2)) { n = intersect_u32_avx2(da, a->size, db, b->size, dst); }
+  else if (nv_cpu_has(NV_CPU_SSE2)) { n = intersect_u32_sse2(da, a->size, db, b->size, dst); }
+#endif
+  else
+  {
+    n = intersect_u32_scalar(da, a->size, db, b->size, 0, 0, dst, 0);
+  }
+
+  out->size = n;
+  return NV_ERROR_SUCCESS;
+}
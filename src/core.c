@@ -22,6 +22,7 @@
   SOFTWARE.
   */
 
+#include "../include/alloc.h"
 #include "../include/error.h"
 #include "../include/print.h"
 #include "../include/props.h"
@@ -38,6 +39,8 @@
 #include <string.h>
 #include <time.h>
 
+NV_THREAD_LOCAL nv_alloc_site_t nv_alloc_current_site = { NULL, 0 };
+
 nv_error
 nv_default_error_handler(nv_error error, const char* fn, const char* file, size_t line, const char* supplementary, va_list args)
 {
@@ -0,0 +1,42 @@
+#include "../include/cpu.h"
+
+#include "../include/atomic.h"
+#include "../include/stdafx.h"
+
+#define FEATURES_DETECTED (1U << 31U)
+
+static nv_atomic_uint cached_features = 0;
+
+static unsigned
+detect_features(void)
+{
+  unsigned features = 0;
+
+#if NV_CPU_X86_SIMD
+  // __builtin_cpu_supports also checks that the OS saves the AVX state.
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("sse2")) { features |= NV_CPU_SSE2; }
+  if (__builtin_cpu_supports("sse4.1")) { features |= NV_CPU_SSE41; }
+  if (__builtin_cpu_supports("popcnt")) { features |= NV_CPU_POPCNT; }
+  if (__builtin_cpu_supports("avx2")) { features |= NV_CPU_AVX2; }
+  if (__builtin_cpu_supports("bmi2")) { features |= NV_CPU_BMI2; }
+  if (__builtin_cpu_supports("avx512f")) { features |= NV_CPU_AVX512F; }
+  if (__builtin_cpu_supports("avx512bw")) { features |= NV_CPU_AVX512BW; }
+  if (__builtin_cpu_supports("avx512vl")) { features |= NV_CPU_AVX512VL; }
+#endif
+
+  return features;
+}
+
+unsigned
+nv_cpu_features(void)
+{
+  unsigned features = nv_atomic_load(&cached_features);
+  if (NV_UNLIKELY(!(features & FEATURES_DETECTED)))
+  {
+    // detecting twice from two threads is harmless, both get the same answer.
+    features = detect_features() | FEATURES_DETECTED;
+    nv_atomic_store(&cached_features, features);
+  }
+  return features & ~FEATURES_DETECTED;
+}
@@ -32,6 +32,10 @@ struct nv_stream
   nv_error error;
 
   stream_type type;
+
+  /* The allocator the stream (and the buffer of a bufstream) was allocated with. */
+  nv_allocator_t* alloc;
+
   union
   {
     FILE* file;
@@ -115,6 +119,7 @@ nv_open_fstream(const char* path, const char* mode, struct nv_stream** stm)
 
   struct nv_stream* stmp = *stm;
   stmp->type             = STREAM_FILE;
+  stmp->alloc            = nv_alloc_current;
   stmp->read             = file_read;
   stmp->write            = file_write;
   stmp->flush            = file_flush;
@@ -168,9 +173,14 @@ membuf_write(nv_stream_t* stm, const void* data, size_t nbyte)
   {
     if (stm->type == STREAM_DYNBUFFER)
     {
-      void* new_buffer    = nv_realloc(stm->val.buf.buffer, NV_MAX(stm->val.buf.buffer_size * 2, stm->val.buf.buffer_size + nbyte));
-      stm->val.buf.buffer = new_buffer;
+      size_t new_size   = NV_MAX(stm->val.buf.buffer_size * 2, stm->val.buf.buffer_size + nbyte);
+      void*  new_buffer = nv_alloc_realloc(stm->alloc, stm->val.buf.buffer, new_size);
       if (!new_buffer) return 0;
+
+      // rebase the write head onto the new buffer
+      stm->val.buf.buffer      = new_buffer;
+      stm->val.buf.buffer_size = new_size;
+      stm->val.buf.write       = (uchar*)new_buffer + current_offset;
     }
     else
     {
@@ -249,6 +259,7 @@ nv_open_memstream(void* buffer, size_t buffer_size, struct nv_stream** stm)
 
   struct nv_stream* stmp    = *stm;
   stmp->type                = STREAM_BUFFER;
+  stmp->alloc               = nv_alloc_current;
   stmp->val.buf.buffer      = buffer;
   stmp->val.buf.buffer_size = buffer_size;
 
@@ -265,22 +276,31 @@ nv_open_memstream(void* buffer, size_t buffer_size, struct nv_stream** stm)
 
 nv_error
 nv_open_bufstream(size_t init_size, struct nv_stream** stm)
+{
+  return nv_open_bufstream_with_allocator(init_size, NULL, stm);
+}
+
+nv_error
+nv_open_bufstream_with_allocator(size_t init_size, nv_allocator_t* allocator, struct nv_stream** stm)
 {
   if (init_size == 0 || !stm) { return NV_ERROR_INVALID_ARG; }
 
   nv_error e = NV_SUCCESS;
 
-  *stm = nv_stalloc(*stm);
+  if (!allocator) { allocator = nv_alloc_current; }
+
+  *stm = (struct nv_stream*)nv_alloc_zmalloc(allocator, sizeof(struct nv_stream));
   if (!*stm) return NV_ERROR_MALLOC_FAILED;
 
   struct nv_stream* stmp    = *stm;
   stmp->type                = STREAM_DYNBUFFER;
-  stmp->val.buf.buffer      = nv_zmalloc(init_size);
+  stmp->alloc               = allocator;
+  stmp->val.buf.buffer      = nv_alloc_zmalloc(allocator, init_size);
   stmp->val.buf.buffer_size = init_size;
 
   if (!stmp->val.buf.buffer)
   {
-    nv_free(stmp);
+    nv_alloc_free(allocator, stmp);
     *stm = NULL;
     return NV_ERROR_MALLOC_FAILED;
   }
@@ -308,6 +328,7 @@ nv_open_pipestream(FILE* pipe, struct nv_stream** stm)
 
   struct nv_stream* stmp = *stm;
   stmp->type             = STREAM_PIPE;
+  stmp->alloc            = nv_alloc_current;
   stmp->val.file         = pipe;
 
   stmp->read  = file_read;
@@ -361,6 +382,7 @@ nv_open_sinkstream(struct nv_stream** stm)
 
   struct nv_stream* stmp = *stm;
   stmp->type             = STREAM_CUSTOM;
+  stmp->alloc            = nv_alloc_current;
   stmp->read             = sink_read;
   stmp->write            = sink_write;
   stmp->flush            = sink_flush;
@@ -380,6 +402,7 @@ nv_open_stream(nv_stream_read_fn read, nv_stream_write_fn write, nv_stream_seek_
 
   struct nv_stream* stmp = *stm;
   stmp->type             = STREAM_CUSTOM;
+  stmp->alloc            = nv_alloc_current;
   stmp->read             = read;
   stmp->write            = write;
   stmp->flush            = flush;
@@ -396,10 +419,11 @@ nv_close_stream(struct nv_stream* stm)
 
   nv_stream_flush(stm);
 
-  if (stm->type == STREAM_DYNBUFFER && stm->val.buf.buffer != NULL) { nv_free(stm->val.buf.buffer); }
+  if (stm->type == STREAM_DYNBUFFER && stm->val.buf.buffer != NULL) { nv_alloc_free(stm->alloc, stm->val.buf.buffer); }
 
+  nv_allocator_t* alloc = stm->alloc;
   nv_bzero(stm, sizeof(*stm));
-  nv_free(stm);
+  nv_alloc_free(alloc, stm);
 }
 
 nv_error
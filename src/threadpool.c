@@ -0,0 +1,236 @@
+#include "../include/threadpool.h"
+
+#include "../include/alloc.h"
+#include "../include/atomic.h"
+#include "../include/error.h"
+#include "../include/stdafx.h"
+#include "../include/string.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifndef NV_THREAD_POOL_SERIAL
+#  include <pthread.h>
+#  include <unistd.h>
+#endif
+
+struct nv_thread_pool
+{
+  size_t num_workers;
+
+#ifndef NV_THREAD_POOL_SERIAL
+  pthread_t* workers;
+
+  pthread_mutex_t run_lock; // held for the duration of a batch
+  pthread_mutex_t lock;     // protects everything below
+  pthread_cond_t  wake;     // a new batch (or stop) for the workers
+  pthread_cond_t  finished; // the last worker left the batch
+
+  size_t generation; // incremented for every batch
+  size_t active;     // workers that have not left the current batch yet
+  bool   stop;
+
+  nv_task_fn     fn;
+  void*          user_data;
+  size_t         count;
+  nv_atomic_size next;
+#endif
+};
+
+/* Set while the thread is running tasks, batches submitted from inside a task run serially. */
+static NV_THREAD_LOCAL bool in_task = false;
+
+size_t
+nv_hardware_concurrency(void)
+{
+#if !defined(NV_THREAD_POOL_SERIAL) && defined(_SC_NPROCESSORS_ONLN)
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  if (n > 0) { return (size_t)n; }
+#endif
+  return 1;
+}
+
+static void
+run_serial(size_t count, nv_task_fn fn, void* user_data)
+{
+  for (size_t i = 0; i < count; i++) { fn(user_data, i); }
+}
+
+#ifndef NV_THREAD_POOL_SERIAL
+
+static void
+run_tasks(nv_thread_pool_t* pool)
+{
+  const bool was_in_task = in_task;
+  in_task                = true;
+  for (;;)
+  {
+    size_t i = nv_atomic_add(&pool->next, 1);
+    if (i >= pool->count) { break; }
+    pool->fn(pool->user_data, i);
+  }
+  in_task = was_in_task;
+}
+
+static void*
+worker_main(void* arg)
+{
+  nv_thread_pool_t* pool = (nv_thread_pool_t*)arg;
+  size_t            seen = 0;
+
+  pthread_mutex_lock(&pool->lock);
+  for (;;)
+  {
+    while (!pool->stop && pool->generation == seen) { pthread_cond_wait(&pool->wake, &pool->lock); }
+    if (pool->stop) { break; }
+
+    seen = pool->generation;
+    pthread_mutex_unlock(&pool->lock);
+
+    run_tasks(pool);
+
+    pthread_mutex_lock(&pool->lock);
+    if (--pool->active == 0) { pthread_cond_signal(&pool->finished); }
+  }
+  pthread_mutex_unlock(&pool->lock);
+
+  return NULL;
+}
+
+#endif
+
+nv_error
+nv_thread_pool_create(size_t num_threads, nv_thread_pool_t** pool)
+{
+  nv_assert_else_return(pool != NULL, NV_ERROR_INVALID_ARG);
+
+  if (num_threads == 0) { num_threads = nv_hardware_concurrency(); }
+
+  nv_thread_pool_t* p = (nv_thread_pool_t*)nv_zmalloc(sizeof(nv_thread_pool_t));
+  if (!p) { return NV_ERROR_MALLOC_FAILED; }
+
+#ifdef NV_THREAD_POOL_SERIAL
+  (void)num_threads;
+  p->num_workers = 0;
+#else
+  pthread_mutex_init(&p->run_lock, NULL);
+  pthread_mutex_init(&p->lock, NULL);
+  pthread_cond_init(&p->wake, NULL);
+  pthread_cond_init(&p->finished, NULL);
+
+  // the thread calling run() is one of the threads.
+  const size_t num_workers = num_threads - 1;
+  if (num_workers > 0)
+  {
+    p->workers = (pthread_t*)nv_zmalloc(num_workers * sizeof(pthread_t));
+    if (!p->workers)
+    {
+      nv_thread_pool_destroy(p);
+      return NV_ERROR_MALLOC_FAILED;
+    }
+  }
+
+  for (size_t i = 0; i < num_workers; i++)
+  {
+    if (pthread_create(&p->workers[i], NULL, worker_main, p) != 0)
+    {
+      // keep the workers that did start, a smaller pool is still a pool.
+      nv_log_warning("failed to start thread pool worker %zu of %zu\n", i + 1, num_workers);
+      break;
+    }
+    p->num_workers++;
+  }
+#endif
+
+  *pool = p;
+  return NV_SUCCESS;
+}
+
+void
+nv_thread_pool_destroy(nv_thread_pool_t* pool)
+{
+  if (!pool) { return; }
+
+#ifndef NV_THREAD_POOL_SERIAL
+  pthread_mutex_lock(&pool->lock);
+  pool->stop = true;
+  pthread_cond_broadcast(&pool->wake);
+  pthread_mutex_unlock(&pool->lock);
+
+  for (size_t i = 0; i < pool->num_workers; i++) { pthread_join(pool->workers[i], NULL); }
+  if (pool->workers) { nv_free(pool->workers); }
+
+  pthread_cond_destroy(&pool->finished);
+  pthread_cond_destroy(&pool->wake);
+  pthread_mutex_destroy(&pool->lock);
+  pthread_mutex_destroy(&pool->run_lock);
+#endif
+
+  nv_free(pool);
+}
+
+#ifndef NV_THREAD_POOL_SERIAL
+static pthread_once_t    default_pool_once = PTHREAD_ONCE_INIT;
+static nv_thread_pool_t* default_pool      = NULL;
+
+static void
+create_default_pool(void)
+{
+  if (nv_thread_pool_create(0, &default_pool) != NV_SUCCESS) { default_pool = NULL; }
+}
+#endif
+
+nv_thread_pool_t*
+nv_thread_pool_default(void)
+{
+#ifdef NV_THREAD_POOL_SERIAL
+  return NULL;
+#else
+  pthread_once(&default_pool_once, create_default_pool);
+  return default_pool;
+#endif
+}
+
+size_t
+nv_thread_pool_size(const nv_thread_pool_t* pool)
+{
+  return pool ? pool->num_workers + 1 : 1;
+}
+
+void
+nv_thread_pool_run(nv_thread_pool_t* pool, size_t count, nv_task_fn fn, void* user_data)
+{
+  nv_assert_else_return(fn != NULL, );
+
+  if (count == 0) { return; }
+
+#ifndef NV_THREAD_POOL_SERIAL
+  if (pool && pool->num_workers > 0 && count > 1 && !in_task)
+  {
+    pthread_mutex_lock(&pool->run_lock);
+
+    pthread_mutex_lock(&pool->lock);
+    pool->fn        = fn;
+    pool->user_data = user_data;
+    pool->count     = count;
+    nv_atomic_store(&pool->next, 0);
+    pool->active = pool->num_workers;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    run_tasks(pool);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->active > 0) { pthread_cond_wait(&pool->finished, &pool->lock); }
+    pthread_mutex_unlock(&pool->lock);
+
+    pthread_mutex_unlock(&pool->run_lock);
+    return;
+  }
+#else
+  (void)pool;
+#endif
+
+  run_serial(count, fn, user_data);
+}
@@ -0,0 +1,92 @@
+#include "../include/containers/list.h"
+#include "../include/containers/sorted.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CHECK(cond)                                                                                                                                                           \
+  do                                                                                                                                                                          \
+  {                                                                                                                                                                           \
+    if (!(cond))                                                                                                                                                              \
+    {                                                                                                                                                                         \
+      fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);                                                                                                \
+      exit(1);                                                                                                                                                                \
+    }                                                                                                                                                                         \
+  } while (0)
+
+static int
+compare_u32(const void* a, const void* b, size_t size, void* user_data)
+{
+  (void)size;
+  (void)user_data;
+  const u32 x = *(const u32*)a, y = *(const u32*)b;
+  return (x > y) - (x < y);
+}
+
+static void
+fill(nv_list_t* list, u32 first, u32 count, u32 step)
+{
+  for (u32 i = 0; i < count; i++)
+  {
+    const u32 v = first + (i * step);
+    nv_list_push_back(list, &v);
+  }
+}
+
+/* An empty input must give an empty output, even if 'out' is reused and already has room. */
+static void
+test_intersect_empty(void)
+{
+  nv_list_t empty, full, out;
+  nv_list_init(sizeof(u32), 1, &empty);
+  nv_list_init(sizeof(u32), 16, &full);
+  nv_list_init(sizeof(u32), 64, &out);
+  fill(&full, 0, 16, 1);
+  fill(&out, 100, 8, 1);
+
+  CHECK(nv_list_intersect(&empty, &full, (nv_compare_fn)compare_u32, NULL, &out) == NV_ERROR_SUCCESS);
+  CHECK(nv_list_size(&out) == 0);
+  CHECK(nv_list_intersect(&full, &empty, (nv_compare_fn)compare_u32, NULL, &out) == NV_ERROR_SUCCESS);
+  CHECK(nv_list_size(&out) == 0);
+
+  fill(&out, 100, 8, 1);
+  CHECK(nv_list_intersect_u32(&empty, &full, &out) == NV_ERROR_SUCCESS);
+  CHECK(nv_list_size(&out) == 0);
+  CHECK(nv_list_intersect_u32(&full, &empty, &out) == NV_ERROR_SUCCESS);
+  CHECK(nv_list_size(&out) == 0);
+
+  nv_list_destroy(&empty);
+  nv_list_destroy(&full);
+  nv_list_destroy(&out);
+}
+
+/* A reused output list must only hold the intersection afterwards. */
+static void
+test_intersect_reused_out(void)
+{
+  nv_list_t a, b, out;
+  nv_list_init(sizeof(u32), 64, &a);
+  nv_list_init(sizeof(u32), 64, &b);
+  nv_list_init(sizeof(u32), 64, &out);
+  fill(&a, 0, 64, 2); // evens below 128
+  fill(&b, 0, 43, 3); // multiples of 3 below 129
+
+  for (int pass = 0; pass < 2; pass++)
+  {
+    CHECK((pass ? nv_list_intersect_u32(&a, &b, &out) : nv_list_intersect(&a, &b, (nv_compare_fn)compare_u32, NULL, &out)) == NV_ERROR_SUCCESS);
+    CHECK(nv_list_size(&out) == 22); // multiples of 6 below 128
+    for (size_t i = 0; i < nv_list_size(&out); i++) { CHECK(*(const u32*)nv_list_get(&out, i) == i * 6); }
+  }
+
+  nv_list_destroy(&a);
+  nv_list_destroy(&b);
+  nv_list_destroy(&out);
+}
+
+int
+main(void)
+{
+  test_intersect_empty();
+  test_intersect_reused_out();
+  return 0;
+}